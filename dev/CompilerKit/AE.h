@@ -11,8 +11,17 @@
 #define _NECTI_AE_H_
 
 #include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 
-#define kAEVer (0x0120)
+#define kAEVer1 (0x0120) /* records carry their name, see AERecordHeader. */
+#define kAEVer (0x0210)  /* records name a string and a byte range of a section, see AERecord. */
 
 #define kAEMag0 'O'
 #define kAEMag1 'B'
@@ -22,6 +31,13 @@
 #define kAEMagLen (2)
 #define kAENullType (0x00)
 
+/// @brief Section of a record that holds no bytes, e.g an undefined symbol.
+#define kAENoSection (0xFFFFFFFFU)
+
+/// @brief AESection flag, its records only reach each other through relocations, so a linker may
+/// move them apart from one record start to the next.
+#define kAESectionSplit (0x1U)
+
 /// @author Amlal El Mahrouss
 
 /// @brief
@@ -42,9 +58,22 @@ typedef struct AEHeader final {
   Char     fSize{};
   SizeType fStartCode{};
   SizeType fCodeSize{};
-  Char     fPad[kAEPad] = {};
+  UInt32   fRelocCount{}; /* AERelocation entries, 0 when the object has no fixups. */
+  UInt32   fRelocStart{}; /* file offset of the relocation table, it follows the code. */
+  UInt32   fStringStart{}; /* v2: file offset of the string table, it follows the sections. */
+  UInt32   fStringSize{};
+  UInt32   fSectionStart{}; /* v2: file offset of the section table, it follows the records. */
+  UInt32   fSectionCount{};
 } PACKED AEHeader, *AEHeaderPtr;
 
+/// @brief Header size of a v1 object, its records follow right after fRelocStart.
+inline constexpr SizeType kAEHeaderV1Size = offsetof(AEHeader, fStringStart);
+
+static_assert(sizeof(AEHeader) <= 0xFF, "AEHeader::fSize is one byte.");
+
+/// @brief Header size as stored, fSize is a Char and is read unsigned.
+inline SizeType ae_header_size(const AEHeader* hdr) { return static_cast<UInt8>(hdr->fSize); }
+
 // @brief Advanced Executable Record.
 // Could be data, code or bss.
 // fKind must be filled with PEF fields.
@@ -58,10 +87,67 @@ typedef struct AERecordHeader final {
   Char     fPad[kAEPad];
 } PACKED AERecordHeader, *AERecordHeaderPtr;
 
+// @brief Advanced Executable Record, v2.
+// The name lives in the string table, stored once per object, and the bytes are a range of one
+// section: fOffset is where they start inside it and fSize how many there are.
+
+typedef struct AERecord final {
+  UInt32  fName; /* offset of the name inside the string table. */
+  UInt32  fNameLen;
+  UInt32  fKind;
+  UInt32  fFlags;
+  UInt32  fSection; /* index in the section table, or kAENoSection. */
+  UInt32  fPad;
+  UInt64  fSize;
+  UIntPtr fOffset; /* inside the section, or inside the code without one. */
+} PACKED AERecord, *AERecordPtr;
+
+// @brief Advanced Executable Section, v2.
+// A run of the code holding records of one kind, an object has as many as it switches kinds.
+
+typedef struct AESection final {
+  UInt32 fKind; /* kPefCode, kPefData or kPefZero. */
+  UInt32 fFlags;
+  UInt64 fOffset; /* start inside the object's code. */
+  UInt64 fSize;
+} PACKED AESection, *AESectionPtr;
+
+/// @brief Record of either version, as readers see it.
+/// @note fOffset and fSize are the record's bytes inside the code, v1 records only carry where
+/// they end, so they start where the previous one ended.
+struct AERecordView final {
+  std::string_view fName;
+  SizeType         fKind;
+  SizeType         fSize;
+  SizeType         fFlags;
+  UIntPtr          fOffset;
+  UInt32           fSection{kAENoSection};
+};
+
 enum {
   kKindRelocationByOffset  = 0x23f,
   kKindRelocationAtRuntime = 0x34f,
 };
+
+/// @brief What a fixup writes at its place, S being the target, A the addend and P the place.
+enum {
+  kAERelocInvalid = 0,
+  kAERelocAbs64,  /* S + A, 64-bit. */
+  kAERelocAbs32,  /* S + A, 32-bit. */
+  kAERelocRel32,  /* S + A - P, 32-bit signed. */
+  kAERelocCount,
+};
+
+// @brief Advanced Executable Relocation.
+// A fixup inside the object's code, against the symbol a record defines or references.
+
+typedef struct AERelocation final {
+  UInt64 fOffset; /* place, offset inside the object's code. */
+  UInt32 fRecord; /* index of the record naming the target. */
+  UInt16 fKind;   /* kAEReloc* */
+  UInt16 fFlags;  /* kKindRelocation* */
+  Int64  fAddend;
+} PACKED AERelocation, *AERelocationPtr;
 }  // namespace CompilerKit
 
 // provide operator<< for AE
@@ -89,6 +175,75 @@ inline std::ifstream& operator>>(std::ifstream& fp, CompilerKit::AERecordHeader&
 }
 
 namespace CompilerKit::Utils {
+/**
+ * @brief Write an object's records in the v2 layout, the compact records, the section table then
+ * the string table, each name stored once.
+ *
+ * @param fp the object, right past its header.
+ * @param hdr the object's header, its table fields are set here, to be written again.
+ * @param records the records, as the assemblers build them: fOffset and fSize are their bytes
+ * inside the code, in order. A section starts wherever the kind changes.
+ * @param section_flags flags of every section, kAESectionSplit when the code is position
+ * independent besides its relocations.
+ */
+inline void ae_write_records(std::ofstream& fp, AEHeader& hdr,
+                             std::span<const AERecordHeader> records,
+                             UInt32                          section_flags = 0U) {
+  std::vector<AERecord>                        compact(records.size());
+  std::vector<AESection>                       sections;
+  std::unordered_map<std::string_view, UInt32> offsets;
+  std::string                                  strings;
+
+  for (SizeType index = 0UL; index < records.size(); ++index) {
+    auto&            record = records[index];
+    std::string_view name(record.fName, strnlen(record.fName, kAESymbolLen));
+
+    auto [slot, inserted] = offsets.try_emplace(name, UInt32(strings.size()));
+
+    if (inserted) strings += name;
+
+    compact[index] = {.fName    = slot->second,
+                      .fNameLen = UInt32(name.size()),
+                      .fKind    = UInt32(record.fKind),
+                      .fFlags   = UInt32(record.fFlags),
+                      .fSection = kAENoSection,
+                      .fPad     = 0U,
+                      .fSize    = record.fSize,
+                      .fOffset  = record.fOffset};
+
+    // records without bytes keep their place inside the code, they don't split a section.
+    if (record.fKind == kAENullType || record.fSize == 0) continue;
+
+    if (sections.empty() || sections.back().fKind != record.fKind ||
+        sections.back().fOffset + sections.back().fSize != record.fOffset)
+      sections.push_back({.fKind   = UInt32(record.fKind),
+                          .fFlags  = section_flags,
+                          .fOffset = record.fOffset,
+                          .fSize   = 0UL});
+
+    sections.back().fSize = record.fOffset + record.fSize - sections.back().fOffset;
+
+    compact[index].fSection = UInt32(sections.size() - 1);
+    compact[index].fOffset  = record.fOffset - sections.back().fOffset;
+  }
+
+  fp.write(reinterpret_cast<const char*>(compact.data()),
+           std::streamsize(compact.size() * sizeof(AERecord)));
+
+  hdr.fVersion      = kAEVer;
+  hdr.fSize         = sizeof(AEHeader);
+  hdr.fSectionStart = UInt32(fp.tellp());
+  hdr.fSectionCount = UInt32(sections.size());
+
+  fp.write(reinterpret_cast<const char*>(sections.data()),
+           std::streamsize(sections.size() * sizeof(AESection)));
+
+  hdr.fStringStart = UInt32(fp.tellp());
+  hdr.fStringSize  = UInt32(strings.size());
+
+  fp.write(strings.data(), std::streamsize(strings.size()));
+}
+
 /**
  * @brief AE Reader protocol
  *
@@ -131,6 +286,280 @@ class AEReadableProtocol final {
     return reinterpret_cast<TypeClass*>(raw);
   }
 };
+
+/// @brief Records of a mapped AE object, of either version.
+class AERecordRange final {
+ public:
+  class Iterator final {
+   public:
+    Iterator(const AERecordRange* range, SizeType index) : fRange(range), fIndex(index) {}
+
+    AERecordView operator*() const { return (*fRange)[fIndex]; }
+
+    Iterator& operator++() {
+      ++fIndex;
+      return *this;
+    }
+
+    Bool operator!=(const Iterator& other) const { return fIndex != other.fIndex; }
+
+   private:
+    const AERecordRange* fRange;
+    SizeType             fIndex;
+  };
+
+  explicit AERecordRange() = default;
+  explicit AERecordRange(const Char* map) : fMap(map) {}
+
+  SizeType size() const {
+    return fMap ? reinterpret_cast<const AEHeader*>(fMap)->fCount : 0UL;
+  }
+
+  Bool empty() const { return this->size() == 0; }
+
+  AERecordView operator[](SizeType index) const {
+    auto hdr = reinterpret_cast<const AEHeader*>(fMap);
+
+    if (hdr->fVersion == kAEVer1) {
+      auto records = reinterpret_cast<const AERecordHeader*>(fMap + ae_header_size(hdr));
+      auto& record = records[index];
+
+      std::string_view name(record.fName, strnlen(record.fName, kAESymbolLen));
+
+      // v1 fSize is where the record ends, undefined ones store their name length there.
+      if (record.fKind == kAENullType) return {name, record.fKind, 0UL, record.fFlags, 0UL};
+
+      SizeType start = index > 0 ? records[index - 1].fSize : 0UL;
+
+      return {name, record.fKind, record.fSize > start ? record.fSize - start : 0UL,
+              record.fFlags, start};
+    }
+
+    auto& record = reinterpret_cast<const AERecord*>(fMap + ae_header_size(hdr))[index];
+    auto  start  = record.fOffset;
+
+    if (record.fSection != kAENoSection)
+      start += reinterpret_cast<const AESection*>(fMap + hdr->fSectionStart)[record.fSection]
+                   .fOffset;
+
+    return {std::string_view(fMap + hdr->fStringStart + record.fName, record.fNameLen),
+            record.fKind,
+            record.fSize,
+            record.fFlags,
+            start,
+            record.fSection};
+  }
+
+  Iterator begin() const { return {this, 0UL}; }
+  Iterator end() const { return {this, this->size()}; }
+
+ private:
+  const Char* fMap{nullptr};
+};
+
+/**
+ * @brief AE mapped object, read-only view of an AE object file.
+ * @note Records and code are handed out straight from the mapping, nothing is copied. Both
+ * versions are read, v1 records carry their name, v2 ones point into the string table and into
+ * a section of the code.
+ */
+class AEMappedObject final {
+ public:
+  explicit AEMappedObject() = default;
+  ~AEMappedObject() { this->Close(); }
+
+  NECTI_COPY_DELETE(AEMappedObject);
+
+  AEMappedObject(AEMappedObject&& other) noexcept
+      : fMap(std::exchange(other.fMap, nullptr)),
+        fSize(std::exchange(other.fSize, 0UL)),
+        fOwned(std::exchange(other.fOwned, false)) {}
+
+  AEMappedObject& operator=(AEMappedObject&& other) noexcept {
+    if (this != &other) {
+      this->Close();
+
+      fMap   = std::exchange(other.fMap, nullptr);
+      fSize  = std::exchange(other.fSize, 0UL);
+      fOwned = std::exchange(other.fOwned, false);
+    }
+
+    return *this;
+  }
+
+  /**
+   * @brief Map an object and validate its header, records and code ranges.
+   *
+   * @param path the object path.
+   * @return NECTI_SUCCESS, NECTI_FILE_NOT_FOUND or NECTI_INVALID_DATA.
+   */
+  Int32 Open(const Char* path) {
+    this->Close();
+
+    Int32 fd = ::open(path, O_RDONLY);
+
+    if (fd < 0) return NECTI_FILE_NOT_FOUND;
+
+    struct stat st{};
+
+    if (::fstat(fd, &st) != 0 || st.st_size < Int64(kAEHeaderV1Size)) {
+      ::close(fd);
+      return NECTI_INVALID_DATA;
+    }
+
+    VoidPtr map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) return NECTI_FILE_NOT_FOUND;
+
+    fMap   = static_cast<const Char*>(map);
+    fSize  = st.st_size;
+    fOwned = true;
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    ::madvise(map, fSize, MADV_SEQUENTIAL);
+
+    return NECTI_SUCCESS;
+  }
+
+  /**
+   * @brief View an object held by someone else, e.g an archive member, and validate it.
+   *
+   * @param bytes the object bytes, they must outlive this view.
+   * @return NECTI_SUCCESS or NECTI_INVALID_DATA.
+   */
+  Int32 Open(std::span<const Char> bytes) {
+    this->Close();
+
+    if (bytes.size() < kAEHeaderV1Size) return NECTI_INVALID_DATA;
+
+    fMap  = bytes.data();
+    fSize = bytes.size();
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  void Close() {
+    if (fMap && fOwned) ::munmap(const_cast<Char*>(fMap), fSize);
+
+    fMap   = nullptr;
+    fSize  = 0UL;
+    fOwned = false;
+  }
+
+  /// @brief Drop the pages read so far, the ones touched again are read back from the file.
+  void Release() const {
+    if (fMap && fOwned) ::madvise(const_cast<Char*>(fMap), fSize, MADV_DONTNEED);
+  }
+
+  const AEHeader* Header() const { return reinterpret_cast<const AEHeader*>(fMap); }
+
+  AERecordRange Records() const { return AERecordRange(fMap); }
+
+  std::span<const Char> Code() const {
+    if (!fMap) return {};
+
+    return {fMap + this->Header()->fStartCode, this->Header()->fCodeSize};
+  }
+
+  /// @brief Sections of the code, v1 objects have none.
+  std::span<const AESection> Sections() const {
+    if (!fMap || this->Header()->fVersion == kAEVer1) return {};
+
+    return {reinterpret_cast<const AESection*>(fMap + this->Header()->fSectionStart),
+            this->Header()->fSectionCount};
+  }
+
+  std::span<const AERelocation> Relocations() const {
+    if (!fMap || this->Header()->fRelocCount == 0) return {};
+
+    return {reinterpret_cast<const AERelocation*>(fMap + this->Header()->fRelocStart),
+            this->Header()->fRelocCount};
+  }
+
+  /// @brief Whole object, as mapped.
+  std::span<const Char> Bytes() const { return {fMap, fSize}; }
+
+  SizeType Size() const { return fSize; }
+
+  operator bool() const { return fMap; }
+
+ private:
+  Bool Validate() const {
+    auto hdr = this->Header();
+
+    if (hdr->fMagic[0] != kAEMag0 || hdr->fMagic[1] != kAEMag1) return false;
+
+    Bool v1 = hdr->fVersion == kAEVer1;
+
+    if (!v1 && hdr->fVersion != kAEVer) return false;
+
+    if (ae_header_size(hdr) != (v1 ? kAEHeaderV1Size : sizeof(AEHeader)) ||
+        ae_header_size(hdr) > fSize)
+      return false;
+
+    SizeType room = (fSize - ae_header_size(hdr)) / (v1 ? sizeof(AERecordHeader) : sizeof(AERecord));
+
+    if (hdr->fCount > room) return false;
+
+    if (hdr->fStartCode > fSize || hdr->fCodeSize > fSize - hdr->fStartCode) return false;
+
+    // every name must be inside the string table, every section inside the code and every
+    // record inside its section.
+    if (!v1) {
+      if (hdr->fStringStart > fSize || hdr->fStringSize > fSize - hdr->fStringStart) return false;
+
+      if (hdr->fSectionStart > fSize ||
+          hdr->fSectionCount > (fSize - hdr->fSectionStart) / sizeof(AESection))
+        return false;
+
+      auto sections = reinterpret_cast<const AESection*>(fMap + hdr->fSectionStart);
+
+      for (SizeType index = 0UL; index < hdr->fSectionCount; ++index) {
+        if (sections[index].fOffset > hdr->fCodeSize ||
+            sections[index].fSize > hdr->fCodeSize - sections[index].fOffset)
+          return false;
+      }
+
+      auto records = reinterpret_cast<const AERecord*>(fMap + ae_header_size(hdr));
+
+      for (SizeType index = 0UL; index < hdr->fCount; ++index) {
+        auto& record = records[index];
+
+        if (SizeType(record.fName) + record.fNameLen > hdr->fStringSize) return false;
+
+        SizeType room = hdr->fCodeSize;
+
+        if (record.fSection != kAENoSection) {
+          if (record.fSection >= hdr->fSectionCount) return false;
+
+          room = sections[record.fSection].fSize;
+        }
+
+        if (record.fOffset > room || record.fSize > room - record.fOffset) return false;
+      }
+    }
+
+    if (hdr->fRelocCount == 0) return true;
+
+    return hdr->fRelocStart <= fSize &&
+           hdr->fRelocCount <= (fSize - hdr->fRelocStart) / sizeof(AERelocation);
+  }
+
+ private:
+  const Char* fMap{nullptr};
+  SizeType    fSize{0UL};
+  Bool        fOwned{false};
+};
 }  // namespace CompilerKit::Utils
 
 #endif /* ifndef _NECTI_AE_H_ */
\ No newline at end of file
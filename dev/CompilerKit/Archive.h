@@ -0,0 +1,268 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/PEF.h>
+#include <CompilerKit/utils/SymbolTable.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <span>
+
+/// @file Archive.h
+/// @brief Static library (.lib), AE objects behind a hashed symbol directory.
+/// @note Layout: LibHeader, the symbol directory, the member table, the string table, then the
+/// members themselves, each aligned to kLibAlign. Members are addressed by their content hash, an
+/// object added twice is stored once.
+
+#define kLibMagic "NeLb"
+#define kLibMagicLen (4)
+#define kLibVersion (0x0100)
+#define kLibAlign (16U)
+
+/// @brief Symbol directory slot of an empty entry.
+#define kLibNoMember (0xFFFFFFFFU)
+
+namespace CompilerKit {
+/// @brief Static library header.
+typedef struct LibHeader final {
+  Char     fMagic[kLibMagicLen];
+  UInt32   fVersion;
+  UInt64   fMemberCount;
+  UInt64   fSlotCount;   /* symbol directory slots, a power of two. */
+  SizeType fSlots;       /* file offset of the symbol directory. */
+  SizeType fMembers;     /* file offset of the member table. */
+  SizeType fStrings;     /* file offset of the string table. */
+  SizeType fStringSize;  /* string table size. */
+} PACKED LibHeader, *LibHeaderPtr;
+
+/// @brief Archive member, one AE object.
+typedef struct LibMember final {
+  UInt64   fHash;    /* content hash of the object. */
+  SizeType fOffset;  /* file offset of the object. */
+  SizeType fSize;    /* object size. */
+  UInt32   fName;    /* name offset inside the string table. */
+  UInt32   fNameLen;
+} PACKED LibMember, *LibMemberPtr;
+
+/// @brief Symbol directory slot, open addressing over symbol_hash of the demangled name.
+typedef struct LibSymbol final {
+  UInt64 fHash;
+  UInt32 fName;  /* name offset inside the string table. */
+  UInt32 fNameLen;
+  UInt32 fMember; /* defining member, or kLibNoMember for an empty slot. */
+  UInt32 fPad;
+} PACKED LibSymbol, *LibSymbolPtr;
+}  // namespace CompilerKit
+
+namespace CompilerKit::Utils {
+/**
+ * @brief Mapped static library, symbol lookups go through the directory, never through the
+ * members.
+ */
+class LibMappedArchive final {
+ public:
+  explicit LibMappedArchive() = default;
+  ~LibMappedArchive() { this->Close(); }
+
+  NECTI_COPY_DELETE(LibMappedArchive);
+
+  LibMappedArchive(LibMappedArchive&& other) noexcept
+      : fMap(std::exchange(other.fMap, nullptr)),
+        fSize(std::exchange(other.fSize, 0UL)),
+        fOwned(std::exchange(other.fOwned, false)) {}
+
+  LibMappedArchive& operator=(LibMappedArchive&& other) noexcept {
+    if (this != &other) {
+      this->Close();
+
+      fMap   = std::exchange(other.fMap, nullptr);
+      fSize  = std::exchange(other.fSize, 0UL);
+      fOwned = std::exchange(other.fOwned, false);
+    }
+
+    return *this;
+  }
+
+  /**
+   * @brief Map a library and validate its tables.
+   *
+   * @param path the library path.
+   * @return NECTI_SUCCESS, NECTI_FILE_NOT_FOUND or NECTI_INVALID_DATA.
+   */
+  Int32 Open(const Char* path) {
+    this->Close();
+
+    Int32 fd = ::open(path, O_RDONLY);
+
+    if (fd < 0) return NECTI_FILE_NOT_FOUND;
+
+    struct stat st{};
+
+    if (::fstat(fd, &st) != 0 || st.st_size < Int64(sizeof(LibHeader))) {
+      ::close(fd);
+      return NECTI_INVALID_DATA;
+    }
+
+    VoidPtr map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) return NECTI_FILE_NOT_FOUND;
+
+    fMap   = static_cast<const Char*>(map);
+    fSize  = st.st_size;
+    fOwned = true;
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  /**
+   * @brief View a library held by someone else, and validate its tables.
+   *
+   * @param bytes the library bytes, they must outlive this view.
+   * @return NECTI_SUCCESS or NECTI_INVALID_DATA.
+   */
+  Int32 Open(std::span<const Char> bytes) {
+    this->Close();
+
+    if (bytes.size() < sizeof(LibHeader)) return NECTI_INVALID_DATA;
+
+    fMap  = bytes.data();
+    fSize = bytes.size();
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  void Close() {
+    if (fMap && fOwned) ::munmap(const_cast<Char*>(fMap), fSize);
+
+    fMap   = nullptr;
+    fSize  = 0UL;
+    fOwned = false;
+  }
+
+  /// @brief Drop the pages read so far, the ones touched again are read back from the file.
+  void Release() const {
+    if (fMap && fOwned) ::madvise(const_cast<Char*>(fMap), fSize, MADV_DONTNEED);
+  }
+
+  const LibHeader* Header() const { return reinterpret_cast<const LibHeader*>(fMap); }
+
+  std::span<const LibMember> Members() const {
+    if (!fMap) return {};
+
+    return {reinterpret_cast<const LibMember*>(fMap + this->Header()->fMembers),
+            this->Header()->fMemberCount};
+  }
+
+  std::span<const LibSymbol> Symbols() const {
+    if (!fMap) return {};
+
+    return {reinterpret_cast<const LibSymbol*>(fMap + this->Header()->fSlots),
+            this->Header()->fSlotCount};
+  }
+
+  /// @brief Member defining a demangled symbol name.
+  /// @return the member index, or kLibNoMember.
+  UInt32 Find(std::string_view name) const {
+    auto slots = this->Symbols();
+
+    if (slots.empty()) return kLibNoMember;
+
+    auto     hash = symbol_hash(name);
+    SizeType mask = slots.size() - 1;
+
+    for (SizeType slot = hash & mask; slots[slot].fMember != kLibNoMember;
+         slot = (slot + 1) & mask) {
+      auto& entry = slots[slot];
+
+      if (entry.fHash == hash && this->String(entry.fName, entry.fNameLen) == name)
+        return entry.fMember;
+    }
+
+    return kLibNoMember;
+  }
+
+  std::string_view MemberName(UInt32 member) const {
+    return this->String(this->Members()[member].fName, this->Members()[member].fNameLen);
+  }
+
+  std::string_view SymbolName(const LibSymbol& slot) const {
+    return this->String(slot.fName, slot.fNameLen);
+  }
+
+  std::span<const Char> MemberBytes(UInt32 member) const {
+    return {fMap + this->Members()[member].fOffset, this->Members()[member].fSize};
+  }
+
+  operator bool() const { return fMap; }
+
+ private:
+  std::string_view String(UInt32 offset, UInt32 len) const {
+    return {fMap + this->Header()->fStrings + offset, len};
+  }
+
+  Bool Validate() const {
+    auto hdr = this->Header();
+
+    if (std::memcmp(hdr->fMagic, kLibMagic, kLibMagicLen) != 0 || hdr->fVersion != kLibVersion)
+      return false;
+
+    // the directory is probed until an empty slot, so it must be a power of two with room left.
+    if (hdr->fSlotCount == 0 || (hdr->fSlotCount & (hdr->fSlotCount - 1)) != 0) return false;
+
+    auto fits = [&](SizeType offset, SizeType count, SizeType size) {
+      return offset <= fSize && count <= (fSize - offset) / size;
+    };
+
+    if (!fits(hdr->fSlots, hdr->fSlotCount, sizeof(LibSymbol)) ||
+        !fits(hdr->fMembers, hdr->fMemberCount, sizeof(LibMember)) ||
+        !fits(hdr->fStrings, hdr->fStringSize, 1))
+      return false;
+
+    Bool has_empty = false;
+
+    for (auto& slot : this->Symbols()) {
+      if (slot.fMember == kLibNoMember) {
+        has_empty = true;
+        continue;
+      }
+
+      if (slot.fMember >= hdr->fMemberCount ||
+          SizeType(slot.fName) + slot.fNameLen > hdr->fStringSize)
+        return false;
+    }
+
+    if (!has_empty) return false;
+
+    for (auto& member : this->Members()) {
+      if (!fits(member.fOffset, member.fSize, 1) ||
+          SizeType(member.fName) + member.fNameLen > hdr->fStringSize)
+        return false;
+    }
+
+    return true;
+  }
+
+ private:
+  const Char* fMap{nullptr};
+  SizeType    fSize{0UL};
+  Bool        fOwned{false};
+};
+}  // namespace CompilerKit::Utils
@@ -0,0 +1,222 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/PEF.h>
+#include <span>
+#include <string_view>
+
+/// @file Exports.h
+/// @brief Export table of PEF dylibs, a GNU-hash style index over the exported symbols.
+/// @note Layout: ExportHeader, the bloom filter, the buckets, the chains, the symbols, then the
+/// string table. Symbols are grouped by bucket, a chain entry is the symbol's hash with its low bit
+/// set on the last symbol of a bucket. A lookup checks the bloom filter first, so most misses never
+/// touch a bucket.
+
+#define kExportsMagic "NeEx"
+#define kExportsMagicLen (4)
+#define kExportsVersion (0x0100)
+
+/// @brief Bucket of an empty chain.
+#define kExportsNoSymbol (0xFFFFFFFFU)
+
+/// @brief Second bloom bit, taken from the hash shifted by this much.
+#define kExportsBloomShift (6U)
+
+namespace CompilerKit {
+/// @brief Export table header, offsets are relative to the start of the table.
+typedef struct ExportHeader final {
+  Char   fMagic[kExportsMagicLen];
+  UInt32 fVersion;
+  UInt32 fSymbolCount;
+  UInt32 fBucketCount;
+  UInt32 fBloomCount; /* 64-bit bloom words, a power of two. */
+  UInt32 fBloomShift;
+  UInt32 fBloom;      /* offset of the bloom filter. */
+  UInt32 fBuckets;    /* offset of the buckets, first symbol of each. */
+  UInt32 fChains;     /* offset of the chains, one per symbol. */
+  UInt32 fSymbols;    /* offset of the symbols. */
+  UInt32 fStrings;    /* offset of the string table. */
+  UInt32 fStringSize; /* string table size. */
+} PACKED ExportHeader, *ExportHeaderPtr;
+
+/// @brief Exported symbol, where it lands once the dylib is mapped at kPefBaseOrigin.
+typedef struct ExportSymbol final {
+  UInt32  fName; /* name offset inside the string table, the plain symbol: foo for .code64$foo. */
+  UInt32  fNameLen;
+  UInt32  fHeader; /* command header defining the symbol. */
+  UInt32  fPad;
+  UIntPtr fOffset; /* file offset of the symbol. */
+  UIntPtr fVirtualAddress;
+} PACKED ExportSymbol, *ExportSymbolPtr;
+
+/// @brief GNU hash (DJB) of a demangled symbol name.
+inline UInt32 export_hash(std::string_view name) noexcept {
+  UInt32 hash = 5381U;
+
+  for (auto ch : name) hash = hash * 33U + static_cast<UInt8>(ch);
+
+  return hash;
+}
+}  // namespace CompilerKit
+
+namespace CompilerKit::Utils {
+/**
+ * @brief Export table of a mapped dylib, symbols are bound with a hash lookup instead of a scan
+ * over the command headers.
+ */
+class ExportTable final {
+ public:
+  explicit ExportTable() = default;
+  ~ExportTable()         = default;
+
+  NECTI_COPY_DEFAULT(ExportTable);
+
+  /**
+   * @brief Use an export table, and validate it.
+   *
+   * @param table the table bytes, they must outlive the lookups.
+   * @return NECTI_SUCCESS or NECTI_INVALID_DATA.
+   */
+  Int32 Open(std::span<const Char> table) {
+    fTable = table;
+
+    if (!this->Validate()) {
+      fTable = {};
+      return NECTI_INVALID_DATA;
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  /**
+   * @brief Find the export table of a PEF image, through its Container:Exports header.
+   *
+   * @param image the whole image, as mapped.
+   * @return NECTI_SUCCESS, NECTI_FILE_NOT_FOUND when it exports nothing, or NECTI_INVALID_DATA.
+   */
+  Int32 OpenImage(std::span<const Char> image) {
+    if (image.size() < sizeof(PEFContainer)) return NECTI_INVALID_DATA;
+
+    SizeType headers = (image.size() - sizeof(PEFContainer)) / sizeof(PEFCommandHeader);
+
+    // the headers run up to Container:Exec:END, the table's header is scanned for once.
+    for (SizeType index = 0UL; index < headers; ++index) {
+      PEFCommandHeader command_hdr;
+      std::memcpy(&command_hdr,
+                  image.data() + sizeof(PEFContainer) + index * sizeof(PEFCommandHeader),
+                  sizeof(PEFCommandHeader));
+
+      if (std::strncmp(command_hdr.Name, kPefEndName, kPefNameLen) == 0) break;
+
+      if (std::strncmp(command_hdr.Name, kPefExportsName, kPefNameLen) != 0) continue;
+
+      if (command_hdr.Offset > image.size() ||
+          command_hdr.VirtualSize > image.size() - command_hdr.Offset)
+        return NECTI_INVALID_DATA;
+
+      return this->Open(image.subspan(command_hdr.Offset, command_hdr.VirtualSize));
+    }
+
+    return NECTI_FILE_NOT_FOUND;
+  }
+
+  const ExportHeader* Header() const {
+    return reinterpret_cast<const ExportHeader*>(fTable.data());
+  }
+
+  std::span<const ExportSymbol> Symbols() const {
+    if (fTable.empty()) return {};
+
+    return {reinterpret_cast<const ExportSymbol*>(fTable.data() + this->Header()->fSymbols),
+            this->Header()->fSymbolCount};
+  }
+
+  std::string_view Name(const ExportSymbol& symbol) const {
+    return {fTable.data() + this->Header()->fStrings + symbol.fName, symbol.fNameLen};
+  }
+
+  /// @brief Exported symbol of a plain name, "foo" finds the .code64$foo record.
+  /// @return the symbol, or nullptr.
+  const ExportSymbol* Find(std::string_view name) const {
+    if (fTable.empty() || this->Header()->fSymbolCount == 0) return nullptr;
+
+    auto hdr  = this->Header();
+    auto hash = export_hash(name);
+
+    // the bloom filter rules most misses out, two bits per symbol.
+    UInt64 word = this->Read<UInt64>(hdr->fBloom, (hash / 64) & (hdr->fBloomCount - 1));
+    UInt64 mask = (1ULL << (hash % 64)) | (1ULL << ((hash >> hdr->fBloomShift) % 64));
+
+    if ((word & mask) != mask) return nullptr;
+
+    UInt32 symbol = this->Read<UInt32>(hdr->fBuckets, hash % hdr->fBucketCount);
+
+    if (symbol == kExportsNoSymbol) return nullptr;
+
+    auto symbols = this->Symbols();
+
+    for (; symbol < hdr->fSymbolCount; ++symbol) {
+      UInt32 chain = this->Read<UInt32>(hdr->fChains, symbol);
+
+      if ((chain | 1U) == (hash | 1U) && this->Name(symbols[symbol]) == name)
+        return &symbols[symbol];
+
+      if (chain & 1U) break;
+    }
+
+    return nullptr;
+  }
+
+  operator bool() const { return !fTable.empty(); }
+
+ private:
+  template <typename T>
+  T Read(UInt32 offset, SizeType index) const {
+    T value;
+    std::memcpy(&value, fTable.data() + offset + index * sizeof(T), sizeof(T));
+
+    return value;
+  }
+
+  Bool Validate() const {
+    if (fTable.size() < sizeof(ExportHeader)) return false;
+
+    auto hdr = this->Header();
+
+    if (std::memcmp(hdr->fMagic, kExportsMagic, kExportsMagicLen) != 0 ||
+        hdr->fVersion != kExportsVersion)
+      return false;
+
+    if (hdr->fBucketCount == 0 || hdr->fBloomCount == 0 ||
+        (hdr->fBloomCount & (hdr->fBloomCount - 1)) != 0 || hdr->fBloomShift >= 32)
+      return false;
+
+    auto fits = [&](SizeType offset, SizeType count, SizeType size) {
+      return offset <= fTable.size() && count <= (fTable.size() - offset) / size;
+    };
+
+    if (!fits(hdr->fBloom, hdr->fBloomCount, sizeof(UInt64)) ||
+        !fits(hdr->fBuckets, hdr->fBucketCount, sizeof(UInt32)) ||
+        !fits(hdr->fChains, hdr->fSymbolCount, sizeof(UInt32)) ||
+        !fits(hdr->fSymbols, hdr->fSymbolCount, sizeof(ExportSymbol)) ||
+        !fits(hdr->fStrings, hdr->fStringSize, 1))
+      return false;
+
+    for (auto& symbol : this->Symbols()) {
+      if (SizeType(symbol.fName) + symbol.fNameLen > hdr->fStringSize) return false;
+    }
+
+    return true;
+  }
+
+ private:
+  std::span<const Char> fTable{};
+};
+}  // namespace CompilerKit::Utils
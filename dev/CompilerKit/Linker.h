@@ -0,0 +1,185 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/AE.h>
+#include <CompilerKit/Archive.h>
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/PEF.h>
+#include <CompilerKit/utils/CompilerUtils.h>
+#include <CompilerKit/utils/ImageWriter.h>
+#include <CompilerKit/utils/LinkState.h>
+#include <CompilerKit/utils/SymbolTable.h>
+#include <span>
+
+/// @file Linker.h
+/// @brief 64-bit PEF linker, as a library. Every link owns its state, so links can run on many
+/// threads of one process. ld64 is a thin command line wrapper around it.
+
+namespace CompilerKit {
+struct LinkerObject;
+
+/* identical code folding modes. */
+enum {
+  kICFNone = 0,
+  kICFSafe, /* skip the symbols whose address may be taken. */
+  kICFAll,
+};
+
+enum {
+  kABITypeNull    = 0,
+  kABITypeStart   = 0x1010, /* The start of ABI list. */
+  kABITypeNE      = 0x5046, /* PF (NeKernel.org's PEF ABI) */
+  kABITypeInvalid = 0xFFFF,
+};
+
+/// @brief Range of an object's code the link lays out, collects and folds as a whole.
+/// @note An object whose sections carry kAESectionSplit has a range per record start, any other
+/// object, or any object of an incremental link, is a single range.
+struct LinkerRange final {
+  SizeType fObject; /* input object. */
+  SizeType fFrom;   /* start inside the object's code. */
+  SizeType fTo;     /* end inside the object's code. */
+};
+
+/// @brief Link-time fixup, from an object's relocation table.
+struct LinkerFixup final {
+  SizeType fObject; /* range holding the place. */
+  SizeType fOffset; /* place, inside the range. */
+  SizeType fHeader; /* header of the record naming the target. */
+  UInt16   fKind;
+  Int64    fAddend;
+  SizeType fTarget{0UL};             /* range defining the target. */
+  SizeType fTargetStart{0UL};        /* target's start inside that range. */
+  SymbolId fRuntime{kSymbolInvalid}; /* left to the loader if set. */
+};
+
+/// @brief Input of a link, an AE object or a static library, on disk or already in memory.
+struct LinkerInput final {
+  STLString             fPath{};         /* path, or the name diagnostics use when in memory. */
+  std::span<const Char> fBytes{};        /* contents when in memory, they must outlive the link. */
+  Bool                  fLibrary{false}; /* searched for undefined symbols, see Archive.h. */
+};
+
+/// @brief Options of a link, ld64 sets one per flag.
+struct LinkerOptions final {
+  std::vector<LinkerInput> fInputs{};
+  STLString                fOutput{"a" kPefExt}; /* empty to keep the image in memory. */
+  STLString                fStart{kPefStart};
+  Int32                    fArch{kPefArchInvalid};
+  Int32                    fSubArch{0};
+  Int32                    fAbi{kABITypeNE};
+  Bool                     fExecutable{true};
+  Bool                     fFatBinary{false}; /* a slice per architecture of the objects. */
+  Bool                     fVerbose{false};
+  SizeType                 fJobs{1UL}; /* workers reading the inputs, 0 for one per core. */
+  Bool                     fIncremental{false};
+  SizeType                 fIncrementalSlack{kLinkStateDefaultSlack};
+  Bool                     fGCSections{false};
+  Int32                    fICFMode{kICFNone};
+  Bool                     fPreallocate{false};
+  Bool                     fStreaming{false}; /* copy the code from the inputs when emitting. */
+  SizeType                 fPageSize{0UL}; /* page-aligned layout when set. */
+  Bool                     fCompress{false}; /* LZ ranges of code and data, see Compress.h. */
+  Bool                     fSplitDebug{false}; /* symbol headers go to a .dbg next to fOutput. */
+  Bool                     fReproducible{false};
+  Bool                     fBindNow{false};
+  std::vector<STLString>   fOrderSymbols{}; /* code symbols to lay out first, hottest first. */
+};
+
+/// @brief Read an order file into symbols, see ld64 -order-file and -order-profile.
+Int32 linker_read_order_file(const STLString& path, Bool profile, std::vector<STLString>& symbols);
+
+/// @brief 64-bit PEF linker.
+/// @note A Linker links once, make another one for the next link.
+class Linker final {
+ public:
+  explicit Linker(LinkerOptions options);
+  ~Linker();
+
+  NECTI_COPY_DELETE(Linker);
+
+ public:
+  /// @brief Link the inputs into fOutput, or in memory when it's empty.
+  /// @return NECTI_SUCCESS, or the error code of the first failure.
+  Int32 Link();
+
+  /// @brief The image linked in memory.
+  std::span<const Char> Image() const { return fImage; }
+
+  /// @brief The .dbg of the image linked in memory, with fSplitDebug.
+  std::span<const Char> DebugImage() const { return fDebugImage; }
+
+  const LinkerOptions& Options() const { return fOptions; }
+
+ private:
+  void   ConvertObject(LinkerObject& object) const;
+  void   IngestObject(const LinkerInput& input, LinkerObject& object) const;
+  Bool   IsStart(const PEFCommandHeader& command_hdr) const;
+  Int32  PullArchiveMembers(std::vector<LinkerObject>& objects);
+  UInt64 OptionsHash() const;
+
+  std::vector<SizeType> LayoutOrder(
+      const std::vector<PEFCommandHeader>&              command_headers,
+      const std::vector<std::pair<SizeType, SizeType>>& symbol_places,
+      const std::vector<SizeType>& folded_into, SymbolTable& symbol_table) const;
+
+  std::vector<Bool> ReachableObjects(
+      const std::vector<PEFCommandHeader>&              command_headers,
+      const std::vector<std::pair<SizeType, SizeType>>& object_ranges,
+      const std::vector<SymbolId>& header_symbols, SymbolTable& symbol_table) const;
+
+  std::vector<SizeType> FoldIdenticalObjects(
+      const std::vector<PEFCommandHeader>&              command_headers,
+      const std::vector<std::pair<SizeType, SizeType>>& object_ranges,
+      const std::vector<SizeType>& header_starts, const std::vector<SymbolId>& header_symbols,
+      SymbolTable& symbol_table) const;
+
+  void WriteImports(const std::vector<SymbolId>& imports, const std::vector<UInt32>& import_slots,
+                    const std::vector<UInt32>& image_index, SymbolTable& symbol_table,
+                    SizeType stubs_offset, SizeType pointers_offset, std::vector<Char>& stubs,
+                    std::vector<Char>& pointers, std::vector<Char>& table) const;
+
+  time_t    BuildEpoch() const;
+  STLString ContainerUUID() const;
+  Int32     IncrementalRelink();
+  Int32     RefreshContainer(Int32 fd, UIntPtr start) const;
+  Int32     LinkFat();
+  Int32     Emit(Utils::ImageWriter& image, const STLString& output, std::vector<Char>& bytes);
+  Int32     EmitDebug(const PEFContainer& container, std::vector<PEFCommandHeader>& headers,
+                      std::vector<Char>& objects);
+
+ private:
+  LinkerOptions fOptions;
+
+  /* object list and maps, then the ranges of their code, whose blobs point into the maps. */
+  std::vector<STLString>                 fObjectList{};
+  std::vector<LinkerInput>               fObjectInputs{};
+  std::vector<Utils::AEMappedObject>     fObjectMaps{};
+  std::vector<LinkerRange>               fRanges{};
+  std::vector<Detail::DynamicLinkerBlob> fObjectBytes{};
+
+  /* static libraries, their members are pulled in on demand and point into these maps. */
+  std::vector<LinkerInput>             fArchiveList{};
+  std::vector<Utils::LibMappedArchive> fArchiveMaps{};
+
+  /* fixups sorted by range then place, and each range's run in there. */
+  std::vector<LinkerFixup>                   fFixups{};
+  std::vector<std::pair<SizeType, SizeType>> fObjectFixups{};
+
+  /* blobs with fixups applied, they no longer point into the mapped objects. */
+  std::vector<std::vector<Char>> fPatchedBlobs{};
+
+  /* streamed links patch a slot per fixup instead, see fStreaming. */
+  std::vector<Char> fPatchedPlaces{};
+
+  std::vector<Char> fImage{};
+  std::vector<Char> fDebugImage{};
+  Bool              fStartFound{false};
+  Bool              fDuplicateSymbols{false};
+};
+}  // namespace CompilerKit
@@ -37,6 +37,34 @@
 
 #define kPefBaseOrigin (0x40000000)
 
+/* @note default page size of page-aligned images, see kPefFlagZeroFill. */
+#define kPefPageSize (4096U)
+#define kPefPageSizeName "Container:PageSize:"
+
+/* @note fixups left for the loader, see PEFRelocation. */
+#define kPefRelocationsName "Container:Relocations"
+
+/* @note imports of :RuntimeSymbol: headers, see PEFImportTable. */
+#define kPefImportsName "Container:Imports"
+#define kPefStubsName "Container:Stubs"
+#define kPefPointersName "Container:Pointers"
+
+/* @note compressed ranges of an image, see PEFCompressedRange. */
+#define kPefCompressedName "Container:Compressed"
+
+/* @note exported symbols of a dylib, see Exports.h. */
+#define kPefExportsName "Container:Exports"
+
+/* @note build time and identity of an image, a .dbg names the image it describes by its GUID. */
+#define kPefBuildEpochName "Container:BuildEpoch:"
+#define kPefGUIDName "Container:GUID:4:"
+
+/* @note input objects of a .dbg, see PEFDebugObject. */
+#define kPefDebugObjectsName "Container:Objects"
+
+/* @note last command header of an image. */
+#define kPefEndName "Container:Exec:END"
+
 /* @note this doesn't have to be __ImageStart only, any C initialization stub will do. */
 #define kPefStart "__ImageStart"
 
@@ -68,7 +96,7 @@ enum {
   kPefKindExec    = 1, /* .exec */
   kPefKindDylib   = 2, /* .dylib */
   kPefKindObject  = 4, /* .obj */
-  kPefKindDebug   = 5, /* .dbg */
+  kPefKindDebug   = 5, /* .dbg, see PEFDebugObject */
   kPefKindDriver  = 6,
   kPefKindCount,
 };
@@ -88,6 +116,16 @@ typedef struct PEFContainer final {
   UInt32   Checksum; /* Whole binary checksum */
 } PACKED PEFContainer, *PEFContainerPtr;
 
+/* @brief Slice of a FAT container, whose Magic is kPefMagicFat and whose Count PEFFatSlice
+ * entries follow it. Each slice is a whole image for one architecture, starting on a page, so a
+ * loader maps only the slice of its CPU. */
+typedef struct PEFFatSlice final {
+  UInt32   Cpu;
+  UInt32   SubCpu;
+  UIntPtr  Offset; /* file offset of the slice's PEFContainer */
+  SizeType Size;
+} PACKED PEFFatSlice, *PEFFatSlicePtr;
+
 /* First PEFCommandHeader starts after PEFContainer */
 /* Last container is __exec_end */
 
@@ -114,6 +152,77 @@ enum {
   kPefLinkerID = 0x1,
   kPefCount    = 4,
 };
+
+/* @brief Command header protections, set on page-aligned images only. */
+enum {
+  kPefFlagRead       = 0x100,
+  kPefFlagWrite      = 0x200,
+  kPefFlagExec       = 0x400,
+  kPefFlagZeroFill   = 0x800,  /* no bytes in the file, mapped as anonymous zero pages. */
+  kPefFlagCompressed = 0x1000, /* in a compressed range, see PEFCompressedRange. */
+};
+
+/* @brief Fixup the loader applies, against a symbol only known at runtime.
+ * Kind is an AE relocation kind, the place is at kPefBaseOrigin + Offset. */
+typedef struct PEFRelocation final {
+  UIntPtr Offset; /* file offset of the place */
+  UInt32  Header; /* command header of the :RuntimeSymbol: */
+  UInt16  Kind;
+  UInt16  Flags;
+  Int64   Addend;
+} PACKED PEFRelocation, *PEFRelocationPtr;
+
+/* @brief Compression codecs. */
+enum {
+  kPefCodecNone = 0,
+  kPefCodecLZ   = 1, /* LZ4 block format, see utils/Compress.h. */
+};
+
+/* @brief Range of an image stored compressed, the Container:Compressed header points to an
+ * array of them, in file order. A compressed image is expanded before it's read, by replacing
+ * each range's FileSize bytes with its Size expanded ones: every offset of the image is an offset
+ * in the expanded image, except the Container:Compressed header's, which is a file offset. */
+typedef struct PEFCompressedRange final {
+  UIntPtr  Offset;     /* offset in the expanded image */
+  SizeType Size;       /* expanded size */
+  UIntPtr  FileOffset; /* offset of the compressed bytes in the file */
+  SizeType FileSize;
+  UInt32   Codec; /* kPefCodec* */
+  UInt32   Flags;
+} PACKED PEFCompressedRange, *PEFCompressedRangePtr;
+
+/* @brief Input object of an image, the Container:Objects header of its .dbg points to an array of
+ * them, followed by their names. An object whose code the linker split and moved apart has an
+ * entry per contiguous run. The other headers of a .dbg are the image's symbol headers, with
+ * offsets into the image and an OffsetSize of 0, a .dbg holds no code. */
+typedef struct PEFDebugObject final {
+  UIntPtr  Offset; /* offset of the object's code, or of a run of it, in the image */
+  SizeType Size;
+  UInt32   Name; /* offset of its path, past the last entry */
+  UInt32   NameLen;
+} PACKED PEFDebugObject, *PEFDebugObjectPtr;
+
+/* @brief Import flags. */
+enum {
+  kPefImportEager = 0x1, /* every pointer is bound at load time, none on first call. */
+};
+
+/* @brief Import table, followed by Count PEFImport entries.
+ * Calls to an import go through its stub, which jumps through its pointer. A lazy pointer starts
+ * out at the stub's binding path: it pushes the import index and jumps through the Binder pointer,
+ * which the loader sets to its binder, and the binder patches the import's pointer. */
+typedef struct PEFImportTable final {
+  UInt32  Count;
+  UInt32  Flags;  /* kPefImport* */
+  UIntPtr Binder; /* file offset of the binder's pointer */
+} PACKED PEFImportTable, *PEFImportTablePtr;
+
+typedef struct PEFImport final {
+  UInt32  Header; /* command header of the :RuntimeSymbol: */
+  UInt32  Flags;
+  UIntPtr Pointer; /* file offset of the import's pointer */
+  UIntPtr Stub;    /* file offset of the import's stub */
+} PACKED PEFImport, *PEFImportPtr;
 }  // namespace CompilerKit
 
 inline std::ofstream& operator<<(std::ofstream& fp, CompilerKit::PEFContainer& container) {
@@ -11,6 +11,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string_view>
 
 /// @note Based of:
 /// https://opensource.apple.com/source/cctools/cctools-750/as/ppc-opcode.h.auto.html
@@ -71,7 +75,7 @@ struct CpuOpcodePPC {
   uint32_t    cpus;
 };
 
-inline CpuOpcodePPC kOpcodesPowerPC[] = {
+inline constexpr CpuOpcodePPC kOpcodesPowerPC[] = {
     {0x38000000, "addi", {{21, 5, GREG}, {16, 5, G0REG}, {0, 16, SI}}},
     {0x38000000, "li", {{21, 5, GREG}, {0, 16, SI}}},
     {0x3c000000, "addis", {{21, 5, GREG}, {16, 5, G0REG}, {0, 16, HI}}},
@@ -1544,6 +1548,47 @@ inline CpuOpcodePPC kOpcodesPowerPC[] = {
     {0, ""} /* end of table marker */
 };
 
+static_assert(std::size(kOpcodesPowerPC) == kOpcodePPCCount + 1, "kOpcodePPCCount is out of date");
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// @brief Mnemonic index of kOpcodesPowerPC, sorted at compile time.
+// @note Equal mnemonics keep their table order, so a lookup finds the first of them.
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+inline constexpr auto kOpcodeIndexPowerPC = [] {
+  std::array<uint16_t, kOpcodePPCCount> index{};
+
+  // the end of table marker isn't indexed.
+  for (uint16_t at = 0U; at < kOpcodePPCCount; ++at) index[at] = at;
+
+  std::sort(index.begin(), index.end(), [](uint16_t lhs, uint16_t rhs) {
+    std::string_view lhs_name(kOpcodesPowerPC[lhs].name), rhs_name(kOpcodesPowerPC[rhs].name);
+
+    return lhs_name < rhs_name || (lhs_name == rhs_name && lhs < rhs);
+  });
+
+  return index;
+}();
+
+/// @brief Opcode of an exact mnemonic (e.g addic. isn't addic), or nothing if it isn't one.
+/// @return a span of zero or one opcode.
+constexpr std::span<const CpuOpcodePPC> asm_power64_find_opcode(std::string_view mnemonic) {
+  auto it = std::lower_bound(kOpcodeIndexPowerPC.begin(), kOpcodeIndexPowerPC.end(), mnemonic,
+                             [](uint16_t at, std::string_view name) {
+                               return std::string_view(kOpcodesPowerPC[at].name) < name;
+                             });
+
+  if (it == kOpcodeIndexPowerPC.end() || kOpcodesPowerPC[*it].name != mnemonic) return {};
+
+  return {&kOpcodesPowerPC[*it], 1UL};
+}
+
+static_assert(asm_power64_find_opcode("li").front().opcode == 0x38000000);
+static_assert(asm_power64_find_opcode("addic.").front().opcode == 0x34000000);
+static_assert(asm_power64_find_opcode("").empty());
+
 #define kAsmFloatZeroRegister 0
 #define kAsmZeroRegister 0
 
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <CompilerKit/Defines.h>
+#include <span>
+#include <string_view>
 
 // @brief AMD64 support.
 // @file impl/X64.h
@@ -21,12 +23,12 @@ typedef uint32_t i64_word_t;
 #define kAsmRegisterPrefix "r"
 
 struct CpuOpcodeAMD64 {
-  std::string fName;
-  i64_byte_t  fPrefixBytes[4];
-  i64_hword_t fOpcode;
-  i64_hword_t fModReg;
-  i64_word_t  fDisplacment;
-  i64_word_t  fImmediate;
+  std::string_view fName{};
+  i64_byte_t       fPrefixBytes[4]{};
+  i64_hword_t      fOpcode{};
+  i64_hword_t      fModReg{};
+  i64_word_t       fDisplacment{};
+  i64_word_t       fImmediate{};
 };
 
 /// these two are edge cases
@@ -38,12 +40,108 @@ struct CpuOpcodeAMD64 {
 #define kJumpLimitStandard 0xE3
 #define kJumpLimitStandardLimit 0xEB
 
-inline std::vector<CpuOpcodeAMD64> kOpcodesAMD64 = {
+/// @brief Every opcode the assembler knows, a mnemonic may appear more than once and then its
+/// first entry is the one encoded (e.g jmp is 0xE3).
+inline constexpr CpuOpcodeAMD64 kOpcodesAMD64[] = {
     CK_ASM_OPCODE("int", 0xCD) CK_ASM_OPCODE("into", 0xCE) CK_ASM_OPCODE("intd", 0xF1)
         CK_ASM_OPCODE("int3", 0xC3) CK_ASM_OPCODE("iret", 0xCF) CK_ASM_OPCODE("retf", 0xCB)
             CK_ASM_OPCODE("retn", 0xC3) CK_ASM_OPCODE("ret", 0xC3) CK_ASM_OPCODE("sti", 0xfb)
                 CK_ASM_OPCODE("cli", 0xfa) CK_ASM_OPCODE("hlt", 0xf4) CK_ASM_OPCODE("nop", 0x90)
                     CK_ASM_OPCODE("mov", 0x48) CK_ASM_OPCODE("call", 0xFF)
-                        CK_ASM_OPCODE("syscall", 0x0F) CK_ASM_OPCODE("xor", 0x48)};
+                        CK_ASM_OPCODE("syscall", 0x0F) CK_ASM_OPCODE("xor", 0x48)
+
+    /// conditional jumps, kJumpLimit of them.
+    CK_ASM_OPCODE("ja", kAsmJumpOpcode + 0) CK_ASM_OPCODE("jae", kAsmJumpOpcode + 1)
+    CK_ASM_OPCODE("jb", kAsmJumpOpcode + 2) CK_ASM_OPCODE("jbe", kAsmJumpOpcode + 3)
+    CK_ASM_OPCODE("jc", kAsmJumpOpcode + 4) CK_ASM_OPCODE("je", kAsmJumpOpcode + 5)
+    CK_ASM_OPCODE("jg", kAsmJumpOpcode + 6) CK_ASM_OPCODE("jge", kAsmJumpOpcode + 7)
+    CK_ASM_OPCODE("jl", kAsmJumpOpcode + 8) CK_ASM_OPCODE("jle", kAsmJumpOpcode + 9)
+    CK_ASM_OPCODE("jna", kAsmJumpOpcode + 10) CK_ASM_OPCODE("jnae", kAsmJumpOpcode + 11)
+    CK_ASM_OPCODE("jnb", kAsmJumpOpcode + 12) CK_ASM_OPCODE("jnbe", kAsmJumpOpcode + 13)
+    CK_ASM_OPCODE("jnc", kAsmJumpOpcode + 14) CK_ASM_OPCODE("jne", kAsmJumpOpcode + 15)
+    CK_ASM_OPCODE("jng", kAsmJumpOpcode + 16) CK_ASM_OPCODE("jnge", kAsmJumpOpcode + 17)
+    CK_ASM_OPCODE("jnl", kAsmJumpOpcode + 18) CK_ASM_OPCODE("jnle", kAsmJumpOpcode + 19)
+    CK_ASM_OPCODE("jno", kAsmJumpOpcode + 20) CK_ASM_OPCODE("jnp", kAsmJumpOpcode + 21)
+    CK_ASM_OPCODE("jns", kAsmJumpOpcode + 22) CK_ASM_OPCODE("jnz", kAsmJumpOpcode + 23)
+    CK_ASM_OPCODE("jo", kAsmJumpOpcode + 24) CK_ASM_OPCODE("jp", kAsmJumpOpcode + 25)
+    CK_ASM_OPCODE("jpe", kAsmJumpOpcode + 26) CK_ASM_OPCODE("jpo", kAsmJumpOpcode + 27)
+    CK_ASM_OPCODE("js", kAsmJumpOpcode + 28) CK_ASM_OPCODE("jz", kAsmJumpOpcode + 29)
+
+    /// jcxz, then jmp from kJumpLimitStandard up to kJumpLimitStandardLimit.
+    CK_ASM_OPCODE("jcxz", 0xE3) CK_ASM_OPCODE("jmp", 0xE3) CK_ASM_OPCODE("jmp", 0xE4)
+    CK_ASM_OPCODE("jmp", 0xE5) CK_ASM_OPCODE("jmp", 0xE6) CK_ASM_OPCODE("jmp", 0xE7)
+    CK_ASM_OPCODE("jmp", 0xE8) CK_ASM_OPCODE("jmp", 0xE9) CK_ASM_OPCODE("jmp", 0xEA)
+
+    CK_ASM_OPCODE("lahf", 0x9F) CK_ASM_OPCODE("lds", 0xC5) CK_ASM_OPCODE("lea", 0x8D)
+    CK_ASM_OPCODE("nop", 0x90)};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// @brief Perfect hash of the mnemonics, built at compile time from kOpcodesAMD64.
+// @note Each distinct mnemonic owns a slot holding the index of its first opcode, so a lookup is
+// one hash and one compare.
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#define kOpcodeSlotsAMD64 (256U)
+#define kOpcodeNoSlotAMD64 (0xFFU)
+
+static_assert(std::size(kOpcodesAMD64) < kOpcodeNoSlotAMD64, "opcode index doesn't fit a slot");
+
+struct CpuOpcodeIndexAMD64 final {
+  i64_word_t fSeed;
+  i64_byte_t fSlots[kOpcodeSlotsAMD64];
+};
+
+/// @brief FNV-1a of a mnemonic, salted with the index seed.
+constexpr i64_word_t asm_amd64_hash(std::string_view name, i64_word_t seed) {
+  i64_word_t hash = 2166136261U ^ seed;
+
+  for (auto ch : name) {
+    hash ^= static_cast<i64_byte_t>(ch);
+    hash *= 16777619U;
+  }
+
+  return (hash ^ (hash >> 16)) % kOpcodeSlotsAMD64;
+}
+
+/// @brief Try seeds until no two distinct mnemonics share a slot.
+constexpr CpuOpcodeIndexAMD64 asm_amd64_build_index() {
+  for (i64_word_t seed = 0U;; ++seed) {
+    CpuOpcodeIndexAMD64 index{.fSeed = seed, .fSlots = {}};
+
+    for (auto& slot : index.fSlots) slot = kOpcodeNoSlotAMD64;
+
+    bool collides = false;
+
+    for (std::size_t at = 0UL; at < std::size(kOpcodesAMD64) && !collides; ++at) {
+      auto& slot = index.fSlots[asm_amd64_hash(kOpcodesAMD64[at].fName, seed)];
+
+      if (slot == kOpcodeNoSlotAMD64)
+        slot = static_cast<i64_byte_t>(at);
+      else
+        collides = kOpcodesAMD64[slot].fName != kOpcodesAMD64[at].fName;
+    }
+
+    if (!collides) return index;
+  }
+}
+
+inline constexpr CpuOpcodeIndexAMD64 kOpcodeIndexAMD64 = asm_amd64_build_index();
+
+/// @brief Opcode of a mnemonic, or nothing if it isn't one.
+/// @return a span of zero or one opcode.
+constexpr std::span<const CpuOpcodeAMD64> asm_amd64_find_opcode(std::string_view mnemonic) {
+  auto slot = kOpcodeIndexAMD64.fSlots[asm_amd64_hash(mnemonic, kOpcodeIndexAMD64.fSeed)];
+
+  if (slot == kOpcodeNoSlotAMD64 || kOpcodesAMD64[slot].fName != mnemonic) return {};
+
+  return {&kOpcodesAMD64[slot], 1UL};
+}
+
+static_assert(asm_amd64_find_opcode("jmp").front().fOpcode == kJumpLimitStandard);
+static_assert(asm_amd64_find_opcode("nop").front().fOpcode == 0x90);
+static_assert(asm_amd64_find_opcode("jz").front().fOpcode == kAsmJumpOpcode + kJumpLimit - 1);
+static_assert(asm_amd64_find_opcode("frob").empty());
 
 #define kAsmRegisterLimit 16
@@ -126,8 +126,6 @@ NECTI_MODULE(AssemblerMain64x0) {
 
     CompilerKit::AEHeader hdr{0};
 
-    memset(hdr.fPad, kAENullType, kAEPad);
-
     hdr.fMagic[0] = kAEMag0;
     hdr.fMagic[1] = kAEMag1;
     hdr.fSize     = sizeof(CompilerKit::AEHeader);
@@ -170,6 +168,8 @@ NECTI_MODULE(AssemblerMain64x0) {
 
       auto pos = file_ptr_out.tellp();
 
+      std::vector<CompilerKit::AERecordHeader> records;
+
       hdr.fCount = kRecords.size() + kUndefinedSymbols.size();
 
       file_ptr_out << hdr;
@@ -184,20 +184,20 @@ NECTI_MODULE(AssemblerMain64x0) {
 
       kRecords[kRecords.size() - 1].fSize = kBytes.size();
 
-      std::size_t record_count = 0UL;
+      // a record's fSize is where it ends, it starts where the previous one ended.
+      std::size_t record_start = 0UL;
 
       for (auto& rec : kRecords) {
         if (kVerbose) kStdOut << "Assembler64x0: Wrote record " << rec.fName << " to file...\n";
 
         rec.fFlags |= CompilerKit::kKindRelocationAtRuntime;
-        rec.fOffset = record_count;
-        ++record_count;
+        rec.fOffset = record_start;
+        rec.fSize -= record_start;
 
-        file_ptr_out << rec;
-      }
+        record_start += rec.fSize;
 
-      // increment once again, so that we won't lie about the kUndefinedSymbols.
-      ++record_count;
+        records.push_back(rec);
+      }
 
       for (auto& sym : kUndefinedSymbols) {
         CompilerKit::AERecordHeader _record_hdr{0};
@@ -205,19 +205,20 @@ NECTI_MODULE(AssemblerMain64x0) {
         if (kVerbose) kStdOut << "Assembler64x0: Wrote symbol " << sym << " to file...\n";
 
         _record_hdr.fKind   = kAENullType;
-        _record_hdr.fSize   = sym.size();
-        _record_hdr.fOffset = record_count;
-
-        ++record_count;
+        _record_hdr.fSize   = 0UL;
+        _record_hdr.fOffset = 0UL;
 
         memset(_record_hdr.fPad, kAENullType, kAEPad);
         memcpy(_record_hdr.fName, sym.c_str(), sym.size());
 
-        file_ptr_out << _record_hdr;
+        records.push_back(_record_hdr);
 
         ++kCounter;
       }
 
+      // the records are compacted, their names go to the string table.
+      CompilerKit::Utils::ae_write_records(file_ptr_out, hdr, records);
+
       auto pos_end = file_ptr_out.tellp();
 
       file_ptr_out.seekp(pos);
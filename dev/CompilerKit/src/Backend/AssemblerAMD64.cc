@@ -73,6 +73,29 @@ static std::vector<std::string>                 kUndefinedSymbols;
 
 static const std::string kUndefinedSymbol = ":UndefinedSymbol:";
 
+/// @brief Leading word of a line, the mnemonic of an instruction.
+static std::string_view asm_amd64_mnemonic(const std::string& line) {
+  auto start = line.find_first_not_of(" \t");
+
+  if (start == std::string::npos) return {};
+
+  auto end = start;
+
+  while (end < line.size() && isalnum(static_cast<unsigned char>(line[end]))) ++end;
+
+  return std::string_view(line).substr(start, end - start);
+}
+
+/// @brief Fixup against a symbol, kept until the records and the output bytes are known.
+struct AssemblerRelocAMD64 final {
+  std::size_t   fPlace;  // index into kAppBytes.
+  std::string   fSymbol;
+  std::uint16_t fKind;
+  std::int64_t  fAddend;
+};
+
+static std::vector<AssemblerRelocAMD64> kRelocations;
+
 // \brief forward decl.
 static bool asm_read_attributes(std::string line);
 
@@ -85,42 +108,9 @@ static bool asm_read_attributes(std::string line);
 /////////////////////////////////////////////////////////////////////////////////////////
 
 NECTI_MODULE(AssemblerMainAMD64) {
-  //////////////// CPU OPCODES BEGIN ////////////////
-
   CompilerKit::install_signal(SIGSEGV, Detail::drvi_crash_handler);
 
-  std::string opcodes_jump[kJumpLimit] = {"ja",  "jae",  "jb",  "jbe",  "jc",  "je",   "jg",  "jge",
-                                          "jl",  "jle",  "jna", "jnae", "jnb", "jnbe", "jnc", "jne",
-                                          "jng", "jnge", "jnl", "jnle", "jno", "jnp",  "jns", "jnz",
-                                          "jo",  "jp",   "jpe", "jpo",  "js",  "jz"};
-
-  for (i64_hword_t i = 0; i < kJumpLimit; i++) {
-    CpuOpcodeAMD64 code{.fName   = opcodes_jump[i],
-                        .fOpcode = static_cast<i64_hword_t>(kAsmJumpOpcode + i)};
-    kOpcodesAMD64.push_back(code);
-  }
-
-  CpuOpcodeAMD64 code{.fName = "jcxz", .fOpcode = 0xE3};
-  kOpcodesAMD64.push_back(code);
-
-  for (i64_hword_t i = kJumpLimitStandard; i < kJumpLimitStandardLimit; i++) {
-    CpuOpcodeAMD64 code{.fName = "jmp", .fOpcode = i};
-    kOpcodesAMD64.push_back(code);
-  }
-
-  CpuOpcodeAMD64 lahf{.fName = "lahf", .fOpcode = 0x9F};
-  kOpcodesAMD64.push_back(lahf);
-
-  CpuOpcodeAMD64 lds{.fName = "lds", .fOpcode = 0xC5};
-  kOpcodesAMD64.push_back(lds);
-
-  CpuOpcodeAMD64 lea{.fName = "lea", .fOpcode = 0x8D};
-  kOpcodesAMD64.push_back(lea);
-
-  CpuOpcodeAMD64 nop{.fName = "nop", .fOpcode = 0x90};
-  kOpcodesAMD64.push_back(nop);
-
-  //////////////// CPU OPCODES END ////////////////
+  // CPU opcodes and their mnemonic index are built at compile time, see impl/X64.h.
 
   for (size_t i = 1; i < argc; ++i) {
     if (argv[i][0] == '-') {
@@ -183,8 +173,6 @@ NECTI_MODULE(AssemblerMainAMD64) {
 
     CompilerKit::AEHeader hdr{0};
 
-    memset(hdr.fPad, kAENullType, kAEPad);
-
     hdr.fMagic[0] = kAEMag0;
     hdr.fMagic[1] = kAEMag1;
     hdr.fSize     = sizeof(CompilerKit::AEHeader);
@@ -227,6 +215,8 @@ NECTI_MODULE(AssemblerMainAMD64) {
       }
     }
 
+    std::vector<CompilerKit::AERelocation> relocations;
+
     if (!kOutputAsBinary) {
       if (kVerbose) {
         kStdOut << "AssemblerAMD64: Writing object file...\n";
@@ -234,8 +224,41 @@ NECTI_MODULE(AssemblerMainAMD64) {
 
       // this is the final step, write everything to the file.
 
+      // zero bytes are never written, so kAppBytes indices have to be mapped to file positions.
+      std::vector<std::size_t> positions(kAppBytes.size() + 1, 0UL);
+
+      for (std::size_t byte = 0UL; byte < kAppBytes.size(); ++byte)
+        positions[byte + 1] = positions[byte] + (kAppBytes[byte] != 0);
+
+      for (auto& reloc : kRelocations) {
+        std::size_t record_index = 0UL;
+
+        for (; record_index < kRecords.size(); ++record_index) {
+          std::string record_name = kRecords[record_index].fName;
+
+          if (record_name.ends_with("$" + reloc.fSymbol)) break;
+        }
+
+        if (record_index == kRecords.size()) {
+          Detail::print_error("Undefined label: " + reloc.fSymbol +
+                                  ", declare it with public_segment or extern_segment.",
+                              argv[i]);
+
+          std::filesystem::remove(object_output);
+          return 1;
+        }
+
+        relocations.push_back({.fOffset = positions[reloc.fPlace],
+                               .fRecord = static_cast<std::uint32_t>(record_index),
+                               .fKind   = reloc.fKind,
+                               .fFlags  = CompilerKit::kKindRelocationByOffset,
+                               .fAddend = reloc.fAddend});
+      }
+
       auto pos = file_ptr_out.tellp();
 
+      std::vector<CompilerKit::AERecordHeader> records;
+
       hdr.fCount = kRecords.size() + kUndefinedSymbols.size();
 
       file_ptr_out << hdr;
@@ -250,20 +273,22 @@ NECTI_MODULE(AssemblerMainAMD64) {
 
       kRecords[kRecords.size() - 1].fSize = kAppBytes.size();
 
-      std::size_t record_count = 0UL;
+      // a record's fSize is where it ends, it starts where the previous one ended.
+      std::size_t record_start = 0UL;
 
       for (auto& rec : kRecords) {
         if (kVerbose) kStdOut << "AssemblerAMD64: Wrote record " << rec.fName << " to file...\n";
 
+        std::size_t record_end = positions[rec.fSize];
+
         rec.fFlags |= CompilerKit::kKindRelocationAtRuntime;
-        rec.fOffset = record_count;
-        ++record_count;
+        rec.fOffset = record_start;
+        rec.fSize   = record_end - record_start;
 
-        file_ptr_out << rec;
-      }
+        record_start = record_end;
 
-      // increment once again, so that we won't lie about the kUndefinedSymbols.
-      ++record_count;
+        records.push_back(rec);
+      }
 
       for (auto& sym : kUndefinedSymbols) {
         CompilerKit::AERecordHeader _record_hdr{0};
@@ -271,25 +296,29 @@ NECTI_MODULE(AssemblerMainAMD64) {
         if (kVerbose) kStdOut << "AssemblerAMD64: Wrote symbol " << sym << " to file...\n";
 
         _record_hdr.fKind   = kAENullType;
-        _record_hdr.fSize   = sym.size();
-        _record_hdr.fOffset = record_count;
-
-        ++record_count;
+        _record_hdr.fSize   = 0UL;
+        _record_hdr.fOffset = 0UL;
 
         memset(_record_hdr.fPad, kAENullType, kAEPad);
         memcpy(_record_hdr.fName, sym.c_str(), sym.size());
 
-        file_ptr_out << _record_hdr;
+        records.push_back(_record_hdr);
 
         ++kCounter;
       }
 
+      // the records are compacted, their names go to the string table. Labels are only reached
+      // through relocations, so the linker may split the code at record starts.
+      CompilerKit::Utils::ae_write_records(file_ptr_out, hdr, records, kAESectionSplit);
+
       auto pos_end = file_ptr_out.tellp();
 
       file_ptr_out.seekp(pos);
 
-      hdr.fStartCode = pos_end;
-      hdr.fCodeSize  = kAppBytes.size();
+      hdr.fStartCode  = pos_end;
+      hdr.fCodeSize   = positions.back();
+      hdr.fRelocCount = relocations.size();
+      hdr.fRelocStart = relocations.empty() ? 0UL : hdr.fStartCode + hdr.fCodeSize;
 
       file_ptr_out << hdr;
 
@@ -311,6 +340,12 @@ NECTI_MODULE(AssemblerMainAMD64) {
       file_ptr_out << reinterpret_cast<const char*>(&byte)[0];
     }
 
+    // the relocation table follows the code.
+    if (!kOutputAsBinary) {
+      file_ptr_out.write(reinterpret_cast<const char*>(relocations.data()),
+                         relocations.size() * sizeof(CompilerKit::AERelocation));
+    }
+
     if (kVerbose) kStdOut << "AssemblerAMD64: Wrote file with program in it.\n";
 
     file_ptr_out.flush();
@@ -546,11 +581,7 @@ std::string CompilerKit::EncoderAMD64::CheckLine(std::string line, std::string f
       }
     }
   }
-  for (auto& opcodeAMD64 : kOpcodesAMD64) {
-    if (CompilerKit::find_word(line, opcodeAMD64.fName)) {
-      return err_str;
-    }
-  }
+  if (!asm_amd64_find_opcode(asm_amd64_mnemonic(line)).empty()) return err_str;
 
   err_str += "\nUnrecognized instruction -> " + line;
 
@@ -968,10 +999,9 @@ bool CompilerKit::EncoderAMD64::WriteLine(std::string line, std::string file) {
 
   BOOL foundInstruction = false;
 
-  for (auto& opcodeAMD64 : kOpcodesAMD64) {
+  for (auto& opcodeAMD64 : asm_amd64_find_opcode(asm_amd64_mnemonic(line))) {
     // strict check here
-    if (CompilerKit::find_word(line, opcodeAMD64.fName) &&
-        Detail::algorithm::is_valid_amd64(line)) {
+    if (Detail::algorithm::is_valid_amd64(line)) {
       foundInstruction = true;
       std::string name(opcodeAMD64.fName);
 
@@ -1132,9 +1162,34 @@ bool CompilerKit::EncoderAMD64::WriteLine(std::string line, std::string file) {
 
         break;
       } else if (name == "jmp" || name == "call") {
-        kAppBytes.emplace_back(opcodeAMD64.fOpcode);
+        // the table holds the indirect/short forms, emit the near rel32 ones (E9/E8).
+        kAppBytes.emplace_back(name == "call" ? 0xE8 : 0xE9);
+
+        auto operand_pos = line.find(name) + name.size() + 1;
+
+        if (operand_pos < line.size() && !isdigit(line[operand_pos])) {
+          // a label, the linker fills the rel32 in, relative to the end of the instruction.
+          if (kOutputAsBinary) {
+            Detail::print_error("Labels need a linker, not available in flat binary mode.", file);
+            throw std::runtime_error("invalid_label_bin");
+          }
+
+          std::string label = line.substr(operand_pos);
+
+          while (!label.empty() && isspace(label.back())) label.pop_back();
+
+          kRelocations.push_back({.fPlace  = kAppBytes.size(),
+                                  .fSymbol = label,
+                                  .fKind   = CompilerKit::kAERelocRel32,
+                                  .fAddend = -4});
+
+          // written as zeros, see the output loop.
+          for (int byte = 0; byte < 4; ++byte) kAppBytes.emplace_back(0xFF);
+
+          break;
+        }
 
-        if (!this->WriteNumber32(line.find(name) + name.size() + 1, line)) {
+        if (!this->WriteNumber32(operand_pos, line)) {
           throw std::runtime_error("BUG: WriteNumber32");
         }
 
@@ -131,8 +131,6 @@ NECTI_MODULE(AssemblerMainARM64) {
 
     CompilerKit::AEHeader hdr{0};
 
-    memset(hdr.fPad, kAENullType, kAEPad);
-
     hdr.fMagic[0] = kAEMag0;
     hdr.fMagic[1] = kAEMag1;
     hdr.fSize     = sizeof(CompilerKit::AEHeader);
@@ -175,6 +173,8 @@ NECTI_MODULE(AssemblerMainARM64) {
 
       auto pos = file_ptr_out.tellp();
 
+      std::vector<CompilerKit::AERecordHeader> records;
+
       hdr.fCount = kRecords.size() + kUndefinedSymbols.size();
 
       file_ptr_out << hdr;
@@ -189,40 +189,41 @@ NECTI_MODULE(AssemblerMainARM64) {
 
       kRecords[kRecords.size() - 1].fSize = kBytes.size();
 
-      std::size_t record_count = 0UL;
+      // a record's fSize is where it ends, it starts where the previous one ended.
+      std::size_t record_start = 0UL;
 
       for (auto& record_hdr : kRecords) {
         record_hdr.fFlags |= CompilerKit::kKindRelocationAtRuntime;
-        record_hdr.fOffset = record_count;
-        ++record_count;
+        record_hdr.fOffset = record_start;
+        record_hdr.fSize -= record_start;
+
+        record_start += record_hdr.fSize;
 
-        file_ptr_out << record_hdr;
+        records.push_back(record_hdr);
 
         if (kVerbose) kStdOut << "AssemblerARM64: Wrote record " << record_hdr.fName << "...\n";
       }
 
-      // increment once again, so that we won't lie about the kUndefinedSymbols.
-      ++record_count;
-
       for (auto& sym : kUndefinedSymbols) {
         CompilerKit::AERecordHeader undefined_sym{0};
 
         if (kVerbose) kStdOut << "AssemblerARM64: Wrote symbol " << sym << " to file...\n";
 
         undefined_sym.fKind   = kAENullType;
-        undefined_sym.fSize   = sym.size();
-        undefined_sym.fOffset = record_count;
-
-        ++record_count;
+        undefined_sym.fSize   = 0UL;
+        undefined_sym.fOffset = 0UL;
 
         memset(undefined_sym.fPad, kAENullType, kAEPad);
         memcpy(undefined_sym.fName, sym.c_str(), sym.size());
 
-        file_ptr_out << undefined_sym;
+        records.push_back(undefined_sym);
 
         ++kCounter;
       }
 
+      // the records are compacted, their names go to the string table.
+      CompilerKit::Utils::ae_write_records(file_ptr_out, hdr, records);
+
       auto pos_end = file_ptr_out.tellp();
 
       file_ptr_out.seekp(pos);
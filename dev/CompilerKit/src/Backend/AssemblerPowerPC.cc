@@ -63,6 +63,20 @@ static std::vector<std::string>                 kUndefinedSymbols;
 static const std::string kUndefinedSymbol = ":UndefinedSymbol:";
 static const std::string kRelocSymbol     = ":RuntimeSymbol:";
 
+/// @brief Leading word of a line, the mnemonic of an instruction (dots included, e.g addic.).
+static std::string_view asm_power64_mnemonic(const std::string& line) {
+  auto start = line.find_first_not_of(" \t");
+
+  if (start == std::string::npos) return {};
+
+  auto end = start;
+
+  while (end < line.size() && (isalnum(static_cast<unsigned char>(line[end])) || line[end] == '.'))
+    ++end;
+
+  return std::string_view(line).substr(start, end - start);
+}
+
 // \brief forward decl.
 static bool asm_read_attributes(std::string line);
 
@@ -131,8 +145,6 @@ NECTI_MODULE(AssemblerMainPower64) {
 
     CompilerKit::AEHeader hdr{0};
 
-    memset(hdr.fPad, kAENullType, kAEPad);
-
     hdr.fMagic[0] = kAEMag0;
     hdr.fMagic[1] = kAEMag1;
     hdr.fSize     = sizeof(CompilerKit::AEHeader);
@@ -175,6 +187,8 @@ NECTI_MODULE(AssemblerMainPower64) {
 
       auto pos = file_ptr_out.tellp();
 
+      std::vector<CompilerKit::AERecordHeader> records;
+
       hdr.fCount = kRecords.size() + kUndefinedSymbols.size();
 
       file_ptr_out << hdr;
@@ -189,40 +203,41 @@ NECTI_MODULE(AssemblerMainPower64) {
 
       kRecords[kRecords.size() - 1].fSize = kBytes.size();
 
-      std::size_t record_count = 0UL;
+      // a record's fSize is where it ends, it starts where the previous one ended.
+      std::size_t record_start = 0UL;
 
       for (auto& record_hdr : kRecords) {
         record_hdr.fFlags |= CompilerKit::kKindRelocationAtRuntime;
-        record_hdr.fOffset = record_count;
-        ++record_count;
+        record_hdr.fOffset = record_start;
+        record_hdr.fSize -= record_start;
 
-        file_ptr_out << record_hdr;
+        record_start += record_hdr.fSize;
+
+        records.push_back(record_hdr);
 
         if (kVerbose) kStdOut << "AssemblerPower: Wrote record " << record_hdr.fName << "...\n";
       }
 
-      // increment once again, so that we won't lie about the kUndefinedSymbols.
-      ++record_count;
-
       for (auto& sym : kUndefinedSymbols) {
         CompilerKit::AERecordHeader undefined_sym{0};
 
         if (kVerbose) kStdOut << "AssemblerPower: Wrote symbol " << sym << " to file...\n";
 
         undefined_sym.fKind   = kAENullType;
-        undefined_sym.fSize   = sym.size();
-        undefined_sym.fOffset = record_count;
-
-        ++record_count;
+        undefined_sym.fSize   = 0UL;
+        undefined_sym.fOffset = 0UL;
 
         memset(undefined_sym.fPad, kAENullType, kAEPad);
         memcpy(undefined_sym.fName, sym.c_str(), sym.size());
 
-        file_ptr_out << undefined_sym;
+        records.push_back(undefined_sym);
 
         ++kCounter;
       }
 
+      // the records are compacted, their names go to the string table.
+      CompilerKit::Utils::ae_write_records(file_ptr_out, hdr, records);
+
       auto pos_end = file_ptr_out.tellp();
 
       file_ptr_out.seekp(pos);
@@ -483,33 +498,29 @@ std::string CompilerKit::EncoderPowerPC::CheckLine(std::string line, std::string
   // these don't.
   std::vector<std::string> filter_inst = {"blr", "bl", "sc"};
 
-  for (auto& opcode_risc : kOpcodesPowerPC) {
-    if (CompilerKit::find_word(line, opcode_risc.name)) {
-      for (auto& op : operands_inst) {
-        // if only the instruction was found.
-        if (line == op) {
-          err_str += "\nMalformed ";
-          err_str += op;
-          err_str += " instruction, here -> ";
-          err_str += line;
-        }
+  for (auto& opcode_risc : asm_power64_find_opcode(asm_power64_mnemonic(line))) {
+    for (auto& op : operands_inst) {
+      // if only the instruction was found.
+      if (line == op) {
+        err_str += "\nMalformed ";
+        err_str += op;
+        err_str += " instruction, here -> ";
+        err_str += line;
       }
+    }
 
-      // if it is like that -> addr1, 0x0
-      if (auto it = std::find(filter_inst.begin(), filter_inst.end(), opcode_risc.name);
-          it == filter_inst.cend()) {
-        if (CompilerKit::find_word(line, opcode_risc.name)) {
-          if (!isspace(line[line.find(opcode_risc.name) + strlen(opcode_risc.name)])) {
-            err_str += "\nMissing space between ";
-            err_str += opcode_risc.name;
-            err_str += " and operands.\nhere -> ";
-            err_str += line;
-          }
-        }
+    // if it is like that -> addr1, 0x0
+    if (auto it = std::find(filter_inst.begin(), filter_inst.end(), opcode_risc.name);
+        it == filter_inst.cend()) {
+      if (!isspace(line[line.find(opcode_risc.name) + strlen(opcode_risc.name)])) {
+        err_str += "\nMissing space between ";
+        err_str += opcode_risc.name;
+        err_str += " and operands.\nhere -> ";
+        err_str += line;
       }
-
-      return err_str;
     }
+
+    return err_str;
   }
 
   err_str += "Unrecognized instruction: " + line;
@@ -617,292 +628,289 @@ bool CompilerKit::EncoderPowerPC::WriteLine(std::string line, std::string file)
   if (CompilerKit::find_word(line, "public_segment")) return false;
   if (!Detail::algorithm::is_valid_power64(line)) return false;
 
-  for (auto& opcode_risc : kOpcodesPowerPC) {
-    // strict check here
-    if (CompilerKit::find_word(line, opcode_risc.name)) {
-      std::string         name(opcode_risc.name);
-      std::string         jump_label, cpy_jump_label;
-      std::vector<size_t> found_registers_index;
+  for (auto& opcode_risc : asm_power64_find_opcode(asm_power64_mnemonic(line))) {
+    std::string         name(opcode_risc.name);
+    std::string         jump_label, cpy_jump_label;
+    std::vector<size_t> found_registers_index;
 
-      // check funct7 type.
-      switch (opcode_risc.ops->type) {
-        default: {
-          NumberCast32 num(opcode_risc.opcode);
+    // check funct7 type.
+    switch (opcode_risc.ops->type) {
+      default: {
+        NumberCast32 num(opcode_risc.opcode);
 
-          for (auto ch : num.number) {
-            kBytes.emplace_back(ch);
-          }
-          break;
+        for (auto ch : num.number) {
+          kBytes.emplace_back(ch);
         }
-        case BADDR:
-        case PCREL: {
-          auto num = GetNumber32(line, name);
+        break;
+      }
+      case BADDR:
+      case PCREL: {
+        auto num = GetNumber32(line, name);
 
-          kBytes.emplace_back(num.number[0]);
-          kBytes.emplace_back(num.number[1]);
-          kBytes.emplace_back(num.number[2]);
-          kBytes.emplace_back(0x48);
+        kBytes.emplace_back(num.number[0]);
+        kBytes.emplace_back(num.number[1]);
+        kBytes.emplace_back(num.number[2]);
+        kBytes.emplace_back(0x48);
 
-          break;
-        }
-        /// General purpose, float, vector operations. Everything that involve
-        /// registers.
-        case G0REG:
-        case FREG:
-        case VREG:
-        case GREG: {
-          // \brief how many registers we found.
-          std::size_t found_some_count = 0UL;
-          std::size_t register_count   = 0UL;
-          std::string opcodeName       = opcode_risc.name;
-          std::size_t register_sum     = 0;
-
-          NumberCast64 num(opcode_risc.opcode);
-
-          for (size_t line_index = 0UL; line_index < line.size(); line_index++) {
-            if (line[line_index] == kAsmRegisterPrefix[0] && isdigit(line[line_index + 1])) {
-              std::string register_syntax = kAsmRegisterPrefix;
-              register_syntax += line[line_index + 1];
-
-              if (isdigit(line[line_index + 2])) register_syntax += line[line_index + 2];
-
-              std::string reg_str;
-              reg_str += line[line_index + 1];
-
-              if (isdigit(line[line_index + 2])) reg_str += line[line_index + 2];
-
-              // it ranges from r0 to r19
-              // something like r190 doesn't exist in the instruction set.
-              if (isdigit(line[line_index + 3]) && isdigit(line[line_index + 2])) {
-                reg_str += line[line_index + 3];
-                Detail::print_error("invalid register index, r" + reg_str +
-                                        "\nnote: The POWER accepts registers from r0 to r32.",
-                                    file);
-                throw std::runtime_error("invalid_register_index");
-              }
+        break;
+      }
+      /// General purpose, float, vector operations. Everything that involve
+      /// registers.
+      case G0REG:
+      case FREG:
+      case VREG:
+      case GREG: {
+        // \brief how many registers we found.
+        std::size_t found_some_count = 0UL;
+        std::size_t register_count   = 0UL;
+        std::string opcodeName       = opcode_risc.name;
+        std::size_t register_sum     = 0;
+
+        NumberCast64 num(opcode_risc.opcode);
+
+        for (size_t line_index = 0UL; line_index < line.size(); line_index++) {
+          if (line[line_index] == kAsmRegisterPrefix[0] && isdigit(line[line_index + 1])) {
+            std::string register_syntax = kAsmRegisterPrefix;
+            register_syntax += line[line_index + 1];
+
+            if (isdigit(line[line_index + 2])) register_syntax += line[line_index + 2];
+
+            std::string reg_str;
+            reg_str += line[line_index + 1];
+
+            if (isdigit(line[line_index + 2])) reg_str += line[line_index + 2];
+
+            // it ranges from r0 to r19
+            // something like r190 doesn't exist in the instruction set.
+            if (isdigit(line[line_index + 3]) && isdigit(line[line_index + 2])) {
+              reg_str += line[line_index + 3];
+              Detail::print_error("invalid register index, r" + reg_str +
+                                      "\nnote: The POWER accepts registers from r0 to r32.",
+                                  file);
+              throw std::runtime_error("invalid_register_index");
+            }
 
-              // finally cast to a size_t
-              std::size_t reg_index = strtol(reg_str.c_str(), nullptr, 10);
+            // finally cast to a size_t
+            std::size_t reg_index = strtol(reg_str.c_str(), nullptr, 10);
 
-              if (reg_index > kAsmRegisterLimit) {
-                Detail::print_error("invalid register index, r" + reg_str, file);
-                throw std::runtime_error("invalid_register_index");
-              }
+            if (reg_index > kAsmRegisterLimit) {
+              Detail::print_error("invalid register index, r" + reg_str, file);
+              throw std::runtime_error("invalid_register_index");
+            }
 
-              if (opcodeName == "li") {
-                char numIndex = 0;
+            if (opcodeName == "li") {
+              char numIndex = 0;
 
-                for (size_t i = 0; i != reg_index; i++) {
-                  numIndex += 0x20;
-                }
+              for (size_t i = 0; i != reg_index; i++) {
+                numIndex += 0x20;
+              }
 
-                auto num = GetNumber32(line, reg_str);
+              auto num = GetNumber32(line, reg_str);
 
-                kBytes.push_back(num.number[0]);
-                kBytes.push_back(num.number[1]);
-                kBytes.push_back(numIndex);
-                kBytes.push_back(0x38);
+              kBytes.push_back(num.number[0]);
+              kBytes.push_back(num.number[1]);
+              kBytes.push_back(numIndex);
+              kBytes.push_back(0x38);
 
-                // check if bigger than two.
-                for (size_t i = 2; i < 4; i++) {
-                  if (num.number[i] > 0) {
-                    Detail::print_warning("number overflow on li operation.", file);
-                    break;
-                  }
+              // check if bigger than two.
+              for (size_t i = 2; i < 4; i++) {
+                if (num.number[i] > 0) {
+                  Detail::print_warning("number overflow on li operation.", file);
+                  break;
                 }
-
-                break;
               }
 
-              if ((opcodeName[0] == 's' && opcodeName[1] == 't')) {
-                if (register_sum == 0) {
-                  for (size_t indexReg = 0UL; indexReg < reg_index; ++indexReg) {
-                    register_sum += 0x20;
-                  }
-                } else {
-                  register_sum += reg_index;
+              break;
+            }
+
+            if ((opcodeName[0] == 's' && opcodeName[1] == 't')) {
+              if (register_sum == 0) {
+                for (size_t indexReg = 0UL; indexReg < reg_index; ++indexReg) {
+                  register_sum += 0x20;
                 }
+              } else {
+                register_sum += reg_index;
               }
+            }
 
-              if (opcodeName == "mr") {
-                switch (register_count) {
-                  case 0: {
-                    kBytes.push_back(0x78);
+            if (opcodeName == "mr") {
+              switch (register_count) {
+                case 0: {
+                  kBytes.push_back(0x78);
 
-                    char numIndex = 0x3;
+                  char numIndex = 0x3;
 
-                    for (size_t i = 0; i != reg_index; i++) {
-                      numIndex += 0x8;
-                    }
+                  for (size_t i = 0; i != reg_index; i++) {
+                    numIndex += 0x8;
+                  }
 
-                    kBytes.push_back(numIndex);
+                  kBytes.push_back(numIndex);
 
-                    break;
-                  }
-                  case 1: {
-                    char numIndex = 0x1;
+                  break;
+                }
+                case 1: {
+                  char numIndex = 0x1;
 
-                    for (size_t i = 0; i != reg_index; i++) {
-                      numIndex += 0x20;
-                    }
+                  for (size_t i = 0; i != reg_index; i++) {
+                    numIndex += 0x20;
+                  }
 
-                    for (size_t i = 0; i != reg_index; i++) {
-                      kBytes[kBytes.size() - 1] += 0x8;
-                    }
+                  for (size_t i = 0; i != reg_index; i++) {
+                    kBytes[kBytes.size() - 1] += 0x8;
+                  }
 
-                    kBytes[kBytes.size() - 1] -= 0x8;
+                  kBytes[kBytes.size() - 1] -= 0x8;
 
-                    kBytes.push_back(numIndex);
+                  kBytes.push_back(numIndex);
 
-                    if (reg_index >= 10 && reg_index < 20)
-                      kBytes.push_back(0x7d);
-                    else if (reg_index >= 20 && reg_index < 30)
-                      kBytes.push_back(0x7e);
-                    else if (reg_index >= 30)
-                      kBytes.push_back(0x7f);
-                    else
-                      kBytes.push_back(0x7c);
+                  if (reg_index >= 10 && reg_index < 20)
+                    kBytes.push_back(0x7d);
+                  else if (reg_index >= 20 && reg_index < 30)
+                    kBytes.push_back(0x7e);
+                  else if (reg_index >= 30)
+                    kBytes.push_back(0x7f);
+                  else
+                    kBytes.push_back(0x7c);
 
-                    break;
-                  }
-                  default:
-                    break;
+                  break;
                 }
-
-                ++register_count;
-                ++found_some_count;
+                default:
+                  break;
               }
 
-              if (opcodeName == "addi") {
-                if (found_some_count == 2 || found_some_count == 0)
-                  kBytes.emplace_back(reg_index);
-                else if (found_some_count == 1)
-                  kBytes.emplace_back(0x00);
+              ++register_count;
+              ++found_some_count;
+            }
 
-                ++found_some_count;
+            if (opcodeName == "addi") {
+              if (found_some_count == 2 || found_some_count == 0)
+                kBytes.emplace_back(reg_index);
+              else if (found_some_count == 1)
+                kBytes.emplace_back(0x00);
 
-                if (found_some_count > 3) {
-                  Detail::print_error("Too much registers. -> " + line, file);
-                  throw std::runtime_error("too_much_regs");
-                }
+              ++found_some_count;
+
+              if (found_some_count > 3) {
+                Detail::print_error("Too much registers. -> " + line, file);
+                throw std::runtime_error("too_much_regs");
               }
+            }
 
-              if (opcodeName.find("cmp") != std::string::npos) {
-                ++found_some_count;
+            if (opcodeName.find("cmp") != std::string::npos) {
+              ++found_some_count;
 
-                if (found_some_count > 3) {
-                  Detail::print_error("Too much registers. -> " + line, file);
-                  throw std::runtime_error("too_much_regs");
-                }
+              if (found_some_count > 3) {
+                Detail::print_error("Too much registers. -> " + line, file);
+                throw std::runtime_error("too_much_regs");
               }
+            }
 
-              if (opcodeName.find("mf") != std::string::npos ||
-                  opcodeName.find("mt") != std::string::npos) {
-                char numIndex = 0;
+            if (opcodeName.find("mf") != std::string::npos ||
+                opcodeName.find("mt") != std::string::npos) {
+              char numIndex = 0;
 
-                for (size_t i = 0; i != reg_index; i++) {
-                  numIndex += 0x20;
-                }
+              for (size_t i = 0; i != reg_index; i++) {
+                numIndex += 0x20;
+              }
 
-                num.number[2] += numIndex;
+              num.number[2] += numIndex;
 
-                ++found_some_count;
+              ++found_some_count;
 
-                if (found_some_count > 1) {
-                  Detail::print_error("Too much registers. -> " + line, file);
-                  throw std::runtime_error("too_much_regs");
-                }
-
-                if (kVerbose) {
-                  kStdOut << "AssemblerPower: Found register: " << register_syntax << "\n";
-                  kStdOut << "AssemblerPower: Amount of registers in instruction: "
-                          << found_some_count << "\n";
-                }
+              if (found_some_count > 1) {
+                Detail::print_error("Too much registers. -> " + line, file);
+                throw std::runtime_error("too_much_regs");
+              }
 
-                if (reg_index >= 10 && reg_index < 20)
-                  num.number[3] = 0x7d;
-                else if (reg_index >= 20 && reg_index < 30)
-                  num.number[3] = 0x7e;
-                else if (reg_index >= 30)
-                  num.number[3] = 0x7f;
-                else
-                  num.number[3] = 0x7c;
-
-                for (auto ch : num.number) {
-                  kBytes.emplace_back(ch);
-                }
+              if (kVerbose) {
+                kStdOut << "AssemblerPower: Found register: " << register_syntax << "\n";
+                kStdOut << "AssemblerPower: Amount of registers in instruction: "
+                        << found_some_count << "\n";
               }
 
-              found_registers_index.push_back(reg_index);
+              if (reg_index >= 10 && reg_index < 20)
+                num.number[3] = 0x7d;
+              else if (reg_index >= 20 && reg_index < 30)
+                num.number[3] = 0x7e;
+              else if (reg_index >= 30)
+                num.number[3] = 0x7f;
+              else
+                num.number[3] = 0x7c;
+
+              for (auto ch : num.number) {
+                kBytes.emplace_back(ch);
+              }
             }
-          }
 
-          if (opcodeName == "addi") {
-            kBytes.emplace_back(0x38);
+            found_registers_index.push_back(reg_index);
           }
+        }
 
-          if (opcodeName.find("cmp") != std::string::npos) {
-            char rightReg = 0x0;
+        if (opcodeName == "addi") {
+          kBytes.emplace_back(0x38);
+        }
 
-            for (size_t i = 0; i != found_registers_index[1]; i++) {
-              rightReg += 0x08;
-            }
+        if (opcodeName.find("cmp") != std::string::npos) {
+          char rightReg = 0x0;
 
-            kBytes.emplace_back(0x00);
-            kBytes.emplace_back(rightReg);
-            kBytes.emplace_back(found_registers_index[0]);
-            kBytes.emplace_back(0x7c);
+          for (size_t i = 0; i != found_registers_index[1]; i++) {
+            rightReg += 0x08;
           }
 
-          if ((opcodeName[0] == 's' && opcodeName[1] == 't')) {
-            size_t offset = 0UL;
-
-            if (line.find('+') != std::string::npos) {
-              auto number = GetNumber32(line.substr(line.find("+")), "+");
-              offset      = number.raw;
-            }
+          kBytes.emplace_back(0x00);
+          kBytes.emplace_back(rightReg);
+          kBytes.emplace_back(found_registers_index[0]);
+          kBytes.emplace_back(0x7c);
+        }
 
-            kBytes.push_back(offset);
-            kBytes.push_back(0x00);
-            kBytes.push_back(register_sum);
+        if ((opcodeName[0] == 's' && opcodeName[1] == 't')) {
+          size_t offset = 0UL;
 
-            kBytes.emplace_back(0x90);
+          if (line.find('+') != std::string::npos) {
+            auto number = GetNumber32(line.substr(line.find("+")), "+");
+            offset      = number.raw;
           }
 
-          if (opcodeName == "mr") {
-            if (register_count == 1) {
-              Detail::print_error("Too few registers. -> " + line, file);
-              throw std::runtime_error("too_few_registers");
-            }
-          }
+          kBytes.push_back(offset);
+          kBytes.push_back(0x00);
+          kBytes.push_back(register_sum);
 
-          // we're not in immediate addressing, reg to reg.
-          if (opcode_risc.ops->type != GREG) {
-            // remember! register to register!
-            if (found_some_count == 1) {
-              Detail::print_error(
-                  "Unrecognized register found.\ntip: each AssemblerPower register "
-                  "starts with 'r'.\nline: " +
-                      line,
-                  file);
-
-              throw std::runtime_error("not_a_register");
-            }
+          kBytes.emplace_back(0x90);
+        }
+
+        if (opcodeName == "mr") {
+          if (register_count == 1) {
+            Detail::print_error("Too few registers. -> " + line, file);
+            throw std::runtime_error("too_few_registers");
           }
+        }
 
-          if (found_some_count < 1 && name[0] != 'l' && name[0] != 's') {
-            Detail::print_error("invalid combination of opcode and registers.\nline: " + line,
-                                file);
-            throw std::runtime_error("invalid_comb_op_reg");
+        // we're not in immediate addressing, reg to reg.
+        if (opcode_risc.ops->type != GREG) {
+          // remember! register to register!
+          if (found_some_count == 1) {
+            Detail::print_error(
+                "Unrecognized register found.\ntip: each AssemblerPower register "
+                "starts with 'r'.\nline: " +
+                    line,
+                file);
+
+            throw std::runtime_error("not_a_register");
           }
+        }
 
-          break;
+        if (found_some_count < 1 && name[0] != 'l' && name[0] != 's') {
+          Detail::print_error("invalid combination of opcode and registers.\nline: " + line,
+                              file);
+          throw std::runtime_error("invalid_comb_op_reg");
         }
-      }
 
-      kOrigin += cPowerIPAlignment;
-      break;
+        break;
+      }
     }
+
+    kOrigin += cPowerIPAlignment;
+    break;
   }
 
   return true;
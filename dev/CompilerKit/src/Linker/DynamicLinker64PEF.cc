@@ -14,13 +14,24 @@
 /// It will be loaded when the program loader will start the image.
 
 #include <CompilerKit/AE.h>
+#include <CompilerKit/Archive.h>
 #include <CompilerKit/Compiler.h>
 #include <CompilerKit/Defines.h>
 #include <CompilerKit/ErrorID.h>
+#include <CompilerKit/Exports.h>
+#include <CompilerKit/Linker.h>
 #include <CompilerKit/PEF.h>
 #include <CompilerKit/UUID.h>
 #include <CompilerKit/Version.h>
+#include <CompilerKit/utils/Checksum.h>
 #include <CompilerKit/utils/CompilerUtils.h>
+#include <CompilerKit/utils/ImageWriter.h>
+#include <CompilerKit/utils/LinkState.h>
+#include <CompilerKit/utils/SymbolTable.h>
+#include <CompilerKit/utils/ThreadPool.h>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
 
 #define kLinkerVersionStr                                                                    \
   "NeKernel.org 64-Bit Linker (Preferred Executable Format) %s, (c) Amlal El Mahrouss, and " \
@@ -35,6 +46,13 @@
 #define kLinkerId (0x5046FF)
 #define kLinkerAbiContainer "__PEFContainer:ABI:"
 
+/// @brief AMD64 import stub: jmp [rip + pointer], then push index, jmp binder for lazy binding.
+#define kLinkerStubSize (16U)
+
+/// @brief -compress closes a range past this size, at an object boundary, so loaders can expand
+/// the ranges in parallel.
+#define kLinkerCompressedRange (1UL << 20)
+
 #define kPrintF printf
 #define kLinkerSplash() kConsoleOut << std::printf(kLinkerVersionStr, kDistVersion)
 
@@ -46,637 +64,3076 @@
              << "ld64: "   \
              << "\e[0;97m")
 
-enum {
-  kABITypeNull    = 0,
-  kABITypeStart   = 0x1010, /* The start of ABI list. */
-  kABITypeNE      = 0x5046, /* PF (NeKernel.org's PEF ABI) */
-  kABITypeInvalid = 0xFFFF,
-};
-
-static CompilerKit::STLString kOutput           = "a" kPefExt;
-static Int32                  kAbi              = kABITypeNE;
-static Int32                  kSubArch          = kPefNoSubCpu;
-static Int32                  kArch             = CompilerKit::kPefArchInvalid;
-static Bool                   kFatBinaryEnable  = false;
-static Bool                   kStartFound       = false;
-static Bool                   kDuplicateSymbols = false;
-
 /* ld64 is to be found, mld is to be found at runtime. */
 static const Char* kLdDefineSymbol = ":UndefinedSymbol:";
 static const Char* kLdDynamicSym   = ":RuntimeSymbol:";
 
-static CompilerKit::STLString kLinkerStart = kPefStart;
-
-/* object code and list. */
-static std::vector<CompilerKit::STLString>    kObjectList;
-static std::vector<Detail::DynamicLinkerBlob> kObjectBytes;
-
-///	@brief NE 64-bit Linker.
-/// @note This linker is made for PEF executable, thus NE based OSes.
-NECTI_MODULE(DynamicLinker64PEF) {
-  bool is_executable = true;
-
-  CompilerKit::install_signal(SIGSEGV, Detail::drvi_crash_handler);
-
-  /**
-   * @brief parse flags and trigger options.
-   */
-  for (size_t linker_arg = 1; linker_arg < argc; ++linker_arg) {
-    if (std::strcmp(argv[linker_arg], "-help") == 0) {
-      kLinkerSplash();
-
-      kConsoleOut << "-version: Show linker version.\n";
-      kConsoleOut << "-help: Show linker help.\n";
-      kConsoleOut << "-verbose: Enable linker trace.\n";
-      kConsoleOut << "-dylib: Output as a Dynamic PEF.\n";
-      kConsoleOut << "-fat: Output as a FAT PEF.\n";
-      kConsoleOut << "-32k: Output as a 32x0 PEF.\n";
-      kConsoleOut << "-64k: Output as a 64x0 PEF.\n";
-      kConsoleOut << "-amd64: Output as a AMD64 PEF.\n";
-      kConsoleOut << "-rv64: Output as a RISC-V PEF.\n";
-      kConsoleOut << "-power64: Output as a POWER PEF.\n";
-      kConsoleOut << "-arm64: Output as a ARM64 PEF.\n";
-      kConsoleOut << "-output: Select the output file name.\n";
+namespace CompilerKit {
+/// @brief Object parsed by one of the ingestion workers.
+struct LinkerObject final {
+  CompilerKit::Utils::AEMappedObject         fMap;
+  std::vector<CompilerKit::PEFCommandHeader> fHeaders;
+  std::vector<Int64>                         fRecordHeaders; /* record to header, or -1. */
+  std::vector<SizeType>                      fHeaderStarts;  /* header starts, in the code. */
+  Int32                                      fStatus{NECTI_SUCCESS};
+  Bool                                       fStartFound{false};
+  const Char*                                fFile{nullptr};  /* mapped from, null if in memory. */
+  SizeType                                   fFileStart{0UL}; /* where it starts in fFile. */
+  CompilerKit::STLString                     fBadRecord{}; /* record outside the code, if any. */
+};
+}  // namespace CompilerKit
 
-      return NECTI_SUCCESS;
-    } else if (std::strcmp(argv[linker_arg], "-version") == 0) {
-      kLinkerSplash();
+/// @brief Bytes a fixup writes.
+static SizeType ld_fixup_width(UInt16 kind) {
+  return kind == CompilerKit::kAERelocAbs64 ? sizeof(UInt64) : sizeof(UInt32);
+}
 
-      return NECTI_SUCCESS;
-    } else if (std::strcmp(argv[linker_arg], "-fat") == 0) {
-      kFatBinaryEnable = true;
+/// @brief Convert the records of a validated AE object.
+/// @note Runs on the worker pool, thus it only reads the linker options and writes to object.
+void CompilerKit::Linker::ConvertObject(LinkerObject& object) const {
+  const CompilerKit::AEHeader& hdr = *object.fMap.Header();
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-64k") == 0) {
-      kArch = CompilerKit::kPefArch64000;
+  if (hdr.fArch != fOptions.fArch) {
+    object.fStatus = NECTI_FAT_ERROR;
+    return;
+  }
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-amd64") == 0) {
-      kArch = CompilerKit::kPefArchAMD64;
+  auto ae_records = object.fMap.Records();
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-start") == 0) {
-      if (argv[linker_arg + 1] == nullptr || argv[linker_arg + 1][0] == '-') continue;
+  object.fHeaders.reserve(ae_records.size());
+  object.fRecordHeaders.resize(ae_records.size(), -1);
 
-      kLinkerStart = argv[linker_arg + 1];
-      linker_arg += 1;
+  auto code_size = object.fMap.Code().size();
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-32k") == 0) {
-      kArch = CompilerKit::kPefArch32000;
+  for (size_t ae_record_index = 0; ae_record_index < ae_records.size(); ++ae_record_index) {
+    CompilerKit::PEFCommandHeader command_header{0};
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-power64") == 0) {
-      kArch = CompilerKit::kPefArchPowerPC;
+    // the record's bytes, inside the code.
+    auto record      = ae_records[ae_record_index];
+    auto record_name = record.fName;
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-riscv64") == 0) {
-      kArch = CompilerKit::kPefArchRISCV;
+    if (record.fOffset > code_size || record.fSize > code_size - record.fOffset) {
+      object.fStatus    = NECTI_INVALID_DATA;
+      object.fBadRecord = record_name;
+      return;
+    }
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-arm64") == 0) {
-      kArch = CompilerKit::kPefArchARM64;
+    std::memcpy(command_header.Name, record_name.data(),
+                std::min<SizeType>(record_name.size(), kPefNameLen - 1));
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-verbose") == 0) {
-      kVerbose = true;
+    CompilerKit::STLString cmd_hdr_name(command_header.Name);
 
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-dylib") == 0) {
-      if (kOutput.empty()) {
-        continue;
+    // check this header if it's any valid.
+    if (cmd_hdr_name.find(kPefCode64) == CompilerKit::STLString::npos &&
+        cmd_hdr_name.find(kPefData64) == CompilerKit::STLString::npos &&
+        cmd_hdr_name.find(kPefZero64) == CompilerKit::STLString::npos) {
+      if (cmd_hdr_name.find(fOptions.fStart) == CompilerKit::STLString::npos &&
+          *command_header.Name == 0) {
+        if (cmd_hdr_name.find(kLdDefineSymbol) != CompilerKit::STLString::npos) {
+          goto ld_mark_header;
+        } else {
+          continue;
+        }
       }
+    }
 
-      if (kOutput.find(kPefExt) != CompilerKit::STLString::npos)
-        kOutput.erase(kOutput.find(kPefExt), strlen(kPefExt));
-
-      kOutput += kPefDylibExt;
-
-      is_executable = false;
-
-      continue;
-    } else if (std::strcmp(argv[linker_arg], "-output") == 0) {
-      if ((linker_arg + 1) > argc) continue;
-
-      kOutput = argv[linker_arg + 1];
-      ++linker_arg;
+    if (cmd_hdr_name.find(fOptions.fStart) != CompilerKit::STLString::npos &&
+        cmd_hdr_name.find(kPefCode64) != CompilerKit::STLString::npos) {
+      object.fStartFound = true;
+    }
 
-      continue;
-    } else {
-      if (argv[linker_arg][0] == '-') {
-        kConsoleOut << "unknown flag: " << argv[linker_arg] << "\n";
-        return EXIT_FAILURE;
-      }
+  ld_mark_header:
+    // the record's bytes, the layout gives them their place in the image, see step 4.5.
+    command_header.Kind        = record.fKind;
+    command_header.VirtualSize = record.fSize;
+    command_header.Cpu         = hdr.fArch;
+    command_header.SubCpu      = hdr.fSubArch;
+    command_header.OffsetSize  = record.fSize;
 
-      kObjectList.emplace_back(argv[linker_arg]);
+    object.fRecordHeaders[ae_record_index] = object.fHeaders.size();
 
-      continue;
-    }
+    object.fHeaders.emplace_back(command_header);
+    object.fHeaderStarts.push_back(record.fOffset);
   }
 
-  if (kOutput.empty()) {
-    kConsoleOut << "no output filename set." << std::endl;
-    return NECTI_EXEC_ERROR;
-  } else if (kObjectList.empty()) {
-    kConsoleOut << "no input files." << std::endl;
-    return NECTI_EXEC_ERROR;
-  } else {
-    namespace FS = std::filesystem;
-
-    // check for existing files, if they don't throw an error.
-    for (auto& obj : kObjectList) {
-      if (!FS::exists(obj)) {
-        // if filesystem doesn't find file
-        //          -> throw error.
-        kConsoleOut << "no such file: " << obj << std::endl;
-        return NECTI_EXEC_ERROR;
-      }
+  // every fixup must name a record we kept, and its place must be inside the code.
+  for (auto& reloc : object.fMap.Relocations()) {
+    if (reloc.fKind == CompilerKit::kAERelocInvalid || reloc.fKind >= CompilerKit::kAERelocCount ||
+        reloc.fRecord >= ae_records.size() || object.fRecordHeaders[reloc.fRecord] < 0 ||
+        reloc.fOffset > code_size || ld_fixup_width(reloc.fKind) > code_size - reloc.fOffset) {
+      object.fStatus = NECTI_INVALID_DATA;
+      return;
     }
   }
+}
 
-  // PEF expects a valid target architecture when outputing a binary.
-  if (kArch == CompilerKit::kPefArchInvalid) {
-    kConsoleOut << "no target architecture set, can't continue." << std::endl;
-    return NECTI_EXEC_ERROR;
-  }
+/// @brief Map, validate and convert the records of an AE object.
+void CompilerKit::Linker::IngestObject(const LinkerInput& input, LinkerObject& object) const {
+  // the mapping validates the header, the record table and the code range.
+  Int32 status = input.fBytes.empty() ? object.fMap.Open(input.fPath.c_str())
+                                      : object.fMap.Open(input.fBytes);
 
-  CompilerKit::PEFContainer pef_container{};
+  if (status != NECTI_SUCCESS) {
+    object.fStatus = NECTI_EXEC_ERROR;
+    return;
+  }
 
-  int32_t archs = kArch;
+  if (input.fBytes.empty()) object.fFile = input.fPath.c_str();
 
-  pef_container.Count    = 0UL;
-  pef_container.Kind     = is_executable ? CompilerKit::kPefKindExec : CompilerKit::kPefKindDylib;
-  pef_container.SubCpu   = kSubArch;
-  pef_container.Linker   = kLinkerId;  // Amlal El Mahrouss Linker
-  pef_container.Abi      = kAbi;       // Multi-Processor UX ABI
-  pef_container.Magic[0] = kPefMagic[kFatBinaryEnable ? 2 : 0];
-  pef_container.Magic[1] = kPefMagic[1];
-  pef_container.Magic[2] = kPefMagic[kFatBinaryEnable ? 0 : 2];
-  pef_container.Magic[3] = kPefMagic[3];
-  pef_container.Version  = kPefVersion;
+  this->ConvertObject(object);
 
-  // specify the start address, can be 0x10000
-  pef_container.Start    = kLinkerDefaultOrigin;
-  pef_container.HdrSz    = sizeof(CompilerKit::PEFContainer);
-  pef_container.Checksum = 0UL;
+  // streamed links read the code from the file when emitting, no need to keep what we read.
+  if (fOptions.fStreaming) object.fMap.Release();
+}
 
-  std::ofstream output_fc(kOutput, std::ofstream::binary);
+/// @brief Whether a header is an :UndefinedSymbol: one, those don't contain code.
+static Bool ld_is_undefined(const CompilerKit::PEFCommandHeader& command_hdr) {
+  std::string_view name(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
 
-  if (output_fc.bad()) {
-    if (kVerbose) {
-      kConsoleOut << "error: " << strerror(errno) << "\n";
-    }
+  return name.find(kLdDefineSymbol) != std::string_view::npos &&
+         name.find(kLdDynamicSym) == std::string_view::npos;
+}
 
-    return NECTI_FILE_NOT_FOUND;
-  }
+/// @brief Whether a header is the entrypoint, it is always a code64 container.
+Bool CompilerKit::Linker::IsStart(const PEFCommandHeader& command_hdr) const {
+  std::string_view name(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
 
-  //! Read AE to convert as PEF.
+  return name.find(fOptions.fStart) != std::string_view::npos &&
+         name.find(kPefCode64) != std::string_view::npos;
+}
 
-  std::vector<CompilerKit::PEFCommandHeader> command_headers;
-  CompilerKit::Utils::AEReadableProtocol     reader_protocol{};
+/// @brief Whether a header's name starts with prefix.
+static Bool ld_has_prefix(const CompilerKit::PEFCommandHeader& command_hdr, const Char* prefix) {
+  return std::strncmp(command_hdr.Name, prefix, strlen(prefix)) == 0;
+}
 
-  for (const auto& objectFile : kObjectList) {
-    if (!std::filesystem::exists(objectFile)) continue;
+/// @brief Drop the symbol off a header's name, ".code64$main" becomes ".code64".
+static void ld_strip_symbol(CompilerKit::PEFCommandHeader& command_hdr) {
+  auto symbol = std::find(command_hdr.Name, command_hdr.Name + kPefNameLen, '$');
 
-    CompilerKit::AEHeader hdr{};
+  std::fill(symbol, command_hdr.Name + kPefNameLen, 0);
+}
 
-    reader_protocol.file_pointer_ = std::ifstream(objectFile, std::ifstream::binary);
-    reader_protocol.file_pointer_ >> hdr;
+/// @brief Whether a header is a :RuntimeSymbol: one, the loader resolves those.
+static Bool ld_is_runtime(const CompilerKit::PEFCommandHeader& command_hdr) {
+  std::string_view name(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
 
-    if (hdr.fMagic[0] == kAEMag0 && hdr.fMagic[1] == kAEMag1 &&
-        hdr.fSize == sizeof(CompilerKit::AEHeader)) {
-      if (hdr.fArch != kArch) {
-        if (kVerbose) kConsoleOut << "is this a FAT binary? : ";
+  return name.find(kLdDynamicSym) != std::string_view::npos;
+}
 
-        if (!kFatBinaryEnable) {
-          if (kVerbose) kConsoleOut << "not a FAT binary.\n";
+/// @brief Symbol table key of a header, demangled and without its lookup prefix.
+/// @param undefined set when the header references the symbol instead of defining it.
+static CompilerKit::STLString ld_symbol_key(const CompilerKit::PEFCommandHeader& command_hdr,
+                                            Bool&                                undefined) {
+  std::string_view name(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
 
-          kConsoleOut << "object " << objectFile
-                      << " is a different kind of architecture and output isn't "
-                         "treated as a FAT binary."
-                      << std::endl;
+  undefined = false;
 
-          return NECTI_FAT_ERROR;
-        } else {
-          if (kVerbose) {
-            kConsoleOut << "Architecture matches what we expect.\n";
-          }
-        }
-      }
+  if (auto pos = name.find(kLdDefineSymbol);
+      pos != std::string_view::npos && name.find(kLdDynamicSym) == std::string_view::npos) {
+    undefined = true;
 
-      // append arch type to archs varaible.
-      archs |= hdr.fArch;
-      std::size_t cnt = hdr.fCount;
+    return CompilerKit::symbol_demangle(name.substr(pos + strlen(kLdDefineSymbol)));
+  }
 
-      if (kVerbose) kConsoleOut << "header found, record count: " << cnt << "\n";
+  return CompilerKit::symbol_demangle(name);
+}
 
-      pef_container.Count = cnt;
+/// @brief Pull in the library members defining a symbol that's still undefined, until the
+/// members pulled in don't reference anything new.
+/// @note Every lookup goes through a library's symbol directory, libraries are searched in
+/// command line order and the first one defining the symbol wins.
+Int32 CompilerKit::Linker::PullArchiveMembers(std::vector<LinkerObject>& objects) {
+  fArchiveMaps.resize(fArchiveList.size());
 
-      Char* raw_ae_records = new Char[cnt * sizeof(CompilerKit::AERecordHeader)];
+  std::vector<std::vector<Bool>> pulled(fArchiveList.size());
 
-      if (!raw_ae_records) {
-        if (kVerbose) kConsoleOut << "allocation failed for records of count: " << cnt << "\n";
-      }
+  for (SizeType archive_index = 0UL; archive_index < fArchiveList.size(); ++archive_index) {
+    auto& archive = fArchiveList[archive_index];
 
-      std::memset(raw_ae_records, 0, cnt * sizeof(CompilerKit::AERecordHeader));
+    Int32 status = archive.fBytes.empty() ? fArchiveMaps[archive_index].Open(archive.fPath.c_str())
+                                          : fArchiveMaps[archive_index].Open(archive.fBytes);
 
-      auto* ae_records = reader_protocol.Read(raw_ae_records, cnt);
+    if (status != NECTI_SUCCESS) {
+      kConsoleOut << "not a static library: " << archive.fPath << std::endl;
+      return NECTI_EXEC_ERROR;
+    }
 
-      size_t org = kLinkerDefaultOrigin;
+    pulled[archive_index].resize(fArchiveMaps[archive_index].Members().size(), false);
+  }
 
-      for (size_t ae_record_index = 0; ae_record_index < cnt; ++ae_record_index) {
-        CompilerKit::PEFCommandHeader command_header{0};
-        std::size_t                   offset_of_obj = ae_records[ae_record_index].fOffset;
+  CompilerKit::SymbolTable           symbol_table;
+  std::vector<CompilerKit::SymbolId> pending;
 
-        std::memcpy(command_header.Name, ae_records[ae_record_index].fName, kPefNameLen);
+  for (SizeType scanned = 0UL; scanned < objects.size();) {
+    for (; scanned < objects.size(); ++scanned) {
+      for (auto& command_hdr : objects[scanned].fHeaders) {
+        if (*command_hdr.Name == 0) continue;
 
-        CompilerKit::STLString cmd_hdr_name(command_header.Name);
+        Bool undefined = false;
+        auto id        = symbol_table.Intern(ld_symbol_key(command_hdr, undefined));
 
-        // check this header if it's any valid.
-        if (cmd_hdr_name.find(kPefCode64) == CompilerKit::STLString::npos &&
-            cmd_hdr_name.find(kPefData64) == CompilerKit::STLString::npos &&
-            cmd_hdr_name.find(kPefZero64) == CompilerKit::STLString::npos) {
-          if (cmd_hdr_name.find(kLinkerStart) == CompilerKit::STLString::npos &&
-              *command_header.Name == 0) {
-            if (cmd_hdr_name.find(kLdDefineSymbol) != CompilerKit::STLString::npos) {
-              goto ld_mark_header;
-            } else {
-              continue;
-            }
-          }
+        if (!undefined) {
+          ++symbol_table[id].fDefCount;
+        } else if (!symbol_table[id].fReferenced) {
+          symbol_table[id].fReferenced = true;
+          pending.push_back(id);
         }
+      }
+    }
 
-        if (cmd_hdr_name.find(kLinkerStart) != CompilerKit::STLString::npos &&
-            cmd_hdr_name.find(kPefCode64) != CompilerKit::STLString::npos) {
-          kStartFound = true;
-        }
+    std::vector<std::pair<SizeType, UInt32>> members;
 
-      ld_mark_header:
-        command_header.Offset         = offset_of_obj;
-        command_header.Kind           = ae_records[ae_record_index].fKind;
-        command_header.VirtualSize    = ae_records[ae_record_index].fSize;
-        command_header.Cpu            = hdr.fArch;
-        command_header.VirtualAddress = org;
-        command_header.SubCpu         = hdr.fSubArch;
-        command_header.OffsetSize     = ae_records[ae_record_index].fSize;
+    for (auto id : pending) {
+      if (symbol_table[id].fDefCount > 0) continue;
 
-        org += command_header.VirtualSize;
+      for (SizeType archive_index = 0UL; archive_index < fArchiveMaps.size(); ++archive_index) {
+        UInt32 member = fArchiveMaps[archive_index].Find(symbol_table[id].fName);
 
-        if (kVerbose) {
-          kConsoleOut << "Record: " << ae_records[ae_record_index].fName << " is marked.\n";
-          kConsoleOut << "Offset: " << command_header.Offset << "\n";
+        if (member == kLibNoMember) continue;
+
+        if (!pulled[archive_index][member]) {
+          pulled[archive_index][member] = true;
+          members.emplace_back(archive_index, member);
         }
 
-        command_headers.emplace_back(command_header);
+        break;
       }
+    }
 
-      delete[] raw_ae_records;
-      raw_ae_records = nullptr;
+    pending.clear();
 
-      std::vector<char> bytes;
-      bytes.resize(hdr.fCodeSize);
+    SizeType first = objects.size();
 
-      reader_protocol.file_pointer_.seekg(std::streamsize(hdr.fStartCode));
-      reader_protocol.file_pointer_.read(bytes.data(), std::streamsize(hdr.fCodeSize));
+    for (auto& [archive_index, member] : members) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "pulling " << fArchiveMaps[archive_index].MemberName(member) << " from "
+                    << fArchiveList[archive_index].fPath << "\n";
 
-      kObjectBytes.push_back({.mBlob = bytes, .mOffset = hdr.fStartCode});
+      fObjectList.push_back(fArchiveList[archive_index].fPath + "(" +
+                            CompilerKit::STLString(fArchiveMaps[archive_index].MemberName(member)) +
+                            ")");
+      objects.emplace_back();
+    }
 
-      // Blob was written, close fp.
+    CompilerKit::Utils::pool_for_each(members.size(), fOptions.fJobs, [&](SizeType index) {
+      auto& [archive_index, member] = members[index];
+      auto& object                  = objects[first + index];
 
-      reader_protocol.file_pointer_.close();
+      auto& archive_map = fArchiveMaps[archive_index];
 
-      continue;
-    }
+      if (object.fMap.Open(archive_map.MemberBytes(member)) != NECTI_SUCCESS) {
+        object.fStatus = NECTI_EXEC_ERROR;
+        return;
+      }
 
-    kConsoleOut << "not an object container: " << objectFile << std::endl;
+      if (fArchiveList[archive_index].fBytes.empty()) {
+        object.fFile      = fArchiveList[archive_index].fPath.c_str();
+        object.fFileStart = archive_map.MemberBytes(member).data() -
+                            reinterpret_cast<const Char*>(archive_map.Header());
+      }
 
-    // don't continue, it is a fatal error.
-    return NECTI_EXEC_ERROR;
+      this->ConvertObject(object);
+    });
   }
 
-  pef_container.Cpu = archs;
+  return NECTI_SUCCESS;
+}
 
-  output_fc << pef_container;
+/// @brief Hash of every option the image depends on, for incremental links and reproducible GUIDs.
+/// @note fOutput, fVerbose, fJobs, fPreallocate and fStreaming don't change the bytes, only how
+/// they are read and written, they are left out.
+UInt64 CompilerKit::Linker::OptionsHash() const {
+  CompilerKit::STLString options =
+      std::to_string(fOptions.fArch) + ":" + std::to_string(fOptions.fSubArch) + ":" +
+      std::to_string(fOptions.fAbi) + ":" + std::to_string(fOptions.fFatBinary) + ":" +
+      std::to_string(fOptions.fExecutable) + ":" + std::to_string(fOptions.fIncremental) + ":" +
+      std::to_string(fOptions.fIncrementalSlack) + ":" + std::to_string(fOptions.fGCSections) +
+      ":" + std::to_string(fOptions.fICFMode) + ":" + std::to_string(fOptions.fPageSize) + ":" +
+      std::to_string(fOptions.fCompress) + ":" + std::to_string(fOptions.fSplitDebug) + ":" +
+      std::to_string(fOptions.fReproducible) + ":" + std::to_string(fOptions.fBindNow) + ":" +
+      fOptions.fStart;
+
+  for (auto& symbol : fOptions.fOrderSymbols) options += ":" + symbol;
+
+  return CompilerKit::symbol_hash(options);
+}
 
-  if (kVerbose) {
-    kConsoleOut << "wrote container to: " << output_fc.tellp() << ".\n";
+/// @brief Read the code symbols to lay out first.
+/// @param profile the file holds `symbol count` lines from an instrumented build, the symbols are
+/// ordered by descending count and the ones never hit are left out. Otherwise it holds a symbol per
+/// line, in layout order.
+/// @note `#` starts a comment.
+Int32 CompilerKit::linker_read_order_file(const STLString& path, Bool profile,
+                                          std::vector<STLString>& symbols) {
+  std::ifstream file(path);
+
+  if (!file) {
+    kConsoleOut << "no such order file: " << path << std::endl;
+    return NECTI_EXEC_ERROR;
   }
 
-  output_fc.seekp(std::streamsize(pef_container.HdrSz));
-
-  std::vector<CompilerKit::STLString> not_found;
-  std::vector<CompilerKit::STLString> symbols;
-
-  // step 2: check for errors (multiple symbols, undefined ones)
+  std::vector<std::pair<CompilerKit::STLString, UInt64>> entries;
+  CompilerKit::STLString                                 line;
 
-  CompilerKit::STLString cmd_hdr_name;
+  for (SizeType line_number = 1UL; std::getline(file, line); ++line_number) {
+    if (auto comment = line.find('#'); comment != CompilerKit::STLString::npos)
+      line.erase(comment);
 
-  for (auto& command_hdr : command_headers) {
-    // check if this symbol needs to be resolved.
-    if (CompilerKit::STLString(command_hdr.Name).find(kLdDefineSymbol) !=
-            CompilerKit::STLString::npos &&
-        CompilerKit::STLString(command_hdr.Name).find(kLdDynamicSym) ==
-            CompilerKit::STLString::npos) {
-      if (kVerbose) kConsoleOut << "Found undefined symbol: " << command_hdr.Name << "\n";
+    std::istringstream     fields(line);
+    CompilerKit::STLString symbol;
+    UInt64                 count = 0UL;
 
-      cmd_hdr_name = command_hdr.Name;
+    if (!(fields >> symbol)) continue;
 
-      if (auto it = std::find(not_found.begin(), not_found.end(), cmd_hdr_name);
-          it == not_found.end()) {
-        not_found.emplace_back(cmd_hdr_name);
-      }
+    if (profile && !(fields >> count)) {
+      kConsoleOut << path << ":" << line_number << ": expected a symbol and its hit count.\n";
+      return NECTI_EXEC_ERROR;
     }
 
-    symbols.emplace_back(command_hdr.Name);
-  }
+    if (profile && count == 0UL) continue;
 
-  // Now try to solve these symbols.
+    entries.emplace_back(std::move(symbol), count);
+  }
 
-  for (size_t not_found_idx = 0; not_found_idx < command_headers.size(); ++not_found_idx) {
-    if (const auto it = std::find(not_found.begin(), not_found.end(),
-                                  CompilerKit::STLString(command_headers[not_found_idx].Name));
-        it != not_found.end()) {
-      CompilerKit::STLString symbol_imp = *it;
+  if (profile) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](auto& lhs, auto& rhs) { return lhs.second > rhs.second; });
+  }
 
-      if (symbol_imp.find(kLdDefineSymbol) == CompilerKit::STLString::npos) continue;
+  for (auto& [symbol, count] : entries) symbols.push_back(std::move(symbol));
 
-      // erase the lookup prefix.
-      symbol_imp.erase(0, symbol_imp.find(kLdDefineSymbol) + strlen(kLdDefineSymbol));
+  return NECTI_SUCCESS;
+}
 
-      // demangle everything.
-      while (symbol_imp.find('$') != CompilerKit::STLString::npos)
-        symbol_imp.erase(symbol_imp.find('$'), 1);
+/// @brief Layout order of the ranges: the ones defining the order file's code symbols first, in
+/// its order, then the others in input order.
+/// @note A range is the unit of layout, see LinkerRange, so a function of a split object goes
+/// where it is listed, and a whole object where its first listed symbol does. A folded range
+/// places its target instead.
+std::vector<SizeType> CompilerKit::Linker::LayoutOrder(
+    const std::vector<PEFCommandHeader>&              command_headers,
+    const std::vector<std::pair<SizeType, SizeType>>& symbol_places,
+    const std::vector<SizeType>& folded_into, SymbolTable& symbol_table) const {
+  SizeType              object_count = folded_into.size();
+  std::vector<SizeType> order;
+  std::vector<Bool>     placed(object_count, false);
+  SizeType              missing = 0UL;
+
+  order.reserve(object_count);
+
+  for (auto& symbol : fOptions.fOrderSymbols) {
+    auto id = symbol_table.Find(CompilerKit::symbol_demangle(kPefCode64 + symbol));
+
+    if (id == CompilerKit::kSymbolInvalid)
+      id = symbol_table.Find(CompilerKit::symbol_demangle(symbol));
+
+    if (id == CompilerKit::kSymbolInvalid || symbol_table[id].fDefinition < 0 ||
+        command_headers[symbol_table[id].fDefinition].Kind != CompilerKit::kPefCode) {
+      if (fOptions.fVerbose) kConsoleOut << "order-file: no code symbol " << symbol << "\n";
+
+      ++missing;
+      continue;
+    }
 
-      // the reason we do is because, this may not match the symbol, and we need
-      // to look for other matching symbols.
-      for (auto& command_hdr : command_headers) {
-        if (CompilerKit::STLString(command_hdr.Name).find(symbol_imp) !=
-                CompilerKit::STLString::npos &&
-            CompilerKit::STLString(command_hdr.Name).find(kLdDefineSymbol) ==
-                CompilerKit::STLString::npos) {
-          CompilerKit::STLString undefined_symbol = command_hdr.Name;
-          auto result_of_sym = undefined_symbol.substr(undefined_symbol.find(symbol_imp));
+    auto object_index = symbol_places[id].first;
 
-          for (int i = 0; result_of_sym[i] != 0; ++i) {
-            if (result_of_sym[i] != symbol_imp[i]) goto ld_continue_search;
-          }
+    if (folded_into[object_index] != object_count) object_index = folded_into[object_index];
 
-          not_found.erase(it);
+    if (placed[object_index]) continue;
 
-          if (kVerbose) kConsoleOut << "Found symbol: " << command_hdr.Name << "\n";
+    placed[object_index] = true;
+    order.push_back(object_index);
+  }
 
-          break;
-        }
-      }
+  if (fOptions.fVerbose)
+    kConsoleOut << "order-file: " << order.size() << " range(s) placed first, " << missing
+                << " symbol(s) not found.\n";
 
-    ld_continue_search:
-      continue;
-    }
+  for (SizeType object_index = 0UL; object_index < object_count; ++object_index) {
+    if (!placed[object_index]) order.push_back(object_index);
   }
 
-  // step 3: check for errors (recheck if we have those symbols.)
+  return order;
+}
 
-  if (!kStartFound && is_executable) {
-    if (kVerbose)
-      kConsoleOut << "Undefined entrypoint: " << kLinkerStart
-                  << ", you may have forget to link "
-                     "against the C++ runtime library.\n";
+/// @brief Hash of an object's record names and kinds, as long as it doesn't change neither does
+/// the symbol table.
+static UInt64 ld_object_signature(const CompilerKit::LinkerObject& object) {
+  CompilerKit::STLString signature;
 
-    kConsoleOut << "Undefined entrypoint " << kLinkerStart << " for executable: " << kOutput
-                << "\n";
+  for (auto& command_hdr : object.fHeaders) {
+    signature.append(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
+    signature += ":" + std::to_string(command_hdr.Kind) + ";";
   }
 
-  // step 4: write all PEF commands.
+  return CompilerKit::symbol_hash(signature);
+}
 
-  CompilerKit::PEFCommandHeader date_cmd_hdr{};
+/// @brief Where an object's code splits into ranges, the start of every record unless a record or
+/// a fixup spans it. The first range always starts at 0.
+/// @note Only objects whose sections all carry kAESectionSplit are split, the others may reach
+/// their own records without a relocation.
+static std::vector<SizeType> ld_object_cuts(const CompilerKit::LinkerObject& object) {
+  std::vector<SizeType> cuts{0UL};
 
-  time_t timestamp = time(nullptr);
+  auto sections = object.fMap.Sections();
 
-  CompilerKit::STLString timeStampStr = "Container:BuildEpoch:";
-  timeStampStr += std::to_string(timestamp);
+  if (sections.empty() || std::any_of(sections.begin(), sections.end(), [](auto& section) {
+        return !(section.fFlags & kAESectionSplit);
+      }))
+    return cuts;
 
-  strncpy(date_cmd_hdr.Name, timeStampStr.c_str(), timeStampStr.size());
+  for (SizeType index = 0UL; index < object.fHeaders.size(); ++index) {
+    if (!ld_is_undefined(object.fHeaders[index]) && object.fHeaders[index].VirtualSize > 0)
+      cuts.push_back(object.fHeaderStarts[index]);
+  }
 
-  date_cmd_hdr.Flags       = 0;
-  date_cmd_hdr.Kind        = CompilerKit::kPefZero;
-  date_cmd_hdr.Offset      = output_fc.tellp();
-  date_cmd_hdr.VirtualSize = timeStampStr.size();
+  std::sort(cuts.begin(), cuts.end());
+  cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
 
-  command_headers.push_back(date_cmd_hdr);
+  // bytes from start to end must stay together.
+  auto ld_keep = [&](SizeType start, SizeType end) {
+    auto cut = std::upper_bound(cuts.begin(), cuts.end(), start);
 
-  CompilerKit::PEFCommandHeader abi_cmd_hdr{};
+    while (cut != cuts.end() && *cut < end) cut = cuts.erase(cut);
+  };
 
-  CompilerKit::STLString abi = kLinkerAbiContainer;
+  for (SizeType index = 0UL; index < object.fHeaders.size(); ++index) {
+    if (!ld_is_undefined(object.fHeaders[index]))
+      ld_keep(object.fHeaderStarts[index],
+              object.fHeaderStarts[index] + object.fHeaders[index].VirtualSize);
+  }
 
-  switch (kArch) {
-    case CompilerKit::kPefArchAMD64: {
-      abi += "MSFT";
-      break;
-    }
-    case CompilerKit::kPefArchPowerPC: {
-      abi += "SYSV";
-      break;
-    }
-    case CompilerKit::kPefArch32000:
-    case CompilerKit::kPefArch64000: {
-      abi += "_NEP";
-      break;
-    }
-    default: {
-      abi += "_IDK";
-      break;
+  for (auto& reloc : object.fMap.Relocations())
+    ld_keep(reloc.fOffset, reloc.fOffset + ld_fixup_width(reloc.fKind));
+
+  return cuts;
+}
+
+/// @brief Mark the ranges reachable from the entrypoint, or from the exported symbols of a dylib.
+/// @note A range is the unit of collection, see LinkerRange. It reaches what its fixups land on,
+/// and the definitions of its :UndefinedSymbol: records.
+std::vector<Bool> CompilerKit::Linker::ReachableObjects(
+    const std::vector<PEFCommandHeader>&              command_headers,
+    const std::vector<std::pair<SizeType, SizeType>>& object_ranges,
+    const std::vector<SymbolId>& header_symbols, SymbolTable& symbol_table) const {
+  std::vector<SizeType> owners(command_headers.size(), object_ranges.size());
+
+  for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+    for (auto index = object_ranges[object_index].first; index < object_ranges[object_index].second;
+         ++index) {
+      owners[index] = object_index;
     }
   }
 
-  std::memcpy(abi_cmd_hdr.Name, abi.c_str(), abi.size());
-
-  abi_cmd_hdr.VirtualSize = abi.size();
-  abi_cmd_hdr.Offset      = output_fc.tellp();
-  abi_cmd_hdr.Flags       = 0;
-  abi_cmd_hdr.Kind        = CompilerKit::kPefLinkerID;
+  std::vector<Bool>     live(object_ranges.size(), false);
+  std::vector<SizeType> worklist;
 
-  command_headers.push_back(abi_cmd_hdr);
+  auto ld_mark = [&](SizeType object_index) {
+    if (object_index >= live.size() || live[object_index]) return;
 
-  CompilerKit::PEFCommandHeader stack_cmd_hdr{0};
+    live[object_index] = true;
+    worklist.push_back(object_index);
+  };
 
-  stack_cmd_hdr.Cpu         = kArch;
-  stack_cmd_hdr.Flags       = 0;
-  stack_cmd_hdr.VirtualSize = sizeof(uintptr_t);
-  stack_cmd_hdr.Offset      = 0;
+  // seed: the entrypoint, or every defined symbol of a dylib, as they're all exported.
+  for (SizeType index = 0UL; index < command_headers.size(); ++index) {
+    if (fOptions.fExecutable ? this->IsStart(command_headers[index])
+                             : (header_symbols[index] != CompilerKit::kSymbolInvalid &&
+                                !ld_is_undefined(command_headers[index]))) {
+      ld_mark(owners[index]);
+    }
+  }
 
-  std::memcpy(stack_cmd_hdr.Name, kLinkerStackSizeSymbol, strlen(kLinkerStackSizeSymbol));
+  // follow the fixups and :UndefinedSymbol: records of every live range to their definitions.
+  while (!worklist.empty()) {
+    auto object_index = worklist.back();
+    worklist.pop_back();
 
-  command_headers.push_back(stack_cmd_hdr);
+    for (auto fixup = fObjectFixups[object_index].first;
+         fixup < fObjectFixups[object_index].second; ++fixup) {
+      auto& entry = fFixups[fixup];
 
-  CompilerKit::PEFCommandHeader uuid_cmd_hdr{};
+      // the import is written along with any live header of it, this object's will do.
+      if (entry.fRuntime != CompilerKit::kSymbolInvalid)
+        ld_mark(owners[entry.fHeader]);
+      else
+        ld_mark(entry.fTarget);
+    }
 
-  std::random_device rd;
+    for (auto index = object_ranges[object_index].first; index < object_ranges[object_index].second;
+         ++index) {
+      if (header_symbols[index] == CompilerKit::kSymbolInvalid ||
+          !ld_is_undefined(command_headers[index]))
+        continue;
 
-  auto seedData = std::array<int, std::mt19937::state_size>{};
-  std::generate(std::begin(seedData), std::end(seedData), std::ref(rd));
-  std::seed_seq seq(std::begin(seedData), std::end(seedData));
-  std::mt19937  generator(seq);
+      auto& entry = symbol_table[header_symbols[index]];
 
-  auto        gen     = uuids::uuid_random_generator{generator};
-  uuids::uuid id      = gen();
-  auto        uuidStr = uuids::to_string(id);
+      if (entry.fDefinition >= 0) ld_mark(owners[entry.fDefinition]);
+    }
+  }
 
-  std::memcpy(uuid_cmd_hdr.Name, "Container:GUID:4:", strlen("Container:GUID:4:"));
-  std::memcpy(uuid_cmd_hdr.Name + strlen("Container:GUID:4:"), uuidStr.c_str(), uuidStr.size());
+  return live;
+}
 
-  uuid_cmd_hdr.VirtualSize = strlen(uuid_cmd_hdr.Name);
-  uuid_cmd_hdr.Offset      = output_fc.tellp();
-  uuid_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
-  uuid_cmd_hdr.Kind        = CompilerKit::kPefZero;
+/// @brief Find the code ranges that are byte for byte identical to an earlier one.
+/// @return for every range, the range it folds into, or object_ranges.size() if it stays.
+/// @note Two ranges fold when their bytes, record layout, fixups and undefined symbols all match,
+/// and every record they write is code, their symbols then alias the kept range's. In safe mode,
+/// ranges whose symbols may have their address taken are kept: the entrypoint, dylib exports,
+/// symbols referenced by ranges with data, and the targets of absolute fixups.
+std::vector<SizeType> CompilerKit::Linker::FoldIdenticalObjects(
+    const std::vector<PEFCommandHeader>&              command_headers,
+    const std::vector<std::pair<SizeType, SizeType>>& object_ranges,
+    const std::vector<SizeType>& header_starts, const std::vector<SymbolId>& header_symbols,
+    SymbolTable& symbol_table) const {
+  SizeType              object_count = object_ranges.size();
+  std::vector<SizeType> folded_into(object_count, object_count);
+  std::vector<Bool>     address_taken(symbol_table.Count(), false);
+  std::vector<Bool>     target_taken(object_count, false);
+  std::vector<Bool>     candidate(object_count, false);
+
+  for (SizeType object_index = 0UL; object_index < object_count; ++object_index) {
+    auto [first, last] = object_ranges[object_index];
+
+    Bool has_code = false, has_data = false;
+
+    for (auto index = first; index < last; ++index) {
+      if (ld_is_undefined(command_headers[index])) continue;
+
+      if (command_headers[index].Kind == CompilerKit::kPefCode)
+        has_code = true;
+      else
+        has_data = true;
+    }
 
-  command_headers.push_back(uuid_cmd_hdr);
+    candidate[object_index] = has_code && !has_data && !fObjectBytes[object_index].mBlob.empty();
 
-  // prepare a symbol vector.
-  std::vector<CompilerKit::STLString> undef_symbols;
-  std::vector<CompilerKit::STLString> dupl_symbols;
-  std::vector<CompilerKit::STLString> resolve_symbols;
+    for (auto index = first; index < last; ++index) {
+      if (header_symbols[index] == CompilerKit::kSymbolInvalid) continue;
 
-  constexpr Int32 kPaddingOffset = 16;
+      Bool undefined = ld_is_undefined(command_headers[index]);
 
-  size_t previous_offset =
-      (command_headers.size() * sizeof(CompilerKit::PEFCommandHeader)) + kPaddingOffset;
+      if ((has_data && undefined) ||
+          (!undefined && (!fOptions.fExecutable || this->IsStart(command_headers[index])))) {
+        address_taken[header_symbols[index]] = true;
+      }
+    }
 
-  CompilerKit::PEFCommandHeader end_exec_hdr;
+    // a pointer stored as data, or an address loaded by the code, unlike a call's rel32.
+    for (auto fixup = fObjectFixups[object_index].first;
+         fixup < fObjectFixups[object_index].second; ++fixup) {
+      auto& entry = fFixups[fixup];
 
-  end_exec_hdr.Offset = output_fc.tellp();
-  end_exec_hdr.Flags  = CompilerKit::kPefLinkerID;
-  end_exec_hdr.Kind   = CompilerKit::kPefZero;
+      if (entry.fRuntime == CompilerKit::kSymbolInvalid &&
+          (has_data || entry.fKind != CompilerKit::kAERelocRel32))
+        target_taken[entry.fTarget] = true;
+    }
+  }
 
-  std::memcpy(end_exec_hdr.Name, "Container:Exec:END", strlen("Container:Exec:END"));
+  /// @brief Folding key, the shape of a range besides its own symbol names.
+  auto ld_fold_key = [&](SizeType object_index) {
+    auto blob = fObjectBytes[object_index].mBlob;
 
-  end_exec_hdr.VirtualSize = strlen(end_exec_hdr.Name);
+    CompilerKit::STLString key(blob.data(), blob.size());
 
-  command_headers.push_back(end_exec_hdr);
+    for (auto index = object_ranges[object_index].first; index < object_ranges[object_index].second;
+         ++index) {
+      auto& command_hdr = command_headers[index];
 
-  // Finally write down the command headers.
-  // And check for any duplications
-  for (size_t commandHeaderIndex = 0UL; commandHeaderIndex < command_headers.size();
-       ++commandHeaderIndex) {
-    if (CompilerKit::STLString(command_headers[commandHeaderIndex].Name).find(kLdDefineSymbol) !=
-            CompilerKit::STLString::npos &&
-        CompilerKit::STLString(command_headers[commandHeaderIndex].Name).find(kLdDynamicSym) ==
-            CompilerKit::STLString::npos) {
-      // ignore :UndefinedSymbol: headers, they do not contain code.
-      continue;
+      if (ld_is_undefined(command_hdr)) {
+        key += ":" + symbol_table[header_symbols[index]].fName;
+      } else {
+        key += ";" + std::to_string(command_hdr.Kind) + "/" + std::to_string(header_starts[index]) +
+               "/" + std::to_string(command_hdr.VirtualSize);
+      }
     }
 
-    CompilerKit::STLString symbol_name = command_headers[commandHeaderIndex].Name;
+    // the placeholders are zeros, what they become is part of the shape too.
+    for (auto fixup = fObjectFixups[object_index].first;
+         fixup < fObjectFixups[object_index].second; ++fixup) {
+      auto& entry = fFixups[fixup];
+
+      key += "@" + std::to_string(entry.fOffset) + "/" + std::to_string(entry.fKind) + "/" +
+             std::to_string(entry.fAddend) + "/";
 
-    if (!symbol_name.empty()) {
-      undef_symbols.emplace_back(symbol_name);
+      if (entry.fRuntime != CompilerKit::kSymbolInvalid)
+        key += symbol_table[entry.fRuntime].fName;
+      else
+        key += (entry.fTarget == object_index ? "self" : std::to_string(entry.fTarget)) + "+" +
+               std::to_string(entry.fTargetStart);
     }
 
-    command_headers[commandHeaderIndex].Offset += previous_offset;
-    previous_offset += command_headers[commandHeaderIndex].VirtualSize;
+    return key;
+  };
 
-    CompilerKit::STLString name = command_headers[commandHeaderIndex].Name;
+  // ranges with the same key hash, their keys are built again to compare so that the buckets
+  // don't hold a copy of every candidate's code.
+  std::unordered_map<UInt64, std::vector<SizeType>> buckets;
 
-    /// so this is valid when we get to the entrypoint.
-    /// it is always a code64 container. And should equal to kLinkerStart as well.
-    /// this chunk of code updates the pef_container.Start with the updated offset.
-    if (name.find(kLinkerStart) != CompilerKit::STLString::npos &&
-        name.find(kPefCode64) != CompilerKit::STLString::npos) {
-      pef_container.Start = command_headers[commandHeaderIndex].Offset;
-      auto tellCurPos     = output_fc.tellp();
+  for (SizeType object_index = 0UL; object_index < object_count; ++object_index) {
+    if (!candidate[object_index]) continue;
 
-      output_fc.seekp(0);
-      output_fc << pef_container;
+    if (fOptions.fICFMode == kICFSafe) {
+      Bool taken = target_taken[object_index];
 
-      output_fc.seekp(tellCurPos);
-    }
+      for (auto index = object_ranges[object_index].first;
+           index < object_ranges[object_index].second; ++index) {
+        if (!ld_is_undefined(command_headers[index]) &&
+            header_symbols[index] != CompilerKit::kSymbolInvalid &&
+            address_taken[header_symbols[index]])
+          taken = true;
+      }
 
-    if (kVerbose) {
-      kConsoleOut << "Command name: " << name << "\n";
-      kConsoleOut << "VirtualAddress of command content: "
-                  << command_headers[commandHeaderIndex].Offset << "\n";
+      if (taken) continue;
     }
 
-    output_fc << command_headers[commandHeaderIndex];
+    auto  key    = ld_fold_key(object_index);
+    auto& bucket = buckets[CompilerKit::symbol_hash(key)];
 
-    for (size_t sub_command_header_index = 0UL; sub_command_header_index < command_headers.size();
-         ++sub_command_header_index) {
-      if (sub_command_header_index == commandHeaderIndex) continue;
+    for (auto target : bucket) {
+      Bool same = ld_fold_key(target) == key;
 
-      if (CompilerKit::STLString(command_headers[sub_command_header_index].Name)
-                  .find(kLdDefineSymbol) != CompilerKit::STLString::npos &&
-          CompilerKit::STLString(command_headers[sub_command_header_index].Name)
-                  .find(kLdDynamicSym) == CompilerKit::STLString::npos) {
-        if (kVerbose) {
-          kConsoleOut << "Ignoring :UndefinedSymbol: headers...\n";
-        }
+      if (fOptions.fStreaming) fObjectMaps[fRanges[target].fObject].Release();
 
-        // ignore :UndefinedSymbol: headers, they do not contain code.
-        continue;
+      if (same) {
+        folded_into[object_index] = target;
+        break;
       }
+    }
 
-      auto& command_hdr = command_headers[sub_command_header_index];
+    if (folded_into[object_index] == object_count) bucket.push_back(object_index);
 
-      if (command_hdr.Name == CompilerKit::STLString(command_headers[commandHeaderIndex].Name)) {
-        if (std::find(dupl_symbols.cbegin(), dupl_symbols.cend(), command_hdr.Name) ==
-            dupl_symbols.cend()) {
-          dupl_symbols.emplace_back(command_hdr.Name);
-        }
+    if (fOptions.fStreaming) fObjectMaps[fRanges[object_index].fObject].Release();
+  }
 
-        if (kVerbose) kConsoleOut << "Found duplicate symbols of: " << command_hdr.Name << "\n";
+  return folded_into;
+}
 
-        kDuplicateSymbols = true;
-      }
+/// @brief Protection of the segment an object goes to, from the kinds of records it writes.
+/// @note An object has a single blob, so one mixing code and data gets both protections.
+static UInt32 ld_object_protection(
+    const std::vector<CompilerKit::PEFCommandHeader>& command_headers,
+    std::pair<SizeType, SizeType>                     range) {
+  UInt32 protection = 0U;
+
+  for (auto index = range.first; index < range.second; ++index) {
+    if (ld_is_undefined(command_headers[index])) continue;
+
+    switch (command_headers[index].Kind) {
+      case CompilerKit::kPefCode:
+        protection |= CompilerKit::kPefFlagRead | CompilerKit::kPefFlagExec;
+        break;
+      case CompilerKit::kPefData:
+        protection |= CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite;
+        break;
+      default:
+        break;
     }
   }
 
-  if (!dupl_symbols.empty()) {
-    for (auto& symbol : dupl_symbols) {
-      kConsoleOut << "Multiple symbols of: " << symbol << " detected, cannot continue.\n";
-    }
+  if (protection != 0U) return protection;
 
-    return NECTI_EXEC_ERROR;
-  }
+  // nothing but .zero64 records, no file bytes at all.
+  return CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite | CompilerKit::kPefFlagZeroFill;
+}
 
-  // step 2.5: write program bytes.
+/// @brief Write the import stubs, their pointers and the import table, once they're placed.
+/// @note A stub is `jmp [rip + pointer]`, then `push index; jmp binder`, where a lazy pointer
+/// starts out. Stub 0 is the binder itself, `jmp [rip + pointer 0]`, padded with int3.
+void CompilerKit::Linker::WriteImports(const std::vector<SymbolId>& imports,
+                                       const std::vector<UInt32>&   import_slots,
+                                       const std::vector<UInt32>&   image_index,
+                                       SymbolTable& symbol_table, SizeType stubs_offset,
+                                       SizeType pointers_offset, std::vector<Char>& stubs,
+                                       std::vector<Char>& pointers,
+                                       std::vector<Char>& table) const {
+  auto ld_put32 = [](Char* where, Int64 value) {
+    Int32 value32 = static_cast<Int32>(value);
+    std::memcpy(where, &value32, sizeof(Int32));
+  };
 
-  for (auto& struct_of_blob : kObjectBytes) {
-    output_fc.write(struct_of_blob.mBlob.data(), struct_of_blob.mBlob.size());
-  }
+  auto stub_address = [&](SizeType slot) {
+    return Int64(kLinkerDefaultOrigin + stubs_offset + slot * kLinkerStubSize);
+  };
+  auto pointer_address = [&](SizeType slot) {
+    return Int64(kLinkerDefaultOrigin + pointers_offset + slot * sizeof(UInt64));
+  };
 
-  if (kVerbose) {
-    kConsoleOut << "Wrote contents of: " << kOutput << "\n";
-  }
+  std::fill(stubs.begin(), stubs.begin() + kLinkerStubSize, Char(0xCC));
 
-  // step 3: check if we have those symbols
+  stubs[0] = Char(0xFF);
+  stubs[1] = Char(0x25);
+  ld_put32(&stubs[2], pointer_address(0) - (stub_address(0) + 6));
 
-  std::vector<CompilerKit::STLString> unreferenced_symbols;
+  CompilerKit::PEFImportTable header{};
 
-  for (auto& command_hdr : command_headers) {
-    if (auto it =
-            std::find(not_found.begin(), not_found.end(), CompilerKit::STLString(command_hdr.Name));
-        it != not_found.end()) {
-      unreferenced_symbols.emplace_back(command_hdr.Name);
-    }
-  }
+  header.Count  = imports.size();
+  header.Flags  = fOptions.fBindNow ? UInt32(CompilerKit::kPefImportEager) : 0U;
+  header.Binder = pointers_offset;
 
-  if (!unreferenced_symbols.empty()) {
-    for (auto& unreferenced_symbol : unreferenced_symbols) {
-      kConsoleOut << "Undefined symbol " << unreferenced_symbol << "\n";
+  std::memcpy(table.data(), &header, sizeof(header));
+
+  for (SizeType index = 0UL; index < imports.size(); ++index) {
+    SizeType slot = import_slots[imports[index]];
+    Char*    stub = &stubs[slot * kLinkerStubSize];
+
+    stub[0] = Char(0xFF);  // jmp [rip + pointer]
+    stub[1] = Char(0x25);
+    ld_put32(&stub[2], pointer_address(slot) - (stub_address(slot) + 6));
+
+    stub[6] = Char(0x68);  // push index
+    ld_put32(&stub[7], index);
+
+    stub[11] = Char(0xE9);  // jmp binder
+    ld_put32(&stub[12], stub_address(0) - (stub_address(slot) + kLinkerStubSize));
+
+    // lazy pointers start at the binding path, eager ones are all set by the loader.
+    UInt64 pointer = fOptions.fBindNow ? 0ULL : UInt64(stub_address(slot) + 6);
+    std::memcpy(&pointers[slot * sizeof(UInt64)], &pointer, sizeof(UInt64));
+
+    CompilerKit::PEFImport import{};
+
+    import.Header  = image_index[symbol_table[imports[index]].fDefinition];
+    import.Pointer = pointers_offset + slot * sizeof(UInt64);
+    import.Stub    = stubs_offset + slot * kLinkerStubSize;
+
+    std::memcpy(table.data() + sizeof(header) + index * sizeof(import), &import, sizeof(import));
+  }
+}
+
+/// @brief Exported name of a definition, its symbol without the kind: ".code64$foo" is "foo".
+static CompilerKit::STLString ld_export_name(const CompilerKit::PEFCommandHeader& command_hdr) {
+  std::string_view name(command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen));
+
+  if (auto symbol = name.find('$'); symbol != std::string_view::npos)
+    return CompilerKit::symbol_demangle(name.substr(symbol + 1));
+
+  for (auto kind : {kPefCode64, kPefData64, kPefZero64}) {
+    if (name.starts_with(kind)) return CompilerKit::STLString(name.substr(strlen(kind)));
+  }
+
+  return CompilerKit::STLString(name);
+}
+
+/// @brief Build the export table of a dylib, every symbol it defines but :RuntimeSymbol: ones.
+/// @param exported filled with the symbol of every table slot, their placement is written later.
+static std::vector<Char> ld_build_exports(
+    const std::vector<CompilerKit::PEFCommandHeader>& command_headers,
+    CompilerKit::SymbolTable& symbol_table, std::vector<CompilerKit::SymbolId>& exported) {
+  for (CompilerKit::SymbolId id = 0U; id < symbol_table.Count(); ++id) {
+    auto& entry = symbol_table[id];
+
+    if (entry.fDefinition >= 0 && !ld_is_runtime(command_headers[entry.fDefinition]))
+      exported.push_back(id);
+  }
+
+  CompilerKit::ExportHeader header{};
+
+  std::memcpy(header.fMagic, kExportsMagic, kExportsMagicLen);
+
+  header.fVersion     = kExportsVersion;
+  header.fSymbolCount = exported.size();
+  header.fBucketCount = std::max<SizeType>(exported.size() / 2, 1UL);
+  header.fBloomCount  = 1U;
+  header.fBloomShift  = kExportsBloomShift;
+
+  // about eight bloom bits per symbol, two of them set.
+  while (header.fBloomCount * 8 < exported.size()) header.fBloomCount *= 2;
+
+  std::vector<UInt32>                 hashes(symbol_table.Count(), 0U);
+  std::vector<CompilerKit::STLString> names(symbol_table.Count());
+
+  for (auto id : exported) {
+    names[id]  = ld_export_name(command_headers[symbol_table[id].fDefinition]);
+    hashes[id] = CompilerKit::export_hash(names[id]);
+  }
+
+  // a bucket's symbols follow each other, so its chain can be walked in one go.
+  std::stable_sort(exported.begin(), exported.end(),
+                   [&](CompilerKit::SymbolId lhs, CompilerKit::SymbolId rhs) {
+                     return hashes[lhs] % header.fBucketCount < hashes[rhs] % header.fBucketCount;
+                   });
+
+  std::vector<UInt64>                    bloom(header.fBloomCount, 0ULL);
+  std::vector<UInt32>                    buckets(header.fBucketCount, kExportsNoSymbol);
+  std::vector<UInt32>                    chains(exported.size(), 0U);
+  std::vector<CompilerKit::ExportSymbol> symbols(exported.size());
+  CompilerKit::STLString                 strings;
+
+  for (SizeType slot = 0UL; slot < exported.size(); ++slot) {
+    auto&  name   = names[exported[slot]];
+    UInt32 hash   = hashes[exported[slot]];
+    UInt32 bucket = hash % header.fBucketCount;
+
+    bloom[(hash / 64) & (header.fBloomCount - 1)] |=
+        (1ULL << (hash % 64)) | (1ULL << ((hash >> header.fBloomShift) % 64));
+
+    if (buckets[bucket] == kExportsNoSymbol) buckets[bucket] = slot;
+
+    Bool last = slot + 1 == exported.size() ||
+                hashes[exported[slot + 1]] % header.fBucketCount != bucket;
+
+    chains[slot] = (hash & ~1U) | (last ? 1U : 0U);
+
+    symbols[slot].fName    = strings.size();
+    symbols[slot].fNameLen = name.size();
+
+    strings += name;
+  }
+
+  header.fBloom      = sizeof(CompilerKit::ExportHeader);
+  header.fBuckets    = header.fBloom + bloom.size() * sizeof(UInt64);
+  header.fChains     = header.fBuckets + buckets.size() * sizeof(UInt32);
+  header.fSymbols    = header.fChains + chains.size() * sizeof(UInt32);
+  header.fStrings    = header.fSymbols + symbols.size() * sizeof(CompilerKit::ExportSymbol);
+  header.fStringSize = strings.size();
+
+  std::vector<Char> table(header.fStrings + header.fStringSize, 0);
+
+  std::memcpy(table.data(), &header, sizeof(CompilerKit::ExportHeader));
+  std::memcpy(table.data() + header.fBloom, bloom.data(), bloom.size() * sizeof(UInt64));
+  std::memcpy(table.data() + header.fBuckets, buckets.data(), buckets.size() * sizeof(UInt32));
+  std::memcpy(table.data() + header.fChains, chains.data(), chains.size() * sizeof(UInt32));
+  std::memcpy(table.data() + header.fSymbols, symbols.data(),
+              symbols.size() * sizeof(CompilerKit::ExportSymbol));
+  std::memcpy(table.data() + header.fStrings, strings.data(), strings.size());
+
+  return table;
+}
+
+/// @brief Build epoch of the image, SOURCE_DATE_EPOCH when set, 0 in reproducible mode otherwise.
+time_t CompilerKit::Linker::BuildEpoch() const {
+  if (const Char* epoch = std::getenv("SOURCE_DATE_EPOCH"); epoch && std::isdigit(*epoch))
+    return std::strtoll(epoch, nullptr, 10);
+
+  return fOptions.fReproducible ? 0 : time(nullptr);
+}
+
+/// @brief Container GUID, a UUIDv5 of the inputs' contents and options in reproducible mode.
+/// @note Paths aren't part of it, so the same link in another directory gets the same GUID.
+CompilerKit::STLString CompilerKit::Linker::ContainerUUID() const {
+  if (!fOptions.fReproducible) {
+    std::random_device rd;
+
+    auto seedData = std::array<int, std::mt19937::state_size>{};
+    std::generate(std::begin(seedData), std::end(seedData), std::ref(rd));
+    std::seed_seq seq(std::begin(seedData), std::end(seedData));
+    std::mt19937  generator(seq);
+
+    auto gen = uuids::uuid_random_generator{generator};
+    return uuids::to_string(gen());
+  }
+
+  CompilerKit::STLString name = "ld64:" + std::to_string(this->OptionsHash());
+
+  for (auto& object : fObjectMaps) {
+    auto bytes = object.Bytes();
+
+    name += ":" + std::to_string(bytes.size()) + "/" +
+            std::to_string(CompilerKit::Utils::crc32c(0U, bytes.data(), bytes.size()));
+
+    if (fOptions.fStreaming) object.Release();
+  }
+
+  uuids::uuid_name_generator gen{uuids::uuid_namespace_url};
+  return uuids::to_string(gen(name));
+}
+
+/// @brief pwrite all of size bytes, retrying short writes.
+/// @return false when the write failed, the image is then half patched.
+static Bool ld_pwrite_all(Int32 fd, const void* data, SizeType size, off_t offset) {
+  auto bytes = static_cast<const Char*>(data);
+
+  while (size > 0) {
+    ssize_t put = ::pwrite(fd, bytes, size, offset);
+
+    if (put < 0 && errno == EINTR) continue;
+    if (put <= 0) return false;
+
+    bytes += put;
+    size -= put;
+    offset += put;
+  }
+
+  return true;
+}
+
+/// @brief Patch the objects that changed since the last incremental link, in place.
+/// @return NECTI_SUCCESS when the image is up to date, NECTI_EXEC_ERROR when it needs a full link,
+/// which is also what a failed write or read of the image gives, the full link rewrites it.
+Int32 CompilerKit::Linker::IncrementalRelink() {
+  CompilerKit::Utils::LinkState state;
+
+  if (!std::filesystem::exists(fOptions.fOutput) ||
+      !CompilerKit::Utils::link_state_load(CompilerKit::Utils::link_state_path(fOptions.fOutput),
+                                           state))
+    return NECTI_EXEC_ERROR;
+
+  if (state.fHeader.fOptions != this->OptionsHash() || state.fPaths != fObjectList) {
+    if (fOptions.fVerbose) kConsoleOut << "incremental: options or inputs changed, relinking.\n";
+    return NECTI_EXEC_ERROR;
+  }
+
+  // find out what changed, stat first and only hash when it doesn't match.
+
+  std::vector<SizeType> changed;
+
+  for (SizeType object_index = 0UL; object_index < fObjectList.size(); ++object_index) {
+    auto& slot = state.fObjects[object_index];
+
+    if (CompilerKit::Utils::link_state_same_stat(fObjectList[object_index], slot)) continue;
+
+    CompilerKit::Utils::AEMappedObject object_map;
+
+    if (object_map.Open(fObjectList[object_index].c_str()) == NECTI_SUCCESS) {
+      auto bytes = object_map.Bytes();
+
+      if (CompilerKit::symbol_hash({bytes.data(), bytes.size()}) == slot.fHash) {
+        CompilerKit::Utils::link_state_stat(fObjectList[object_index], slot);
+        continue;
+      }
+    }
+
+    changed.push_back(object_index);
+  }
+
+  // re-read only the changed objects.
+
+  std::vector<LinkerObject> objects(changed.size());
+
+  CompilerKit::Utils::pool_for_each(changed.size(), fOptions.fJobs, [&](SizeType index) {
+    this->IngestObject(fObjectInputs[changed[index]], objects[index]);
+  });
+
+  // check that everything fits before touching the image.
+
+  for (SizeType index = 0UL; index < changed.size(); ++index) {
+    auto& object = objects[index];
+    auto& slot   = state.fObjects[changed[index]];
+
+    if (object.fStatus != NECTI_SUCCESS || ld_object_signature(object) != slot.fSignature) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "incremental: symbols of " << fObjectList[changed[index]]
+                    << " changed, relinking.\n";
+
+      return NECTI_EXEC_ERROR;
+    }
+
+    if (slot.fFlags & CompilerKit::Utils::kLinkStateObjectDropped) continue;
+
+    if (slot.fFlags & (CompilerKit::Utils::kLinkStateObjectFolded |
+                       CompilerKit::Utils::kLinkStateObjectFoldTarget)) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "incremental: " << fObjectList[changed[index]]
+                    << " is folded, relinking.\n";
+
+      return NECTI_EXEC_ERROR;
+    }
+
+    // its fixups, or the ones landing in it, would have to be applied again.
+    if (slot.fFlags & CompilerKit::Utils::kLinkStateObjectRelocated) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "incremental: " << fObjectList[changed[index]]
+                    << " has relocations, relinking.\n";
+
+      return NECTI_EXEC_ERROR;
+    }
+
+    // so would the export table entries pointing into it.
+    if (slot.fFlags & CompilerKit::Utils::kLinkStateObjectExported) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "incremental: " << fObjectList[changed[index]]
+                    << " exports symbols, relinking.\n";
+
+      return NECTI_EXEC_ERROR;
+    }
+
+    if (object.fMap.Code().size() > slot.fBlobReserve) {
+      if (fOptions.fVerbose)
+        kConsoleOut << "incremental: " << fObjectList[changed[index]]
+                    << " grew past its slack, relinking.\n";
+
+      return NECTI_EXEC_ERROR;
+    }
+  }
+
+  Int32 fd = ::open(fOptions.fOutput.c_str(), O_RDWR);
+
+  if (fd < 0) return NECTI_EXEC_ERROR;
+
+  for (SizeType index = 0UL; index < changed.size(); ++index) {
+    auto& object = objects[index];
+    auto& slot   = state.fObjects[changed[index]];
+
+    // same records as before, so it is still unreachable, only its hash changes.
+    if (slot.fFlags & CompilerKit::Utils::kLinkStateObjectDropped) {
+      auto bytes = object.fMap.Bytes();
+      slot.fHash = CompilerKit::symbol_hash({bytes.data(), bytes.size()});
+
+      CompilerKit::Utils::link_state_stat(fObjectList[changed[index]], slot);
+      continue;
+    }
+
+    if (fOptions.fVerbose)
+      kConsoleOut << "incremental: patching " << fObjectList[changed[index]] << "\n";
+
+    SizeType header_index = slot.fFirstHeader;
+
+    for (SizeType record = 0UL; record < object.fHeaders.size(); ++record) {
+      auto command_hdr = object.fHeaders[record];
+
+      if (ld_is_undefined(command_hdr)) continue;
+
+      // the records moved inside the slot, the protection stays the one of its segment.
+      command_hdr.Offset         = slot.fBlobOffset + object.fHeaderStarts[record];
+      command_hdr.VirtualAddress = kLinkerDefaultOrigin + command_hdr.Offset;
+      command_hdr.Flags          = state.fHeaders[header_index].Flags;
+
+      if (this->IsStart(command_hdr)) state.fHeader.fStart = command_hdr.Offset;
+
+      state.fHeaders[header_index] = command_hdr;
+      ++header_index;
+    }
+
+    auto code = object.fMap.Code();
+
+    std::vector<Char> blob(slot.fBlobReserve, 0);
+    std::memcpy(blob.data(), code.data(), code.size());
+
+    if (!ld_pwrite_all(fd, &state.fHeaders[slot.fFirstHeader],
+                       slot.fHeaderCount * sizeof(CompilerKit::PEFCommandHeader),
+                       sizeof(CompilerKit::PEFContainer) +
+                           slot.fFirstHeader * sizeof(CompilerKit::PEFCommandHeader)) ||
+        !ld_pwrite_all(fd, blob.data(), blob.size(), slot.fBlobOffset)) {
+      ::close(fd);
+      return NECTI_EXEC_ERROR;
     }
 
+    auto bytes = object.fMap.Bytes();
+
+    slot.fHash        = CompilerKit::symbol_hash({bytes.data(), bytes.size()});
+    slot.fBlobSize    = code.size();
+    slot.fVirtualSize = code.size();
+
+    CompilerKit::Utils::link_state_stat(fObjectList[changed[index]], slot);
+  }
+
+  // the entrypoint may have moved inside its slot, the image has another GUID now, and the
+  // checksum covers what we patched.
+
+  if (!changed.empty() && this->RefreshContainer(fd, state.fHeader.fStart) != NECTI_SUCCESS) {
+    ::close(fd);
     return NECTI_EXEC_ERROR;
   }
 
-  if ((!kStartFound || kDuplicateSymbols) &&
-      (std::filesystem::exists(kOutput) || !unreferenced_symbols.empty())) {
-    if (kVerbose) {
-      kConsoleOut << "File: " << kOutput << " is corrupt now...\n";
+  ::close(fd);
+
+  CompilerKit::Utils::link_state_save(CompilerKit::Utils::link_state_path(fOptions.fOutput), state);
+
+  if (fOptions.fVerbose)
+    kConsoleOut << "incremental: " << changed.size() << " of " << fObjectList.size()
+                << " object(s) patched.\n";
+
+  return NECTI_SUCCESS;
+}
+
+/// @brief Rewrite the container of an incrementally patched image: its entrypoint, a new
+/// Container:GUID and the checksum over the patched bytes.
+Int32 CompilerKit::Linker::RefreshContainer(Int32 fd, UIntPtr start) const {
+  CompilerKit::PEFContainer pef_container{};
+  struct stat               st{};
+
+  if (::fstat(fd, &st) != 0 ||
+      ::pread(fd, &pef_container, sizeof(pef_container), 0) != sizeof(pef_container))
+    return NECTI_EXEC_ERROR;
+
+  pef_container.Start = start;
+
+  std::vector<CompilerKit::PEFCommandHeader> command_headers(pef_container.Count);
+
+  SizeType table_size = command_headers.size() * sizeof(CompilerKit::PEFCommandHeader);
+
+  if (::pread(fd, command_headers.data(), table_size, sizeof(pef_container)) != ssize_t(table_size))
+    return NECTI_EXEC_ERROR;
+
+  for (SizeType index = 0UL; index < command_headers.size(); ++index) {
+    auto& command_hdr = command_headers[index];
+
+    if (!ld_has_prefix(command_hdr, kPefGUIDName)) continue;
+
+    auto uuidStr = this->ContainerUUID();
+
+    std::memset(command_hdr.Name, 0, kPefNameLen);
+    std::memcpy(command_hdr.Name, kPefGUIDName, strlen(kPefGUIDName));
+    std::memcpy(command_hdr.Name + strlen(kPefGUIDName), uuidStr.c_str(), uuidStr.size());
+
+    if (!ld_pwrite_all(fd, &command_hdr, sizeof(command_hdr),
+                       sizeof(pef_container) + index * sizeof(CompilerKit::PEFCommandHeader)))
+      return NECTI_EXEC_ERROR;
+  }
+
+  if (!ld_pwrite_all(fd, &pef_container, sizeof(pef_container), 0)) return NECTI_EXEC_ERROR;
+
+  // without a mapping the old checksum would be left over the new bytes.
+  VoidPtr map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  if (map == MAP_FAILED) return NECTI_EXEC_ERROR;
+
+  std::span<const Char> image(static_cast<const Char*>(map), st.st_size);
+
+  pef_container.Checksum = CompilerKit::Utils::pef_image_checksum(image);
+
+  ::munmap(map, st.st_size);
+
+  return ld_pwrite_all(fd, &pef_container, sizeof(pef_container), 0) ? NECTI_SUCCESS
+                                                                      : NECTI_EXEC_ERROR;
+}
+
+CompilerKit::Linker::Linker(LinkerOptions options) : fOptions(std::move(options)) {}
+
+CompilerKit::Linker::~Linker() = default;
+
+/// @brief Write an image to output, or keep it in bytes when there's none.
+Int32 CompilerKit::Linker::Emit(Utils::ImageWriter& image, const STLString& output,
+                                std::vector<Char>& bytes) {
+  if (output.empty()) {
+    bytes = image.Bytes();
+    return NECTI_SUCCESS;
+  }
+
+  Int32 output_fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (output_fd < 0) {
+    if (fOptions.fVerbose) {
+      kConsoleOut << "error: " << strerror(errno) << "\n";
     }
 
+    return NECTI_FILE_NOT_FOUND;
+  }
+
+  Int32 emit_status = image.Emit(output_fd, fOptions.fPreallocate);
+
+  ::close(output_fd);
+
+  if (emit_status != NECTI_SUCCESS) {
+    kConsoleOut << "couldn't write: " << output << "\n";
     return NECTI_EXEC_ERROR;
   }
 
   return NECTI_SUCCESS;
 }
 
+/**
+ * @brief Write the .dbg of the image, next to it.
+ *
+ * @param container the image's container, the .dbg has the same target.
+ * @param headers the image's symbol headers.
+ * @param objects the PEFDebugObject table and its names.
+ * @return NECTI_SUCCESS, or the error code of Emit.
+ */
+Int32 CompilerKit::Linker::EmitDebug(const PEFContainer&            container,
+                                     std::vector<PEFCommandHeader>& headers,
+                                     std::vector<Char>&             objects) {
+  PEFContainer debug_container = container;
+
+  PEFCommandHeader objects_cmd_hdr{};
+  PEFCommandHeader end_cmd_hdr{};
+
+  std::memcpy(objects_cmd_hdr.Name, kPefDebugObjectsName, strlen(kPefDebugObjectsName));
+  std::memcpy(end_cmd_hdr.Name, kPefEndName, strlen(kPefEndName));
+
+  // the symbol headers point into the image, nothing of theirs is in here.
+  for (auto& command_hdr : headers) command_hdr.OffsetSize = 0UL;
+
+  headers.push_back(objects_cmd_hdr);
+  headers.push_back(end_cmd_hdr);
+
+  auto& objects_hdr = headers[headers.size() - 2];
+
+  objects_hdr.Offset      = sizeof(PEFContainer) + headers.size() * sizeof(PEFCommandHeader);
+  objects_hdr.OffsetSize  = objects.size();
+  objects_hdr.VirtualSize = objects.size();
+  objects_hdr.Flags       = kPefLinkerID;
+  objects_hdr.Kind        = kPefZero;
+
+  headers.back().Offset = objects_hdr.Offset + objects.size();
+  headers.back().Flags  = kPefLinkerID;
+  headers.back().Kind   = kPefZero;
+
+  debug_container.Kind     = kPefKindDebug;
+  debug_container.Count    = headers.size();
+  debug_container.Checksum = 0U;
+
+  Utils::ImageWriter image;
+
+  image.Append(&debug_container, sizeof(PEFContainer));
+  image.Append(headers.data(), headers.size() * sizeof(PEFCommandHeader));
+  image.Append(objects.data(), objects.size());
+
+  debug_container.Checksum = image.Checksum();
+
+  STLString output = fOptions.fOutput.empty()
+                         ? STLString{}
+                         : std::filesystem::path(fOptions.fOutput)
+                               .replace_extension(kPefDebugExt)
+                               .string();
+
+  if (fOptions.fVerbose && !output.empty())
+    kConsoleOut << "debug: " << headers.size() << " header(s) written to: " << output << "\n";
+
+  return this->Emit(image, output, fDebugImage);
+}
+
+/// @brief Link a slice per architecture of the objects, concurrently, then write them behind a
+/// FAT container and its slice directory. Static libraries are searched by every slice.
+Int32 CompilerKit::Linker::LinkFat() {
+  std::vector<Int32>                     archs;
+  std::vector<Int32>                     sub_archs;
+  std::vector<std::vector<LinkerInput>> slice_inputs;
+
+  for (auto& input : fObjectInputs) {
+    Utils::AEMappedObject object;
+
+    Int32 status = input.fBytes.empty() ? object.Open(input.fPath.c_str())
+                                        : object.Open(input.fBytes);
+
+    if (status != NECTI_SUCCESS) {
+      kConsoleOut << "not an AE object: " << input.fPath << "\n";
+      return NECTI_EXEC_ERROR;
+    }
+
+    SizeType slice = std::find(archs.begin(), archs.end(), object.Header()->fArch) - archs.begin();
+
+    if (slice == archs.size()) {
+      archs.push_back(object.Header()->fArch);
+      sub_archs.push_back(object.Header()->fSubArch);
+      slice_inputs.emplace_back();
+    }
+
+    slice_inputs[slice].push_back(input);
+  }
+
+  if (archs.empty()) {
+    kConsoleOut << "-fat: no object to take the architectures from." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  std::vector<std::unique_ptr<Linker>> slices;
+  std::vector<Int32>                   statuses(archs.size(), NECTI_SUCCESS);
+
+  for (SizeType slice = 0UL; slice < archs.size(); ++slice) {
+    LinkerOptions options = fOptions;
+
+    options.fInputs = std::move(slice_inputs[slice]);
+    options.fInputs.insert(options.fInputs.end(), fArchiveList.begin(), fArchiveList.end());
+
+    options.fArch       = archs[slice];
+    options.fSubArch    = sub_archs[slice];
+    options.fFatBinary  = false;
+    options.fOutput     = STLString{};
+    options.fSplitDebug = false;
+
+    slices.push_back(std::make_unique<Linker>(std::move(options)));
+  }
+
+  Utils::pool_for_each(slices.size(), fOptions.fJobs,
+                       [&](SizeType slice) { statuses[slice] = slices[slice]->Link(); });
+
+  for (SizeType slice = 0UL; slice < slices.size(); ++slice) {
+    if (statuses[slice] != NECTI_SUCCESS) {
+      kConsoleOut << "-fat: the slice of architecture " << archs[slice] << " failed to link.\n";
+      return statuses[slice];
+    }
+  }
+
+  PEFContainer fat_container{};
+
+  std::memcpy(fat_container.Magic, kPefMagicFat, kPefMagicLen);
+
+  fat_container.Linker  = kLinkerId;
+  fat_container.Version = kPefVersion;
+  fat_container.Kind    = fOptions.fExecutable ? kPefKindExec : kPefKindDylib;
+  fat_container.Abi     = fOptions.fAbi;
+  fat_container.Cpu     = kPefArchInvalid;
+  fat_container.HdrSz   = sizeof(PEFContainer);
+  fat_container.Count   = slices.size();
+
+  std::vector<PEFFatSlice> directory(slices.size());
+  Utils::ImageWriter       image;
+
+  image.Append(&fat_container, sizeof(PEFContainer));
+  image.Append(directory.data(), directory.size() * sizeof(PEFFatSlice));
+
+  for (SizeType slice = 0UL; slice < slices.size(); ++slice) {
+    image.AppendZeros((kPefPageSize - image.Size() % kPefPageSize) % kPefPageSize);
+
+    directory[slice] = {.Cpu    = UInt32(archs[slice]),
+                        .SubCpu = UInt32(sub_archs[slice]),
+                        .Offset = image.Size(),
+                        .Size   = slices[slice]->Image().size()};
+
+    image.Append(slices[slice]->Image().data(), slices[slice]->Image().size());
+
+    if (fOptions.fVerbose)
+      kConsoleOut << "fat: slice of architecture " << archs[slice] << ", " << directory[slice].Size
+                  << " byte(s) at offset " << directory[slice].Offset << "\n";
+  }
+
+  fat_container.Checksum = image.Checksum();
+
+  return this->Emit(image, fOptions.fOutput, fImage);
+}
+
+/// @brief Link the inputs, every bit of state lives in this Linker.
+Int32 CompilerKit::Linker::Link() {
+  Bool in_memory = false;
+
+  for (auto& input : fOptions.fInputs) {
+    if (input.fLibrary) {
+      fArchiveList.push_back(input);
+    } else {
+      fObjectList.push_back(input.fPath);
+      fObjectInputs.push_back(input);
+    }
+
+    if (!input.fBytes.empty()) in_memory = true;
+  }
+
+  if (fObjectList.empty() && fArchiveList.empty()) {
+    kConsoleOut << "no input files." << std::endl;
+    return NECTI_EXEC_ERROR;
+  } else {
+    namespace FS = std::filesystem;
+
+    // check for existing files, if they don't throw an error.
+    for (auto& input : fOptions.fInputs) {
+      if (input.fBytes.empty() && !FS::exists(input.fPath)) {
+        // if filesystem doesn't find file
+        //          -> throw error.
+        kConsoleOut << "no such file: " << input.fPath << std::endl;
+        return NECTI_EXEC_ERROR;
+      }
+    }
+  }
+
+  if (fOptions.fFatBinary && fOptions.fIncremental) {
+    kConsoleOut << "-incremental can't patch a FAT image, drop one of them." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  // a FAT image is an image per architecture, each linked on its own.
+  if (fOptions.fFatBinary) return this->LinkFat();
+
+  // PEF expects a valid target architecture when outputing a binary.
+  if (fOptions.fArch == CompilerKit::kPefArchInvalid) {
+    kConsoleOut << "no target architecture set, can't continue." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  if (fOptions.fIncremental && fOptions.fPageSize) {
+    kConsoleOut << "-incremental can't patch a page-aligned image, drop one of them." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  if (fOptions.fIncremental && fOptions.fCompress) {
+    kConsoleOut << "-incremental can't patch a compressed image, drop one of them." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  // the GUID of a reproducible image hashes every input, a patch would have to read them all.
+  if (fOptions.fIncremental && fOptions.fReproducible) {
+    kConsoleOut << "-incremental can't patch a reproducible image, drop one of them." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  if (fOptions.fIncremental && fOptions.fSplitDebug) {
+    kConsoleOut << "-incremental can't patch an image split from its .dbg, drop one of them."
+                << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  // the link state tracks input files, it has no notion of library members.
+  if (fOptions.fIncremental && !fArchiveList.empty()) {
+    if (fOptions.fVerbose) kConsoleOut << "incremental: static libraries given, linking fully.\n";
+
+    fOptions.fIncremental = false;
+  }
+
+  // nor of anything that isn't on disk.
+  if (fOptions.fIncremental && (in_memory || fOptions.fOutput.empty())) {
+    if (fOptions.fVerbose) kConsoleOut << "incremental: linking in memory, linking fully.\n";
+
+    fOptions.fIncremental = false;
+  }
+
+  // an incremental link only touches the objects that changed, when they still fit in their slot.
+  if (fOptions.fIncremental && this->IncrementalRelink() == NECTI_SUCCESS) {
+    return NECTI_SUCCESS;
+  }
+
+  CompilerKit::PEFContainer pef_container{};
+
+  pef_container.Count    = 0UL;
+  pef_container.Kind =
+      fOptions.fExecutable ? CompilerKit::kPefKindExec : CompilerKit::kPefKindDylib;
+  pef_container.SubCpu   = fOptions.fSubArch;
+  pef_container.Linker   = kLinkerId;      // Amlal El Mahrouss Linker
+  pef_container.Abi      = fOptions.fAbi;  // Multi-Processor UX ABI
+  pef_container.Magic[0] = kPefMagic[0];
+  pef_container.Magic[1] = kPefMagic[1];
+  pef_container.Magic[2] = kPefMagic[2];
+  pef_container.Magic[3] = kPefMagic[3];
+  pef_container.Version  = kPefVersion;
+
+  // specify the start address, can be 0x10000
+  pef_container.Start    = kLinkerDefaultOrigin;
+  pef_container.HdrSz    = sizeof(CompilerKit::PEFContainer);
+  pef_container.Checksum = 0UL;
+
+  //! Read AE to convert as PEF.
+
+  std::vector<CompilerKit::PEFCommandHeader> command_headers;
+
+  // step 1: parse and validate every object, on fJobs workers when asked to.
+  // results are merged in input order afterwards, so the image doesn't depend on scheduling.
+
+  std::vector<LinkerObject> objects(fObjectList.size());
+
+  CompilerKit::Utils::pool_for_each(fObjectList.size(), fOptions.fJobs, [&](SizeType index) {
+    this->IngestObject(fObjectInputs[index], objects[index]);
+  });
+
+  // step 1.5: resolve what's still undefined against the static libraries.
+  if (!fArchiveList.empty() && this->PullArchiveMembers(objects) != NECTI_SUCCESS)
+    return NECTI_EXEC_ERROR;
+
+  fObjectMaps.reserve(objects.size());
+
+  // the ranges' slots in the image, kept next to it for incremental links, where every object
+  // is a single range.
+  CompilerKit::Utils::LinkState link_state{};
+  std::vector<std::pair<SizeType, SizeType>> object_ranges;
+
+  // owner and start of every header, fixups resolve against them, and the code size of every
+  // range.
+  std::vector<SizeType> header_owners;
+  std::vector<SizeType> header_starts;
+  std::vector<SizeType> object_sizes;
+
+  link_state.fPaths = fObjectList;
+
+  for (size_t object_index = 0UL; object_index < objects.size(); ++object_index) {
+    auto& object     = objects[object_index];
+    auto& objectFile = fObjectList[object_index];
+
+    if (object.fStatus == NECTI_FAT_ERROR) {
+      if (fOptions.fVerbose) kConsoleOut << "is this a FAT binary? : not a FAT binary.\n";
+
+      kConsoleOut << "object " << objectFile
+                  << " is a different kind of architecture and output isn't "
+                     "treated as a FAT binary."
+                  << std::endl;
+
+      return NECTI_FAT_ERROR;
+    } else if (object.fStatus == NECTI_INVALID_DATA && !object.fBadRecord.empty()) {
+      kConsoleOut << "record " << object.fBadRecord
+                  << " lies outside the code of: " << objectFile << std::endl;
+
+      return NECTI_EXEC_ERROR;
+    } else if (object.fStatus == NECTI_INVALID_DATA) {
+      kConsoleOut << "bad relocation in: " << objectFile << std::endl;
+
+      return NECTI_EXEC_ERROR;
+    } else if (object.fStatus != NECTI_SUCCESS) {
+      kConsoleOut << "not an object container: " << objectFile << std::endl;
+
+      // don't continue, it is a fatal error.
+      return NECTI_EXEC_ERROR;
+    }
+
+    const CompilerKit::AEHeader& hdr = *object.fMap.Header();
+
+    if (fOptions.fVerbose) kConsoleOut << "header found, record count: " << hdr.fCount << "\n";
+
+    // an incremental link patches whole objects, so it never splits them.
+    auto cuts = fOptions.fIncremental ? std::vector<SizeType>{0UL} : ld_object_cuts(object);
+    auto code = object.fMap.Code();
+
+    auto ld_range_of = [&](SizeType offset) -> SizeType {
+      return std::upper_bound(cuts.begin(), cuts.end(), offset) - cuts.begin() - 1;
+    };
+
+    // a record goes to the range holding its start, an undefined one to the ranges whose fixups
+    // name it, or to all of them when none does.
+    std::vector<std::vector<SizeType>> range_headers(cuts.size());
+    std::vector<Int64>                 referenced(object.fHeaders.size(), -1);
+
+    for (auto& reloc : object.fMap.Relocations()) {
+      auto header = object.fRecordHeaders[reloc.fRecord];
+      auto range  = Int64(ld_range_of(reloc.fOffset));
+
+      if (!ld_is_undefined(object.fHeaders[header]) || referenced[header] == range) continue;
+
+      // fixups are in place order, so a range only shows up once in a row.
+      range_headers[range].push_back(header);
+      referenced[header] = range;
+    }
+
+    for (SizeType header = 0UL; header < object.fHeaders.size(); ++header) {
+      if (!ld_is_undefined(object.fHeaders[header])) {
+        range_headers[ld_range_of(object.fHeaderStarts[header])].push_back(header);
+      } else if (referenced[header] < 0) {
+        for (auto& headers : range_headers) headers.push_back(header);
+      }
+    }
+
+    // a copy of every header, any of them resolves a fixup to the same symbol.
+    std::vector<SizeType> header_index(object.fHeaders.size(), 0UL);
+    SizeType              first_range = fRanges.size();
+
+    for (SizeType range = 0UL; range < cuts.size(); ++range) {
+      SizeType from = cuts[range];
+      SizeType to   = range + 1 < cuts.size() ? cuts[range + 1] : code.size();
+
+      auto& headers = range_headers[range];
+
+      // in record order, as the object lists them.
+      std::sort(headers.begin(), headers.end());
+      headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+
+      object_ranges.emplace_back(command_headers.size(), command_headers.size() + headers.size());
+
+      for (auto header : headers) {
+        auto& command_header = object.fHeaders[header];
+
+        if (fOptions.fVerbose) kConsoleOut << "Record: " << command_header.Name << " is marked.\n";
+
+        header_index[header] = command_headers.size();
+
+        command_headers.emplace_back(command_header);
+        header_owners.push_back(fRanges.size());
+        header_starts.push_back(ld_is_undefined(command_header)
+                                    ? 0UL
+                                    : object.fHeaderStarts[header] - from);
+      }
+
+      fRanges.push_back({.fObject = object_index, .fFrom = from, .fTo = to});
+      object_sizes.push_back(to - from);
+
+      fObjectBytes.push_back({.mBlob       = code.subspan(from, to - from),
+                              .mOffset     = hdr.fStartCode + from,
+                              .mFile       = object.fFile,
+                              .mFileOffset = object.fFileStart + hdr.fStartCode + from});
+
+      link_state.fObjects.emplace_back();
+    }
+
+    if (fOptions.fIncremental) {
+      auto& slot  = link_state.fObjects[first_range];
+      auto  bytes = object.fMap.Bytes();
+
+      slot.fHash      = CompilerKit::symbol_hash({bytes.data(), bytes.size()});
+      slot.fSignature = ld_object_signature(object);
+
+      CompilerKit::Utils::link_state_stat(objectFile, slot);
+    }
+
+    for (auto& reloc : object.fMap.Relocations()) {
+      auto range = first_range + ld_range_of(reloc.fOffset);
+
+      fFixups.push_back({.fObject = range,
+                         .fOffset = reloc.fOffset - fRanges[range].fFrom,
+                         .fHeader = header_index[object.fRecordHeaders[reloc.fRecord]],
+                         .fKind   = reloc.fKind,
+                         .fAddend = reloc.fAddend});
+    }
+
+    if (object.fStartFound) fStartFound = true;
+
+    // keep the mapping alive, the blobs are written at the end of the link.
+    fObjectMaps.emplace_back(std::move(object.fMap));
+  }
+
+  pef_container.Cpu = fOptions.fArch;
+
+  // diagnostics name a range after its object, and after its start when the object is split.
+  auto ld_range_name = [&](SizeType range) {
+    auto& entry = fRanges[range];
+    auto  name  = fObjectList[entry.fObject];
+
+    if ((range > 0 && fRanges[range - 1].fObject == entry.fObject) ||
+        (range + 1 < fRanges.size() && fRanges[range + 1].fObject == entry.fObject))
+      name += "+" + std::to_string(entry.fFrom);
+
+    return name;
+  };
+
+  // a blob is patched in one sweep, so its fixups are kept in place order.
+  std::sort(fFixups.begin(), fFixups.end(), [](const LinkerFixup& lhs, const LinkerFixup& rhs) {
+    return lhs.fObject != rhs.fObject ? lhs.fObject < rhs.fObject : lhs.fOffset < rhs.fOffset;
+  });
+
+  fObjectFixups.resize(fRanges.size());
+
+  for (SizeType object_index = 0UL, fixup = 0UL; object_index < fRanges.size(); ++object_index) {
+    fObjectFixups[object_index].first = fixup;
+
+    while (fixup < fFixups.size() && fFixups[fixup].fObject == object_index) ++fixup;
+
+    fObjectFixups[object_index].second = fixup;
+  }
+
+  // step 2: check for errors (multiple symbols, undefined ones)
+  // a single pass over the headers fills the symbol table, then each entry tells us whether it's
+  // defined more than once, or referenced and never defined.
+
+  CompilerKit::SymbolTable           symbol_table;
+  std::vector<CompilerKit::SymbolId> header_symbols(command_headers.size(),
+                                                    CompilerKit::kSymbolInvalid);
+
+  symbol_table.Reserve(command_headers.size());
+
+  for (size_t command_hdr_index = 0UL; command_hdr_index < command_headers.size();
+       ++command_hdr_index) {
+    auto&            command_hdr = command_headers[command_hdr_index];
+    if (*command_hdr.Name == 0) continue;
+
+    // erase the lookup prefix, and demangle everything.
+    Bool undefined = false;
+
+    header_symbols[command_hdr_index] =
+        symbol_table.Intern(ld_symbol_key(command_hdr, undefined));
+
+    // check if this symbol needs to be resolved.
+    if (undefined) {
+      if (fOptions.fVerbose) kConsoleOut << "Found undefined symbol: " << command_hdr.Name << "\n";
+
+      symbol_table[header_symbols[command_hdr_index]].fReferenced = true;
+
+      continue;
+    }
+
+    auto& entry = symbol_table[header_symbols[command_hdr_index]];
+
+    if (entry.fDefCount == 0) entry.fDefinition = command_hdr_index;
+
+    // every object importing a :RuntimeSymbol: carries its header, they all share one import.
+    if (ld_is_runtime(command_hdr) && entry.fDefCount > 0) continue;
+
+    ++entry.fDefCount;
+  }
+
+  std::vector<CompilerKit::STLString> unreferenced_symbols;
+
+  for (auto& entry : symbol_table.Entries()) {
+    if (entry.fDefCount > 1) {
+      if (fOptions.fVerbose) kConsoleOut << "Found duplicate symbols of: " << entry.fName << "\n";
+
+      kConsoleOut << "Multiple symbols of: " << entry.fName << " detected, cannot continue.\n";
+
+      fDuplicateSymbols = true;
+    } else if (entry.fReferenced) {
+      if (entry.fDefCount == 0) {
+        unreferenced_symbols.emplace_back(entry.fName);
+      } else if (fOptions.fVerbose) {
+        kConsoleOut << "Found symbol: " << command_headers[entry.fDefinition].Name << "\n";
+      }
+    }
+  }
+
+  if (fDuplicateSymbols) return NECTI_EXEC_ERROR;
+
+  if (!unreferenced_symbols.empty()) {
+    for (auto& unreferenced_symbol : unreferenced_symbols) {
+      kConsoleOut << "Undefined symbol " << unreferenced_symbol << "\n";
+    }
+
+    return NECTI_EXEC_ERROR;
+  }
+
+  // step 2.1: resolve every fixup to the object and record it lands on.
+  // :RuntimeSymbol: targets are only known to the loader, they are kept for it.
+
+  // object and start of every definition, a dylib's export table points there.
+  std::vector<std::pair<SizeType, SizeType>> symbol_places(symbol_table.Count());
+
+  for (CompilerKit::SymbolId id = 0U; id < symbol_table.Count(); ++id) {
+    if (auto definition = symbol_table[id].fDefinition; definition >= 0)
+      symbol_places[id] = {header_owners[definition], header_starts[definition]};
+  }
+
+  for (auto& fixup : fFixups) {
+    auto target = fixup.fHeader;
+
+    if (ld_is_undefined(command_headers[target]))
+      target = symbol_table[header_symbols[target]].fDefinition;
+
+    link_state.fObjects[fixup.fObject].fFlags |= CompilerKit::Utils::kLinkStateObjectRelocated;
+
+    if (ld_is_runtime(command_headers[target])) {
+      fixup.fRuntime = header_symbols[target];
+      continue;
+    }
+
+    fixup.fTarget      = header_owners[target];
+    fixup.fTargetStart = header_starts[target];
+
+    link_state.fObjects[fixup.fTarget].fFlags |= CompilerKit::Utils::kLinkStateObjectRelocated;
+  }
+
+  // step 2.25: garbage collect the ranges nothing reaches.
+
+  if (fOptions.fGCSections) {
+    auto live =
+        this->ReachableObjects(command_headers, object_ranges, header_symbols, symbol_table);
+
+    std::vector<CompilerKit::PEFCommandHeader> live_headers;
+    std::vector<CompilerKit::SymbolId>         live_symbols;
+    std::vector<SizeType>                      live_owners, live_starts;
+    std::vector<Int64>                         remap(command_headers.size(), -1);
+
+    SizeType removed_bytes   = 0UL;
+    SizeType removed_objects = 0UL;
+
+    live_headers.reserve(command_headers.size());
+
+    for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+      auto [first, last] = object_ranges[object_index];
+
+      object_ranges[object_index].first = live_headers.size();
+
+      if (!live[object_index]) {
+        if (fOptions.fVerbose)
+          kConsoleOut << "gc-sections: dropping " << ld_range_name(object_index) << "\n";
+
+        for (auto index = first; index < last; ++index) {
+          if (!ld_is_undefined(command_headers[index]))
+            removed_bytes += sizeof(CompilerKit::PEFCommandHeader);
+        }
+
+        removed_bytes += fObjectBytes[object_index].mBlob.size();
+        ++removed_objects;
+
+        fObjectBytes[object_index].mBlob = {};
+        link_state.fObjects[object_index].fFlags |= CompilerKit::Utils::kLinkStateObjectDropped;
+      } else {
+        for (auto index = first; index < last; ++index) {
+          remap[index] = live_headers.size();
+          live_headers.push_back(command_headers[index]);
+          live_symbols.push_back(header_symbols[index]);
+          live_owners.push_back(header_owners[index]);
+          live_starts.push_back(header_starts[index]);
+        }
+      }
+
+      object_ranges[object_index].second = live_headers.size();
+    }
+
+    for (auto& entry : symbol_table.Entries()) {
+      if (entry.fDefinition >= 0) entry.fDefinition = remap[entry.fDefinition];
+    }
+
+    command_headers = std::move(live_headers);
+    header_symbols  = std::move(live_symbols);
+    header_owners   = std::move(live_owners);
+    header_starts   = std::move(live_starts);
+
+    if (fOptions.fVerbose)
+      kConsoleOut << "gc-sections: removed " << removed_objects << " range(s), " << removed_bytes
+                  << " byte(s).\n";
+  }
+
+  // step 2.30: fold identical code, the folded ranges keep their headers as aliases.
+
+  std::vector<SizeType> folded_into(object_ranges.size(), object_ranges.size());
+
+  if (fOptions.fICFMode != kICFNone) {
+    folded_into = this->FoldIdenticalObjects(command_headers, object_ranges, header_starts,
+                                             header_symbols, symbol_table);
+
+    SizeType folded_bytes   = 0UL;
+    SizeType folded_objects = 0UL;
+
+    for (SizeType object_index = 0UL; object_index < folded_into.size(); ++object_index) {
+      if (folded_into[object_index] == folded_into.size()) continue;
+
+      if (fOptions.fVerbose)
+        kConsoleOut << "icf: folding " << ld_range_name(object_index) << " into "
+                    << ld_range_name(folded_into[object_index]) << "\n";
+
+      folded_bytes += fObjectBytes[object_index].mBlob.size();
+      ++folded_objects;
+
+      fObjectBytes[object_index].mBlob = {};
+
+      link_state.fObjects[object_index].fFlags |= CompilerKit::Utils::kLinkStateObjectFolded;
+      link_state.fObjects[folded_into[object_index]].fFlags |=
+          CompilerKit::Utils::kLinkStateObjectFoldTarget;
+    }
+
+    if (fOptions.fVerbose)
+      kConsoleOut << "icf: folded " << folded_objects << " range(s), " << folded_bytes
+                  << " byte(s).\n";
+  }
+
+  // step 3: check for errors (recheck if we have those symbols.)
+
+  if (!fStartFound && fOptions.fExecutable) {
+    if (fOptions.fVerbose)
+      kConsoleOut << "Undefined entrypoint: " << fOptions.fStart
+                  << ", you may have forget to link "
+                     "against the C++ runtime library.\n";
+
+    kConsoleOut << "Undefined entrypoint " << fOptions.fStart
+                << " for executable: " << fOptions.fOutput << "\n";
+  }
+
+  // step 4: write all PEF commands.
+
+  CompilerKit::PEFCommandHeader date_cmd_hdr{};
+
+  time_t timestamp = this->BuildEpoch();
+
+  CompilerKit::STLString timeStampStr = kPefBuildEpochName;
+  timeStampStr += std::to_string(timestamp);
+
+  strncpy(date_cmd_hdr.Name, timeStampStr.c_str(), timeStampStr.size());
+
+  date_cmd_hdr.Flags       = 0;
+  date_cmd_hdr.Kind        = CompilerKit::kPefZero;
+  date_cmd_hdr.Offset      = pef_container.HdrSz;
+  date_cmd_hdr.VirtualSize = timeStampStr.size();
+
+  command_headers.push_back(date_cmd_hdr);
+
+  CompilerKit::PEFCommandHeader abi_cmd_hdr{};
+
+  CompilerKit::STLString abi = kLinkerAbiContainer;
+
+  switch (fOptions.fArch) {
+    case CompilerKit::kPefArchAMD64: {
+      abi += "MSFT";
+      break;
+    }
+    case CompilerKit::kPefArchPowerPC: {
+      abi += "SYSV";
+      break;
+    }
+    case CompilerKit::kPefArch32000:
+    case CompilerKit::kPefArch64000: {
+      abi += "_NEP";
+      break;
+    }
+    default: {
+      abi += "_IDK";
+      break;
+    }
+  }
+
+  std::memcpy(abi_cmd_hdr.Name, abi.c_str(), abi.size());
+
+  abi_cmd_hdr.VirtualSize = abi.size();
+  abi_cmd_hdr.Offset      = pef_container.HdrSz;
+  abi_cmd_hdr.Flags       = 0;
+  abi_cmd_hdr.Kind        = CompilerKit::kPefLinkerID;
+
+  command_headers.push_back(abi_cmd_hdr);
+
+  CompilerKit::PEFCommandHeader stack_cmd_hdr{0};
+
+  stack_cmd_hdr.Cpu         = fOptions.fArch;
+  stack_cmd_hdr.Flags       = 0;
+  stack_cmd_hdr.VirtualSize = sizeof(uintptr_t);
+  stack_cmd_hdr.Offset      = 0;
+
+  std::memcpy(stack_cmd_hdr.Name, kLinkerStackSizeSymbol, strlen(kLinkerStackSizeSymbol));
+
+  command_headers.push_back(stack_cmd_hdr);
+
+  CompilerKit::PEFCommandHeader uuid_cmd_hdr{};
+
+  auto uuidStr = this->ContainerUUID();
+
+  std::memcpy(uuid_cmd_hdr.Name, kPefGUIDName, strlen(kPefGUIDName));
+  std::memcpy(uuid_cmd_hdr.Name + strlen(kPefGUIDName), uuidStr.c_str(), uuidStr.size());
+
+  uuid_cmd_hdr.VirtualSize = strlen(uuid_cmd_hdr.Name);
+  uuid_cmd_hdr.Offset      = pef_container.HdrSz;
+  uuid_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
+  uuid_cmd_hdr.Kind        = CompilerKit::kPefZero;
+
+  command_headers.push_back(uuid_cmd_hdr);
+
+  if (fOptions.fPageSize) {
+    CompilerKit::PEFCommandHeader page_cmd_hdr{};
+
+    CompilerKit::STLString page_size = kPefPageSizeName + std::to_string(fOptions.fPageSize);
+
+    std::memcpy(page_cmd_hdr.Name, page_size.c_str(), page_size.size());
+
+    page_cmd_hdr.VirtualSize = page_size.size();
+    page_cmd_hdr.Offset      = pef_container.HdrSz;
+    page_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
+    page_cmd_hdr.Kind        = CompilerKit::kPefZero;
+
+    command_headers.push_back(page_cmd_hdr);
+  }
+
+  auto ld_object_written = [&](SizeType object_index) {
+    return !(link_state.fObjects[object_index].fFlags &
+             (CompilerKit::Utils::kLinkStateObjectDropped |
+              CompilerKit::Utils::kLinkStateObjectFolded));
+  };
+
+  // runtime imports, calls go through a stub and a pointer the loader binds on first call, or at
+  // load time with -bind-now. Slot 0 of the stubs and pointers belongs to the binder.
+  std::vector<CompilerKit::SymbolId> imports;
+  std::vector<UInt32>                import_slots(symbol_table.Count(), 0U);
+
+  if (fOptions.fArch == CompilerKit::kPefArchAMD64) {
+    // the import's header is the first one written, its first object may be dropped or folded.
+    for (SizeType index = 0UL; index < header_owners.size(); ++index) {
+      if (!ld_is_runtime(command_headers[index]) || !ld_object_written(header_owners[index]))
+        continue;
+
+      auto id = header_symbols[index];
+
+      if (symbol_table[id].fDefinition >= 0 && ld_object_written(symbol_places[id].first))
+        continue;
+
+      symbol_table[id].fDefinition = index;
+      symbol_places[id]            = {header_owners[index], header_starts[index]};
+    }
+
+    for (CompilerKit::SymbolId id = 0U; id < symbol_table.Count(); ++id) {
+      auto definition = symbol_table[id].fDefinition;
+
+      if (definition < 0 || !ld_is_runtime(command_headers[definition]) ||
+          !ld_object_written(symbol_places[id].first))
+        continue;
+
+      imports.push_back(id);
+      import_slots[id] = imports.size();
+    }
+  }
+
+  std::vector<Char> import_stubs, import_pointers, import_table;
+
+  if (!imports.empty()) {
+    import_stubs.resize((imports.size() + 1) * kLinkerStubSize, 0);
+    import_pointers.resize((imports.size() + 1) * sizeof(UInt64), 0);
+    import_table.resize(sizeof(CompilerKit::PEFImportTable) +
+                            imports.size() * sizeof(CompilerKit::PEFImport),
+                        0);
+
+    const std::pair<const Char*, std::vector<Char>*> kImportHeaders[] = {
+        {kPefStubsName, &import_stubs},
+        {kPefPointersName, &import_pointers},
+        {kPefImportsName, &import_table},
+    };
+
+    for (auto [name, bytes] : kImportHeaders) {
+      CompilerKit::PEFCommandHeader import_cmd_hdr{};
+
+      std::memcpy(import_cmd_hdr.Name, name, strlen(name));
+
+      import_cmd_hdr.Cpu         = fOptions.fArch;
+      import_cmd_hdr.VirtualSize = bytes->size();
+      import_cmd_hdr.OffsetSize  = bytes->size();
+      import_cmd_hdr.Offset      = pef_container.HdrSz;
+      import_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
+      import_cmd_hdr.Kind        = bytes == &import_stubs      ? CompilerKit::kPefCode
+                                   : bytes == &import_pointers ? CompilerKit::kPefData
+                                                               : CompilerKit::kPefZero;
+
+      command_headers.push_back(import_cmd_hdr);
+    }
+  }
+
+  // a call to an import is bound to its stub here, anything else is left to the loader.
+  auto ld_fixup_stubbed = [&](const LinkerFixup& fixup) {
+    return fixup.fRuntime != CompilerKit::kSymbolInvalid && import_slots[fixup.fRuntime] != 0U &&
+           fixup.fKind == CompilerKit::kAERelocRel32;
+  };
+
+  SizeType runtime_fixups = 0UL;
+
+  for (auto& fixup : fFixups) {
+    if (fixup.fRuntime != CompilerKit::kSymbolInvalid && !ld_fixup_stubbed(fixup) &&
+        ld_object_written(fixup.fObject))
+      ++runtime_fixups;
+  }
+
+  if (runtime_fixups > 0) {
+    CompilerKit::PEFCommandHeader reloc_cmd_hdr{};
+
+    std::memcpy(reloc_cmd_hdr.Name, kPefRelocationsName, strlen(kPefRelocationsName));
+
+    reloc_cmd_hdr.VirtualSize = runtime_fixups * sizeof(CompilerKit::PEFRelocation);
+    reloc_cmd_hdr.OffsetSize  = reloc_cmd_hdr.VirtualSize;
+    reloc_cmd_hdr.Offset      = pef_container.HdrSz;
+    reloc_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
+    reloc_cmd_hdr.Kind        = CompilerKit::kPefZero;
+
+    command_headers.push_back(reloc_cmd_hdr);
+  }
+
+  // exported symbols of a dylib, a loader binds them through the table's hash lookup.
+  std::vector<Char>                  export_table;
+  std::vector<CompilerKit::SymbolId> exported;
+
+  if (!fOptions.fExecutable) {
+    export_table = ld_build_exports(command_headers, symbol_table, exported);
+
+    CompilerKit::PEFCommandHeader exports_cmd_hdr{};
+
+    std::memcpy(exports_cmd_hdr.Name, kPefExportsName, strlen(kPefExportsName));
+
+    exports_cmd_hdr.VirtualSize = export_table.size();
+    exports_cmd_hdr.OffsetSize  = exports_cmd_hdr.VirtualSize;
+    exports_cmd_hdr.Offset      = pef_container.HdrSz;
+    exports_cmd_hdr.Flags       = CompilerKit::kPefLinkerID;
+    exports_cmd_hdr.Kind        = CompilerKit::kPefZero;
+
+    command_headers.push_back(exports_cmd_hdr);
+  }
+
+  // compressed ranges, its size is only known once the image is compressed, see step 4.7.
+  if (fOptions.fCompress) {
+    CompilerKit::PEFCommandHeader compressed_cmd_hdr{};
+
+    std::memcpy(compressed_cmd_hdr.Name, kPefCompressedName, strlen(kPefCompressedName));
+
+    compressed_cmd_hdr.Offset = pef_container.HdrSz;
+    compressed_cmd_hdr.Flags  = CompilerKit::kPefLinkerID;
+    compressed_cmd_hdr.Kind   = CompilerKit::kPefZero;
+
+    command_headers.push_back(compressed_cmd_hdr);
+  }
+
+  constexpr Int32 kPaddingOffset = 16;
+
+  size_t previous_offset =
+      (command_headers.size() * sizeof(CompilerKit::PEFCommandHeader)) + kPaddingOffset;
+
+  CompilerKit::PEFCommandHeader end_exec_hdr{};
+
+  end_exec_hdr.Offset = pef_container.HdrSz;
+  end_exec_hdr.Flags  = CompilerKit::kPefLinkerID;
+  end_exec_hdr.Kind   = CompilerKit::kPefZero;
+
+  std::memcpy(end_exec_hdr.Name, kPefEndName, strlen(kPefEndName));
+
+  end_exec_hdr.VirtualSize = strlen(end_exec_hdr.Name);
+
+  command_headers.push_back(end_exec_hdr);
+
+  // step 4.5: layout, every object owns a slot, in incremental mode with slack so it can be
+  // patched later. A header lands at its object's offset plus the start of its record, offsets
+  // count from the end of the header table until its size is known, see step 4.8.
+
+  SizeType written_count = 0UL;
+
+  auto ld_layout_header = [&](CompilerKit::PEFCommandHeader& command_hdr) -> Bool {
+    // ignore :UndefinedSymbol: headers, they do not contain code.
+    if (ld_is_undefined(command_hdr)) return false;
+
+    command_hdr.Offset += previous_offset;
+    previous_offset += command_hdr.VirtualSize;
+
+    ++written_count;
+
+    return true;
+  };
+
+  // the order file's ranges first, the others in input order.
+  std::vector<SizeType> layout_order(object_ranges.size(), 0UL);
+
+  std::iota(layout_order.begin(), layout_order.end(), 0UL);
+
+  if (!fOptions.fOrderSymbols.empty())
+    layout_order = this->LayoutOrder(command_headers, symbol_places, folded_into, symbol_table);
+
+  // a folded object writes its headers over the code of its target, in input order as well.
+  for (SizeType object_index = 0UL, first_header = 0UL; object_index < object_ranges.size();
+       ++object_index) {
+    auto& slot = link_state.fObjects[object_index];
+
+    slot.fFirstHeader = first_header;
+
+    for (auto index = object_ranges[object_index].first;
+         index < object_ranges[object_index].second; ++index) {
+      if (!ld_is_undefined(command_headers[index])) ++slot.fHeaderCount;
+    }
+
+    written_count += slot.fHeaderCount;
+    first_header += slot.fHeaderCount;
+  }
+
+  for (auto index = object_ranges.empty() ? 0UL : object_ranges.back().second;
+       index < command_headers.size(); ++index) {
+    ld_layout_header(command_headers[index]);
+  }
+
+  std::vector<SizeType> object_offsets(object_ranges.size(), 0UL);
+  std::vector<UInt32>   protections(object_ranges.size(), 0U);
+  SizeType              stubs_offset    = 0UL;
+  SizeType              pointers_offset = 0UL;
+
+  // bytes of an object's slot, its code and the slack of an incremental link.
+  auto ld_slot_size = [&](SizeType object_index) -> SizeType {
+    auto& slot = link_state.fObjects[object_index];
+
+    if (!fOptions.fIncremental) return object_sizes[object_index];
+
+    slot.fBlobReserve = CompilerKit::Utils::link_state_reserve(object_sizes[object_index],
+                                                               fOptions.fIncrementalSlack);
+    return slot.fBlobReserve;
+  };
+
+  if (!fOptions.fPageSize) {
+    SizeType cursor = 0UL;
+
+    for (auto object_index : layout_order) {
+      if (!ld_object_written(object_index)) continue;
+
+      object_offsets[object_index] = cursor;
+      cursor += ld_slot_size(object_index);
+    }
+  } else {
+    // step 4.6: page-aligned layout, a segment per protection, each starting on a page.
+    // offsets become file offsets, and virtual addresses stay congruent to them modulo the page
+    // size, so a loader can map every segment in place.
+
+    auto ld_page_align = [&](SizeType offset) {
+      return (offset + fOptions.fPageSize - 1) & ~(fOptions.fPageSize - 1);
+    };
+
+    for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+      protections[object_index] =
+          ld_object_protection(command_headers, object_ranges[object_index]);
+    }
+
+    // code, then code mixed with data, then data, then zero-fill which takes no file bytes.
+    const UInt32 kSegments[] = {
+        CompilerKit::kPefFlagRead | CompilerKit::kPefFlagExec,
+        CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite | CompilerKit::kPefFlagExec,
+        CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite,
+        CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite | CompilerKit::kPefFlagZeroFill,
+    };
+
+    SizeType cursor = ld_page_align(pef_container.HdrSz +
+                                    written_count * sizeof(CompilerKit::PEFCommandHeader));
+
+    for (auto segment : kSegments) {
+      cursor = ld_page_align(cursor);
+
+      for (auto object_index : layout_order) {
+        if (protections[object_index] != segment || !ld_object_written(object_index)) continue;
+
+        object_offsets[object_index] = cursor;
+
+        if (segment & CompilerKit::kPefFlagZeroFill) {
+          // the zero-fill segment only exists in memory, past the end of the file, as far as
+          // its last record ends.
+          SizeType virtual_size = object_sizes[object_index];
+
+          for (auto index = object_ranges[object_index].first;
+               index < object_ranges[object_index].second; ++index) {
+            if (!ld_is_undefined(command_headers[index]))
+              virtual_size = std::max<SizeType>(
+                  virtual_size, header_starts[index] + command_headers[index].VirtualSize);
+          }
+
+          fObjectBytes[object_index].mBlob = {};
+          cursor += virtual_size;
+        } else {
+          cursor += ld_slot_size(object_index);
+        }
+      }
+
+      // stubs end the code segment, and their pointers the data one.
+      if (!imports.empty() &&
+          segment == (CompilerKit::kPefFlagRead | CompilerKit::kPefFlagExec)) {
+        stubs_offset = cursor;
+        cursor += import_stubs.size();
+      } else if (!imports.empty() &&
+                 segment == (CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite)) {
+        pointers_offset = cursor;
+        cursor += import_pointers.size();
+      }
+    }
+  }
+
+  // every header of an object lands on its record, a folded object's on its target's code.
+  for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+    auto owner = folded_into[object_index] != folded_into.size() ? folded_into[object_index]
+                                                                 : object_index;
+
+    if (!ld_object_written(owner)) continue;
+
+    for (auto index = object_ranges[object_index].first;
+         index < object_ranges[object_index].second; ++index) {
+      auto& command_hdr = command_headers[index];
+
+      if (ld_is_undefined(command_hdr)) continue;
+
+      command_hdr.Offset = object_offsets[owner] + header_starts[index];
+
+      if (!fOptions.fPageSize) continue;
+
+      command_hdr.Flags |= protections[owner];
+
+      if (command_hdr.Kind == CompilerKit::kPefZero)
+        command_hdr.Flags |= CompilerKit::kPefFlagZeroFill;
+
+      // no file bytes behind a zero-fill segment.
+      if (protections[owner] & CompilerKit::kPefFlagZeroFill) command_hdr.OffsetSize = 0UL;
+    }
+  }
+
+  // blobs are written in the order of their offsets.
+  std::vector<SizeType> blob_order;
+
+  for (auto object_index : layout_order) {
+    if (ld_object_written(object_index)) blob_order.push_back(object_index);
+  }
+
+  std::stable_sort(blob_order.begin(), blob_order.end(), [&](SizeType lhs, SizeType rhs) {
+    return object_offsets[lhs] < object_offsets[rhs];
+  });
+
+  // Finally gather the command headers, as they'll be written.
+  std::vector<CompilerKit::PEFCommandHeader> image_headers;
+  std::vector<UInt32>                        image_index(command_headers.size(), 0U);
+  SizeType                                   reloc_header   = 0UL;
+  SizeType                                   exports_header = 0UL;
+  SizeType                                   stubs_header    = 0UL;
+  SizeType                                   pointers_header = 0UL;
+  SizeType                                   imports_header  = 0UL;
+  SizeType                                   compressed_header = 0UL;
+
+  image_headers.reserve(command_headers.size());
+
+  // -split-debug keeps a header per kind of an object's records, named after the kind, the
+  // symbol headers and the build epoch go to the .dbg. Folded objects alias their target's runs.
+  std::vector<CompilerKit::PEFCommandHeader> debug_headers;
+
+  SizeType objects_end  = object_ranges.empty() ? 0UL : object_ranges.back().second;
+  SizeType owner        = 0UL;
+  SizeType run_owner    = fObjectList.size();
+  SizeType start_header = command_headers.size();
+
+  // the headers placed by the layout, their offsets still count from the end of the table.
+  std::vector<Bool> image_placed, debug_placed;
+
+  for (SizeType index = 0UL; index < command_headers.size(); ++index) {
+    auto& command_hdr = command_headers[index];
+
+    if (ld_is_undefined(command_hdr)) continue;
+
+    if (std::strcmp(command_hdr.Name, kPefRelocationsName) == 0) reloc_header = index;
+    if (std::strcmp(command_hdr.Name, kPefExportsName) == 0) exports_header = index;
+    if (std::strcmp(command_hdr.Name, kPefStubsName) == 0) stubs_header = index;
+    if (std::strcmp(command_hdr.Name, kPefPointersName) == 0) pointers_header = index;
+    if (std::strcmp(command_hdr.Name, kPefImportsName) == 0) imports_header = index;
+    if (std::strcmp(command_hdr.Name, kPefCompressedName) == 0) compressed_header = index;
+
+    /// it is always a code64 container. And should equal to fStart as well.
+    /// the container is emitted last, so pef_container.Start is final by then.
+    if (this->IsStart(command_hdr)) {
+      start_header = index;
+    }
+
+    if (fOptions.fVerbose) {
+      kConsoleOut << "Command name: " << command_hdr.Name << "\n";
+      kConsoleOut << "VirtualAddress of command content: " << command_hdr.Offset << "\n";
+    }
+
+    if (fOptions.fSplitDebug) {
+      Bool in_object = index < objects_end;
+      Bool epoch     = ld_has_prefix(command_hdr, kPefBuildEpochName);
+
+      while (in_object && index >= object_ranges[owner].second) ++owner;
+
+      if (in_object || epoch || ld_has_prefix(command_hdr, kPefGUIDName)) {
+        debug_headers.push_back(command_hdr);
+        debug_placed.push_back(in_object);
+      }
+
+      if (epoch || (in_object && folded_into[owner] != folded_into.size())) continue;
+
+      if (in_object && !ld_is_runtime(command_hdr)) {
+        if (run_owner == fRanges[owner].fObject) continue;
+
+        // an object's records of a kind make a run, as long as they were laid out back to back.
+        // Its runs are written in place of its first record.
+        run_owner = fRanges[owner].fObject;
+
+        std::vector<SizeType> records;
+
+        for (auto range = owner;
+             range < object_ranges.size() && fRanges[range].fObject == run_owner; ++range) {
+          if (folded_into[range] != folded_into.size()) continue;
+
+          for (auto record = object_ranges[range].first; record < object_ranges[range].second;
+               ++record) {
+            if (!ld_is_undefined(command_headers[record]) &&
+                !ld_is_runtime(command_headers[record]))
+              records.push_back(record);
+          }
+        }
+
+        std::stable_sort(records.begin(), records.end(), [&](SizeType lhs, SizeType rhs) {
+          return command_headers[lhs].Offset < command_headers[rhs].Offset;
+        });
+
+        SizeType first_run = image_headers.size();
+
+        for (auto record : records) {
+          auto& record_hdr = command_headers[record];
+
+          if (image_headers.size() > first_run && image_headers.back().Kind == record_hdr.Kind &&
+              record_hdr.Offset <= image_headers.back().Offset + image_headers.back().VirtualSize) {
+            auto& run = image_headers.back();
+            auto  end =
+                std::max(run.Offset + run.VirtualSize, record_hdr.Offset + record_hdr.VirtualSize);
+
+            // a run of a zero-fill segment has no file bytes.
+            run.VirtualSize = end - run.Offset;
+            run.OffsetSize  = (run.OffsetSize || record_hdr.OffsetSize) ? run.VirtualSize : 0UL;
+          } else {
+            image_headers.push_back(record_hdr);
+            image_placed.push_back(true);
+
+            ld_strip_symbol(image_headers.back());
+          }
+
+          image_index[record] = image_headers.size() - 1;
+        }
+
+        continue;
+      }
+    }
+
+    image_index[index] = image_headers.size();
+    image_headers.push_back(command_hdr);
+    image_placed.push_back(index < objects_end);
+  }
+
+  for (SizeType object_index = 0UL; fOptions.fSplitDebug && object_index < object_ranges.size();
+       ++object_index) {
+    if (folded_into[object_index] == folded_into.size()) continue;
+
+    auto target = object_ranges[folded_into[object_index]].first;
+
+    for (auto index = object_ranges[object_index].first;
+         index < object_ranges[object_index].second; ++index) {
+      if (ld_is_undefined(command_headers[index])) continue;
+
+      while (ld_is_undefined(command_headers[target])) ++target;
+
+      image_index[index] = image_index[target++];
+    }
+  }
+
+  // readers walk the headers by this count, Container:Compressed is found that way.
+  pef_container.Count = image_headers.size();
+
+  // step 4.8: the header table's size is known, the objects' code starts right after it.
+  // page-aligned offsets are file offsets already.
+  SizeType data_start = fOptions.fPageSize ? 0UL
+                                           : sizeof(CompilerKit::PEFContainer) +
+                                                 image_headers.size() *
+                                                     sizeof(CompilerKit::PEFCommandHeader);
+
+  auto ld_place_headers = [&](std::vector<CompilerKit::PEFCommandHeader>& headers,
+                              const std::vector<Bool>&                    placed) {
+    for (SizeType index = 0UL; index < headers.size(); ++index) {
+      if (!placed[index]) continue;
+
+      headers[index].Offset += data_start;
+      headers[index].VirtualAddress = kLinkerDefaultOrigin + headers[index].Offset;
+    }
+  };
+
+  ld_place_headers(image_headers, image_placed);
+  ld_place_headers(debug_headers, debug_placed);
+
+  if (start_header != command_headers.size())
+    pef_container.Start = data_start + command_headers[start_header].Offset;
+
+  // blobs with fixups get a copy to patch, once the image says where everything lands. Streamed
+  // links only copy the places, a slot per fixup, unless the object's fixups overlap.
+  std::vector<Char*> patched_blobs(object_ranges.size(), nullptr);
+  std::vector<Bool>  patched_places(object_ranges.size(), false);
+
+  fPatchedBlobs.reserve(object_ranges.size());
+
+  if (fOptions.fStreaming) fPatchedPlaces.resize(fFixups.size() * sizeof(Int64));
+
+  for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+    auto& blob         = fObjectBytes[object_index];
+    auto [first, last] = fObjectFixups[object_index];
+
+    if (first == last || blob.mBlob.empty()) continue;
+
+    Bool apart = fOptions.fStreaming;
+
+    for (auto fixup = first + 1; apart && fixup < last; ++fixup) {
+      apart = fFixups[fixup - 1].fOffset + ld_fixup_width(fFixups[fixup - 1].fKind) <=
+              fFixups[fixup].fOffset;
+    }
+
+    if (apart) {
+      for (auto fixup = first; fixup < last; ++fixup) {
+        std::memcpy(fPatchedPlaces.data() + fixup * sizeof(Int64),
+                    blob.mBlob.data() + fFixups[fixup].fOffset,
+                    ld_fixup_width(fFixups[fixup].fKind));
+      }
+
+      patched_blobs[object_index]  = fPatchedPlaces.data() + first * sizeof(Int64);
+      patched_places[object_index] = true;
+
+      continue;
+    }
+
+    fPatchedBlobs.emplace_back(blob.mBlob.begin(), blob.mBlob.end());
+
+    blob.mBlob                  = fPatchedBlobs.back();
+    blob.mFile                  = nullptr;
+    patched_blobs[object_index] = fPatchedBlobs.back().data();
+  }
+
+  // what layout and folding read is dropped, the code is read again from the inputs as it's
+  // emitted.
+  if (fOptions.fStreaming) {
+    for (auto& object_map : fObjectMaps) object_map.Release();
+    for (auto& archive_map : fArchiveMaps) archive_map.Release();
+  }
+
+  // step 2.5: lay out program bytes, every offset is known past this point.
+
+  CompilerKit::Utils::ImageWriter image;
+  std::vector<SizeType>           object_bases(object_ranges.size(), 0UL);
+
+  image.Append(&pef_container, sizeof(CompilerKit::PEFContainer));
+  image.Append(image_headers.data(), image_headers.size() * sizeof(CompilerKit::PEFCommandHeader));
+
+  link_state.fHeader.fDataStart = image.Size();
+
+  // import stubs and pointers, at the end of their segment when page-aligned, after the blobs
+  // otherwise.
+  Bool stubs_written = imports.empty(), pointers_written = imports.empty();
+
+  auto ld_append_imports = [&](SizeType up_to) {
+    const std::tuple<std::vector<Char>*, SizeType*, Bool*> kPieces[] = {
+        {&import_stubs, &stubs_offset, &stubs_written},
+        {&import_pointers, &pointers_offset, &pointers_written},
+    };
+
+    for (auto [bytes, offset, written] : kPieces) {
+      if (*written || (fOptions.fPageSize && *offset > up_to)) continue;
+
+      if (fOptions.fPageSize)
+        image.AppendZeros(*offset - image.Size());
+      else
+        *offset = image.Size();
+
+      image.Append(bytes->data(), bytes->size());
+      *written = true;
+    }
+  };
+
+  // streamed blobs are copied from their input when emitting, around their patched places.
+  auto ld_append_blob = [&](SizeType object_index) {
+    auto& blob = fObjectBytes[object_index];
+
+    auto ld_append_range = [&](SizeType from, SizeType to) {
+      if (fOptions.fStreaming && blob.mFile)
+        image.AppendFile(blob.mFile, blob.mFileOffset + from, to - from);
+      else
+        image.Append(blob.mBlob.data() + from, to - from);
+    };
+
+    SizeType cursor = 0UL;
+
+    if (patched_places[object_index]) {
+      auto [first, last] = fObjectFixups[object_index];
+
+      for (auto fixup = first; fixup < last; ++fixup) {
+        ld_append_range(cursor, fFixups[fixup].fOffset);
+
+        cursor = fFixups[fixup].fOffset + ld_fixup_width(fFixups[fixup].fKind);
+        image.Append(patched_blobs[object_index] + (fixup - first) * sizeof(Int64),
+                     ld_fixup_width(fFixups[fixup].fKind));
+      }
+    }
+
+    ld_append_range(cursor, blob.mBlob.size());
+  };
+
+  // -compress packs the blobs into ranges of about kLinkerCompressedRange bytes.
+  SizeType compressed_start = ~0UL;
+
+  for (auto object_index : blob_order) {
+    auto& struct_of_blob = fObjectBytes[object_index];
+    auto& slot           = link_state.fObjects[object_index];
+
+    if (fOptions.fCompress && compressed_start == ~0UL) {
+      image.BeginCompressed();
+      compressed_start = image.Size();
+    }
+
+    if (fOptions.fPageSize && !struct_of_blob.mBlob.empty())
+      ld_append_imports(data_start + object_offsets[object_index]);
+
+    object_bases[object_index] = data_start + object_offsets[object_index];
+
+    // nothing to write for a zero-fill object, its place is past the end of the file.
+    if (fOptions.fPageSize && struct_of_blob.mBlob.empty()) continue;
+
+    // pad up to the object's offset, a page boundary or the end of the previous slot.
+    image.AppendZeros(object_bases[object_index] - image.Size());
+
+    slot.fBlobOffset = image.Size();
+    slot.fBlobSize   = struct_of_blob.mBlob.size();
+
+    ld_append_blob(object_index);
+
+    if (fOptions.fIncremental) {
+      slot.fHeaderBase     = slot.fBlobOffset;
+      slot.fVirtualSize    = slot.fBlobSize;
+      slot.fVirtualReserve = slot.fBlobReserve;
+
+      image.AppendZeros(slot.fBlobReserve - slot.fBlobSize);
+    }
+
+    if (compressed_start != ~0UL && image.Size() - compressed_start >= kLinkerCompressedRange) {
+      image.EndCompressed();
+      compressed_start = ~0UL;
+    }
+  }
+
+  if (compressed_start != ~0UL) image.EndCompressed();
+
+  ld_append_imports(~0UL);
+
+  // step 2.6: apply the fixups, one sweep per blob, the image maps at kLinkerDefaultOrigin.
+
+  for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+    if (folded_into[object_index] != folded_into.size())
+      object_bases[object_index] = object_bases[folded_into[object_index]];
+  }
+
+  std::vector<CompilerKit::PEFRelocation> runtime_relocations;
+  SizeType                                applied_fixups = 0UL;
+
+  for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+    auto [first, last] = fObjectFixups[object_index];
+
+    if (first == last || !ld_object_written(object_index)) continue;
+
+    for (auto fixup = first; fixup < last; ++fixup) {
+      auto&    entry = fFixups[fixup];
+      SizeType place = object_bases[object_index] + entry.fOffset;
+
+      if (entry.fRuntime != CompilerKit::kSymbolInvalid && !ld_fixup_stubbed(entry)) {
+        runtime_relocations.push_back(
+            {.Offset = place,
+             .Header = image_index[symbol_table[entry.fRuntime].fDefinition],
+             .Kind   = entry.fKind,
+             .Flags  = CompilerKit::kKindRelocationAtRuntime,
+             .Addend = entry.fAddend});
+        continue;
+      }
+
+      // nothing to patch in a zero-fill segment.
+      if (!patched_blobs[object_index]) continue;
+
+      Int64 value = kLinkerDefaultOrigin + entry.fAddend;
+
+      if (ld_fixup_stubbed(entry))
+        value += stubs_offset + import_slots[entry.fRuntime] * kLinkerStubSize;
+      else
+        value += object_bases[entry.fTarget] + entry.fTargetStart;
+
+      if (entry.fKind == CompilerKit::kAERelocRel32) value -= kLinkerDefaultOrigin + place;
+
+      Int64 lowest  = INT32_MIN;
+      Int64 highest = entry.fKind == CompilerKit::kAERelocRel32 ? INT32_MAX : UINT32_MAX;
+
+      if (entry.fKind != CompilerKit::kAERelocAbs64 && (value < lowest || value > highest)) {
+        auto& range = fRanges[object_index];
+
+        kConsoleOut << "relocation out of range in: " << fObjectList[range.fObject]
+                    << ", at offset: " << range.fFrom + entry.fOffset << "\n";
+
+        return NECTI_EXEC_ERROR;
+      }
+
+      auto target = patched_places[object_index]
+                        ? patched_blobs[object_index] + (fixup - first) * sizeof(Int64)
+                        : patched_blobs[object_index] + entry.fOffset;
+
+      if (entry.fKind == CompilerKit::kAERelocAbs64) {
+        std::memcpy(target, &value, sizeof(Int64));
+      } else {
+        Int32 value32 = static_cast<Int32>(value);
+        std::memcpy(target, &value32, sizeof(Int32));
+      }
+
+      ++applied_fixups;
+    }
+  }
+
+  if (!imports.empty()) {
+    this->WriteImports(imports, import_slots, image_index, symbol_table, stubs_offset,
+                       pointers_offset, import_stubs, import_pointers, import_table);
+
+    const std::pair<SizeType, SizeType> kImportPlaces[] = {
+        {stubs_header, stubs_offset},
+        {pointers_header, pointers_offset},
+    };
+
+    for (auto [header, offset] : kImportPlaces) {
+      image_headers[image_index[header]].Offset         = offset;
+      image_headers[image_index[header]].VirtualAddress = kLinkerDefaultOrigin + offset;
+    }
+
+    if (fOptions.fPageSize) {
+      image_headers[image_index[stubs_header]].Flags |=
+          CompilerKit::kPefFlagRead | CompilerKit::kPefFlagExec;
+      image_headers[image_index[pointers_header]].Flags |=
+          CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite;
+    }
+
+    image_headers[image_index[imports_header]].Offset = image.Size();
+
+    image.Append(import_table.data(), import_table.size());
+  }
+
+  if (!runtime_relocations.empty()) {
+    image_headers[image_index[reloc_header]].Offset = image.Size();
+
+    image.Append(runtime_relocations.data(),
+                 runtime_relocations.size() * sizeof(CompilerKit::PEFRelocation));
+  }
+
+  if (!exported.empty()) {
+    auto symbols = export_table.data() +
+                   reinterpret_cast<CompilerKit::ExportHeader*>(export_table.data())->fSymbols;
+
+    for (SizeType slot = 0UL; slot < exported.size(); ++slot) {
+      CompilerKit::ExportSymbol symbol;
+      std::memcpy(&symbol, symbols + slot * sizeof(symbol), sizeof(symbol));
+
+      auto [owner, start] = symbol_places[exported[slot]];
+
+      link_state.fObjects[owner].fFlags |= CompilerKit::Utils::kLinkStateObjectExported;
+
+      symbol.fHeader         = image_index[symbol_table[exported[slot]].fDefinition];
+      symbol.fOffset         = object_bases[owner] + start;
+      symbol.fVirtualAddress = kLinkerDefaultOrigin + symbol.fOffset;
+
+      std::memcpy(symbols + slot * sizeof(symbol), &symbol, sizeof(symbol));
+    }
+  }
+
+  if (!export_table.empty()) {
+    image_headers[image_index[exports_header]].Offset = image.Size();
+
+    image.Append(export_table.data(), export_table.size());
+  }
+
+  if (fOptions.fVerbose)
+    kConsoleOut << "relocations: " << applied_fixups << " applied, " << runtime_relocations.size()
+                << " left to the loader, " << imports.size() << " import(s) "
+                << (fOptions.fBindNow ? "bound at load time.\n" : "bound on first call.\n");
+
+  // step 4.7: compress the ranges, the headers whose bytes shrank are flagged, the table of
+  // ranges goes last and its header is the one offset into the file.
+  std::vector<CompilerKit::PEFCompressedRange> compressed_ranges;
+
+  if (fOptions.fCompress) {
+    auto ranges = image.Compress();
+
+    for (auto& range : ranges) {
+      if (range.fBytes.empty()) continue;
+
+      compressed_ranges.push_back({.Offset     = range.fOffset,
+                                   .Size       = range.fSize,
+                                   .FileOffset = range.fFileOffset,
+                                   .FileSize   = range.fBytes.size(),
+                                   .Codec      = CompilerKit::kPefCodecLZ,
+                                   .Flags      = 0U});
+    }
+
+    auto ld_compressed = [&](SizeType offset) {
+      auto range = std::upper_bound(
+          compressed_ranges.begin(), compressed_ranges.end(), offset,
+          [](SizeType place, const CompilerKit::PEFCompressedRange& entry) {
+            return place < entry.Offset;
+          });
+
+      return range != compressed_ranges.begin() && offset < (range - 1)->Offset + (range - 1)->Size;
+    };
+
+    // folded objects alias the bytes of the object they fold into.
+    for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+      auto owner = folded_into[object_index] != folded_into.size() ? folded_into[object_index]
+                                                                   : object_index;
+
+      if (!ld_object_written(owner) || fObjectBytes[owner].mBlob.empty() ||
+          !ld_compressed(object_bases[owner]))
+        continue;
+
+      for (auto index = object_ranges[object_index].first;
+           index < object_ranges[object_index].second; ++index) {
+        if (!ld_is_undefined(command_headers[index]))
+          image_headers[image_index[index]].Flags |= CompilerKit::kPefFlagCompressed;
+      }
+    }
+
+    auto& compressed_hdr = image_headers[image_index[compressed_header]];
+
+    compressed_hdr.Offset      = image.FileSize();
+    compressed_hdr.OffsetSize  = compressed_ranges.size() * sizeof(CompilerKit::PEFCompressedRange);
+    compressed_hdr.VirtualSize = compressed_hdr.OffsetSize;
+
+    if (!compressed_ranges.empty())
+      image.Append(compressed_ranges.data(), compressed_hdr.OffsetSize);
+
+    if (fOptions.fVerbose)
+      kConsoleOut << "compress: " << compressed_ranges.size() << " range(s), "
+                  << image.FileSize() << " of " << image.Size() << " byte(s) written.\n";
+  }
+
+  // step 5: checksum the image, the container is still zeroed, then emit it in one pass.
+
+  pef_container.Checksum = image.Checksum();
+
+  if (fOptions.fVerbose) kConsoleOut << "image checksum: " << pef_container.Checksum << "\n";
+
+  if (Int32 status = this->Emit(image, fOptions.fOutput, fImage); status != NECTI_SUCCESS)
+    return status;
+
+  if (fOptions.fSplitDebug) {
+    // an entry per run of an object's ranges laid out back to back, in image order. Folded ones
+    // point to the code of their target.
+    std::vector<CompilerKit::PEFDebugObject> debug_runs;
+    std::vector<SizeType>                    debug_owners;
+    std::vector<SizeType>                    debug_order;
+
+    for (SizeType object_index = 0UL; object_index < object_ranges.size(); ++object_index) {
+      if (ld_object_written(object_index) || folded_into[object_index] != folded_into.size())
+        debug_order.push_back(object_index);
+    }
+
+    std::stable_sort(debug_order.begin(), debug_order.end(), [&](SizeType lhs, SizeType rhs) {
+      return object_bases[lhs] < object_bases[rhs];
+    });
+
+    for (auto object_index : debug_order) {
+      auto owner = folded_into[object_index] != folded_into.size() ? folded_into[object_index]
+                                                                   : object_index;
+      auto input = fRanges[object_index].fObject;
+
+      if (!debug_runs.empty() && debug_owners.back() == input &&
+          debug_runs.back().Offset + debug_runs.back().Size == object_bases[object_index]) {
+        debug_runs.back().Size += object_sizes[owner];
+        continue;
+      }
+
+      debug_runs.push_back({.Offset  = object_bases[object_index],
+                            .Size    = object_sizes[owner],
+                            .Name    = 0U,
+                            .NameLen = UInt32(fObjectList[input].size())});
+      debug_owners.push_back(input);
+    }
+
+    std::vector<Char> debug_objects(debug_runs.size() * sizeof(CompilerKit::PEFDebugObject));
+
+    for (SizeType slot = 0UL; slot < debug_runs.size(); ++slot) {
+      auto& path = fObjectList[debug_owners[slot]];
+
+      debug_runs[slot].Name =
+          UInt32(debug_objects.size() - debug_runs.size() * sizeof(CompilerKit::PEFDebugObject));
+
+      std::memcpy(debug_objects.data() + slot * sizeof(CompilerKit::PEFDebugObject),
+                  &debug_runs[slot], sizeof(CompilerKit::PEFDebugObject));
+      debug_objects.insert(debug_objects.end(), path.begin(), path.end());
+    }
+
+    if (Int32 status = this->EmitDebug(pef_container, debug_headers, debug_objects);
+        status != NECTI_SUCCESS)
+      return status;
+  }
+
+  if (fOptions.fIncremental) {
+    link_state.fHeader.fOptions = this->OptionsHash();
+    link_state.fHeader.fStart   = pef_container.Start;
+    link_state.fSymbols         = symbol_table.Entries();
+    link_state.fHeaders         = std::move(image_headers);
+
+    if (!CompilerKit::Utils::link_state_save(CompilerKit::Utils::link_state_path(fOptions.fOutput),
+                                             link_state)) {
+      kConsoleOut << "couldn't write link state of: " << fOptions.fOutput << "\n";
+    }
+  }
+
+  if (fOptions.fVerbose && !fOptions.fOutput.empty()) {
+    kConsoleOut << "Wrote contents of: " << fOptions.fOutput << "\n";
+  }
+
+  // a dylib has no entrypoint to find, its exports are its way in.
+  if (((!fStartFound && fOptions.fExecutable) || fDuplicateSymbols) &&
+      (fOptions.fOutput.empty() || std::filesystem::exists(fOptions.fOutput))) {
+    if (fOptions.fVerbose) {
+      kConsoleOut << "File: " << fOptions.fOutput << " is corrupt now...\n";
+    }
+
+    return NECTI_EXEC_ERROR;
+  }
+
+  return NECTI_SUCCESS;
+}
+
+///	@brief NE 64-bit Linker, the ld64 command line.
+/// @note This linker is made for PEF executable, thus NE based OSes.
+NECTI_MODULE(DynamicLinker64PEF) {
+  CompilerKit::LinkerOptions options;
+
+  CompilerKit::install_signal(SIGSEGV, Detail::drvi_crash_handler);
+
+  /**
+   * @brief parse flags and trigger options.
+   */
+  for (size_t linker_arg = 1; linker_arg < argc; ++linker_arg) {
+    if (std::strcmp(argv[linker_arg], "-help") == 0) {
+      kLinkerSplash();
+
+      kConsoleOut << "-version: Show linker version.\n";
+      kConsoleOut << "-help: Show linker help.\n";
+      kConsoleOut << "-verbose: Enable linker trace.\n";
+      kConsoleOut << "-dylib: Output as a Dynamic PEF.\n";
+      kConsoleOut << "-fat: Link a slice per architecture of the objects, into one FAT PEF.\n";
+      kConsoleOut << "-32k: Output as a 32x0 PEF.\n";
+      kConsoleOut << "-64k: Output as a 64x0 PEF.\n";
+      kConsoleOut << "-amd64: Output as a AMD64 PEF.\n";
+      kConsoleOut << "-rv64: Output as a RISC-V PEF.\n";
+      kConsoleOut << "-power64: Output as a POWER PEF.\n";
+      kConsoleOut << "-arm64: Output as a ARM64 PEF.\n";
+      kConsoleOut << "-output: Select the output file name.\n";
+      kConsoleOut << "<name>.lib: Link the members of a static library that define an undefined "
+                     "symbol.\n";
+      kConsoleOut << "-j: Number of objects to read in parallel, 0 for one per core.\n";
+      kConsoleOut << "-incremental: Keep a link state next to the output, and patch it in place "
+                     "when relinking.\n";
+      kConsoleOut << "-incremental-slack: Slack reserved for each object, in percent.\n";
+      kConsoleOut << "-preallocate: Reserve the whole image on disk before writing it.\n";
+      kConsoleOut << "-stream: Copy the code from the inputs to the output as it's written, memory "
+                     "stays flat.\n";
+      kConsoleOut << "-page-align: Align segments to pages, so the image can be mapped in place.\n";
+      kConsoleOut << "-page-size: Page size of -page-align, 4096 by default.\n";
+      kConsoleOut << "-compress: Store the code and data LZ compressed, loaders expand them.\n";
+      kConsoleOut << "-split-debug: Write the symbol headers to a .dbg next to the output.\n";
+      kConsoleOut << "-reproducible: Same inputs, same image. Honors SOURCE_DATE_EPOCH.\n";
+      kConsoleOut << "-bind-now: Bind every runtime import at load time, instead of on first "
+                     "call.\n";
+      kConsoleOut << "-order-file: Lay out the listed code symbols first, in order.\n";
+      kConsoleOut << "-order-profile: -order-file from `symbol count` lines, hottest first.\n";
+      kConsoleOut << "-gc-sections: Drop the code that can't be reached from the entrypoint.\n";
+      kConsoleOut << "-icf: Fold identical functions, -icf-safe: Leave the ones whose address "
+                     "may be taken.\n";
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[linker_arg], "-version") == 0) {
+      kLinkerSplash();
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[linker_arg], "-fat") == 0) {
+      options.fFatBinary = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-64k") == 0) {
+      options.fArch = CompilerKit::kPefArch64000;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-amd64") == 0) {
+      options.fArch = CompilerKit::kPefArchAMD64;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-start") == 0) {
+      if (argv[linker_arg + 1] == nullptr || argv[linker_arg + 1][0] == '-') continue;
+
+      options.fStart = argv[linker_arg + 1];
+      linker_arg += 1;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-32k") == 0) {
+      options.fArch = CompilerKit::kPefArch32000;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-power64") == 0) {
+      options.fArch = CompilerKit::kPefArchPowerPC;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-riscv64") == 0) {
+      options.fArch = CompilerKit::kPefArchRISCV;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-arm64") == 0) {
+      options.fArch = CompilerKit::kPefArchARM64;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-verbose") == 0) {
+      options.fVerbose = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-dylib") == 0) {
+      if (options.fOutput.empty()) {
+        continue;
+      }
+
+      if (options.fOutput.find(kPefExt) != CompilerKit::STLString::npos)
+        options.fOutput.erase(options.fOutput.find(kPefExt), strlen(kPefExt));
+
+      options.fOutput += kPefDylibExt;
+
+      options.fExecutable = false;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-j") == 0) {
+      if (argv[linker_arg + 1] == nullptr || !std::isdigit(argv[linker_arg + 1][0])) {
+        kConsoleOut << "-j expects a job count.\n";
+        return EXIT_FAILURE;
+      }
+
+      options.fJobs = std::strtoul(argv[linker_arg + 1], nullptr, 10);
+      ++linker_arg;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-incremental") == 0) {
+      options.fIncremental = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-incremental-slack") == 0) {
+      if (argv[linker_arg + 1] == nullptr || !std::isdigit(argv[linker_arg + 1][0])) {
+        kConsoleOut << "-incremental-slack expects a percentage.\n";
+        return EXIT_FAILURE;
+      }
+
+      options.fIncrementalSlack = std::strtoul(argv[linker_arg + 1], nullptr, 10);
+      ++linker_arg;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-gc-sections") == 0 ||
+               std::strcmp(argv[linker_arg], "--gc-sections") == 0) {
+      options.fGCSections = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-icf") == 0) {
+      options.fICFMode = CompilerKit::kICFAll;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-icf-safe") == 0) {
+      options.fICFMode = CompilerKit::kICFSafe;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-preallocate") == 0) {
+      options.fPreallocate = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-stream") == 0) {
+      options.fStreaming = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-split-debug") == 0) {
+      options.fSplitDebug = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-compress") == 0) {
+      options.fCompress = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-page-align") == 0) {
+      if (!options.fPageSize) options.fPageSize = kPefPageSize;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-page-size") == 0) {
+      if (argv[linker_arg + 1] == nullptr || !std::isdigit(argv[linker_arg + 1][0])) {
+        kConsoleOut << "-page-size expects a size.\n";
+        return EXIT_FAILURE;
+      }
+
+      options.fPageSize = std::strtoul(argv[linker_arg + 1], nullptr, 10);
+      ++linker_arg;
+
+      if (options.fPageSize < 16 || (options.fPageSize & (options.fPageSize - 1)) != 0) {
+        kConsoleOut << "-page-size expects a power of two, 16 or more.\n";
+        return EXIT_FAILURE;
+      }
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-reproducible") == 0) {
+      options.fReproducible = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-bind-now") == 0) {
+      options.fBindNow = true;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-order-file") == 0 ||
+               std::strcmp(argv[linker_arg], "-order-profile") == 0) {
+      if (argv[linker_arg + 1] == nullptr) {
+        kConsoleOut << argv[linker_arg] << " expects a file.\n";
+        return EXIT_FAILURE;
+      }
+
+      if (CompilerKit::linker_read_order_file(argv[linker_arg + 1],
+                                              std::strcmp(argv[linker_arg], "-order-profile") == 0,
+                                              options.fOrderSymbols) != NECTI_SUCCESS)
+        return NECTI_EXEC_ERROR;
+
+      ++linker_arg;
+
+      continue;
+    } else if (std::strcmp(argv[linker_arg], "-output") == 0) {
+      if ((linker_arg + 1) > argc) continue;
+
+      options.fOutput = argv[linker_arg + 1];
+      ++linker_arg;
+
+      continue;
+    } else {
+      if (argv[linker_arg][0] == '-') {
+        kConsoleOut << "unknown flag: " << argv[linker_arg] << "\n";
+        return EXIT_FAILURE;
+      }
+
+      CompilerKit::STLString input = argv[linker_arg];
+
+      // static libraries are only searched, their members are linked when needed.
+      options.fInputs.push_back({.fPath = input, .fLibrary = input.ends_with(kPefLibExt)});
+
+      continue;
+    }
+  }
+
+  if (options.fOutput.empty()) {
+    kConsoleOut << "no output filename set." << std::endl;
+    return NECTI_EXEC_ERROR;
+  }
+
+  // build systems asking for reproducible builds set SOURCE_DATE_EPOCH.
+  if (std::getenv("SOURCE_DATE_EPOCH")) options.fReproducible = true;
+
+  CompilerKit::Linker linker(std::move(options));
+
+  return linker.Link();
+}
+
 // Last rev 13-1-24
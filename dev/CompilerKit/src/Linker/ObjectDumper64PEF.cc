@@ -0,0 +1,838 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal El Mahrouss, all rights reserved
+
+  @file ObjectDumper64PEF.cc
+  @brief: Object dumper, lists what AE objects, static libraries and PEF images hold.
+
+------------------------------------------- */
+
+/// @brief NeKernel.org object dumper.
+/// @note Inputs are mapped and only their tables are read, never their code, so dumping a
+/// multi-GB image costs what its headers weigh.
+
+#include <CompilerKit/AE.h>
+#include <CompilerKit/Archive.h>
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/PEF.h>
+#include <CompilerKit/Version.h>
+#include <CompilerKit/utils/CompilerUtils.h>
+#include <CompilerKit/utils/Compress.h>
+#include <CompilerKit/utils/MappedImage.h>
+#include <algorithm>
+#include <map>
+
+#define kDumperVersionStr                                                                  \
+  "NeKernel.org 64-Bit Object Dumper (Preferred Executable Format) %s, (c) Amlal El "      \
+  "Mahrouss, 2025 all rights reserved.\n"
+
+#define kDumperSplash() std::printf(kDumperVersionStr, kDistVersion)
+
+#define kConsoleOut        \
+  (std::cout << "\e[0;31m" \
+             << "dump64: " \
+             << "\e[0;97m")
+
+/// @brief What is printed of an input, everything by default.
+enum {
+  kDumpHeaders = 1 << 0,
+  kDumpSizes   = 1 << 1,
+  kDumpSymbols = 1 << 2,
+  kDumpAll     = kDumpHeaders | kDumpSizes | kDumpSymbols,
+};
+
+/// @brief Size classes, the PEF kinds and what has none of them.
+enum {
+  kDumpCode,
+  kDumpData,
+  kDumpZero,
+  kDumpOther,
+  kDumpClassCount,
+};
+
+static const Char* kDumpClassNames[kDumpClassCount] = {"code", "data", "zero", "other"};
+
+static const Char* kDumpArchNames[CompilerKit::kPefArchCount] = {
+    "x86", "amd64", "riscv", "64x0", "32x0", "power64", "arm64",
+};
+
+static Bool kDumpJson = false;
+
+/// @brief JSON is written in chunks of about this size.
+#define kDumpFlushSize (1UL << 20)
+
+/// @brief Record of an object or command header of an image, as dumped.
+struct DumpEntry final {
+  std::string_view fName;
+  UInt32           fKind{0U};
+  UInt32           fFlags{0U};
+  UInt32           fSection{kAENoSection}; /* AE objects only. */
+  SizeType         fOffset{0UL};
+  SizeType         fSize{0UL};
+  SizeType         fVirtualAddress{0UL}; /* PEF images only. */
+  SizeType         fVirtualSize{0UL};
+};
+
+/// @brief An input, or a member or slice of one.
+struct DumpInput final {
+  CompilerKit::STLString fName;
+  const Char*            fFormat{"ae"}; /* ae, lib or pef. */
+  const Char*            fKind{"object"};
+  const Char*            fArch{"unknown"};
+  UInt32                 fVersion{0U};
+  UInt32                 fChecksum{0U};
+  SizeType               fFileSize{0UL};
+  SizeType               fTableSize{0UL}; /* everything that isn't code or data. */
+  SizeType               fExpandedSize{0UL};
+  SizeType               fCompressedRanges{0UL};
+  SizeType               fRelocations{0UL};
+  SizeType               fSizes[kDumpClassCount]{};
+
+  std::vector<CompilerKit::AESection> fSections;
+  std::vector<DumpEntry>              fEntries;
+  std::vector<DumpInput>              fMembers; /* library members, or FAT slices. */
+};
+
+/// @brief Size class of a PEF kind.
+static SizeType dump_class(UInt32 kind) {
+  switch (kind) {
+    case CompilerKit::kPefCode:
+      return kDumpCode;
+    case CompilerKit::kPefData:
+      return kDumpData;
+    case CompilerKit::kPefZero:
+      return kDumpZero;
+    default:
+      return kDumpOther;
+  }
+}
+
+static const Char* dump_kind_name(UInt32 kind) {
+  switch (kind) {
+    case CompilerKit::kPefCode:
+      return "code";
+    case CompilerKit::kPefData:
+      return "data";
+    case CompilerKit::kPefZero:
+      return "zero";
+    case CompilerKit::kPefLinkerID:
+      return "linker";
+    case kAENullType:
+      return "none";
+    default:
+      return "other";
+  }
+}
+
+static const Char* dump_arch_name(UInt32 arch) {
+  return arch < CompilerKit::kPefArchCount ? kDumpArchNames[arch] : "unknown";
+}
+
+static const Char* dump_image_kind(UInt32 kind) {
+  switch (kind) {
+    case CompilerKit::kPefKindExec:
+      return "exec";
+    case CompilerKit::kPefKindDylib:
+      return "dylib";
+    case CompilerKit::kPefKindObject:
+      return "object";
+    case CompilerKit::kPefKindDebug:
+      return "debug";
+    case CompilerKit::kPefKindDriver:
+      return "driver";
+    default:
+      return "unknown";
+  }
+}
+
+/// @brief Whether a record or header defines a symbol, markers such as :UndefinedSymbol: or
+/// Container: only reference one or describe the image.
+static Bool dump_is_defined(const DumpEntry& entry) {
+  return !entry.fName.empty() && entry.fName.find(':') == std::string_view::npos &&
+         dump_class(entry.fKind) != kDumpOther;
+}
+
+static Bool dump_is_undefined(const DumpEntry& entry) {
+  return entry.fName.find(":UndefinedSymbol:") != std::string_view::npos ||
+         entry.fName.find(":RuntimeSymbol:") != std::string_view::npos;
+}
+
+/// @brief Read an AE object's tables.
+static Int32 dump_read_object(const CompilerKit::Utils::AEMappedObject& object,
+                              DumpInput&                                input) {
+  auto hdr = object.Header();
+
+  input.fFormat      = "ae";
+  input.fKind        = "object";
+  input.fArch        = dump_arch_name(UInt8(hdr->fArch));
+  input.fVersion     = hdr->fVersion;
+  input.fFileSize    = object.Size();
+  input.fRelocations = object.Relocations().size();
+
+  input.fSections.assign(object.Sections().begin(), object.Sections().end());
+  input.fEntries.reserve(object.Records().size());
+
+  for (auto record : object.Records()) {
+    DumpEntry entry{.fName    = record.fName,
+                    .fKind    = UInt32(record.fKind),
+                    .fFlags   = UInt32(record.fFlags),
+                    .fSection = record.fSection,
+                    .fOffset  = record.fOffset,
+                    .fSize    = record.fSize};
+
+    // records don't overlap, their sizes add up.
+    if (record.fKind != kAENullType) input.fSizes[dump_class(entry.fKind)] += entry.fSize;
+
+    input.fEntries.push_back(entry);
+  }
+
+  input.fTableSize = input.fFileSize - hdr->fCodeSize;
+
+  return NECTI_SUCCESS;
+}
+
+/// @brief Read a PEF image's tables, or a FAT container's slices.
+static Int32 dump_read_image(const CompilerKit::Utils::PEFMappedImage& image, DumpInput& input) {
+  auto container = image.Container();
+
+  input.fFormat   = "pef";
+  input.fVersion  = container->Version;
+  input.fChecksum = container->Checksum;
+  input.fFileSize = image.Size();
+
+  if (image.IsFat()) {
+    input.fKind = "fat";
+
+    for (auto& slice : image.Slices()) {
+      CompilerKit::Utils::PEFMappedImage slice_image;
+
+      if (slice_image.Open(image.SliceBytes(slice)) != NECTI_SUCCESS) return NECTI_INVALID_DATA;
+
+      DumpInput member;
+      member.fName = input.fName + "[" + dump_arch_name(slice.Cpu) + "]";
+
+      if (Int32 status = dump_read_image(slice_image, member); status != NECTI_SUCCESS)
+        return status;
+
+      for (SizeType index = 0UL; index < kDumpClassCount; ++index)
+        input.fSizes[index] += member.fSizes[index];
+
+      input.fMembers.push_back(std::move(member));
+    }
+
+    input.fTableSize = input.fFileSize - input.fSizes[kDumpCode] - input.fSizes[kDumpData];
+
+    return NECTI_SUCCESS;
+  }
+
+  input.fKind = dump_image_kind(container->Kind);
+  input.fArch = dump_arch_name(container->Cpu);
+
+  auto headers = image.Headers();
+
+  input.fEntries.reserve(headers.size());
+
+  // the headers of one object may nest or overlap, so a kind's size is the union of its ranges.
+  std::vector<std::pair<SizeType, SizeType>> ranges[kDumpClassCount];
+
+  for (auto& command_hdr : headers) {
+    DumpEntry entry{.fName           = {command_hdr.Name, strnlen(command_hdr.Name, kPefNameLen)},
+                    .fKind           = command_hdr.Kind,
+                    .fFlags          = command_hdr.Flags,
+                    .fOffset         = command_hdr.Offset,
+                    .fSize           = command_hdr.OffsetSize,
+                    .fVirtualAddress = command_hdr.VirtualAddress,
+                    .fVirtualSize    = command_hdr.VirtualSize};
+
+    // zero-fill takes no file bytes, it's sized by what it needs in memory.
+    SizeType size = (command_hdr.Flags & CompilerKit::kPefFlagZeroFill) ? command_hdr.VirtualSize
+                                                                         : command_hdr.OffsetSize;
+
+    // Container: headers and the like describe the image, they don't hold its contents.
+    if (size > 0 && entry.fName.find(':') == std::string_view::npos)
+      ranges[dump_class(entry.fKind)].emplace_back(entry.fOffset, entry.fOffset + size);
+
+    input.fEntries.push_back(entry);
+  }
+
+  for (SizeType index = 0UL; index < kDumpClassCount; ++index) {
+    std::sort(ranges[index].begin(), ranges[index].end());
+
+    SizeType covered = 0UL;
+
+    for (auto [start, end] : ranges[index]) {
+      covered = std::max(covered, start);
+
+      if (end > covered) {
+        input.fSizes[index] += end - covered;
+        covered = end;
+      }
+    }
+  }
+
+  // compressed ranges are read from their table, nothing is expanded.
+  auto compressed = CompilerKit::Utils::pef_compressed_ranges(image.Bytes());
+
+  input.fCompressedRanges = compressed.size();
+  input.fExpandedSize     = input.fFileSize;
+
+  for (auto& range : compressed) input.fExpandedSize += range.Size - range.FileSize;
+
+  SizeType contents = input.fSizes[kDumpCode] + input.fSizes[kDumpData];
+
+  input.fTableSize = contents < input.fExpandedSize ? input.fExpandedSize - contents : 0UL;
+
+  return NECTI_SUCCESS;
+}
+
+/// @brief Read a static library, each member as an object.
+static Int32 dump_read_archive(const CompilerKit::Utils::LibMappedArchive& archive,
+                               SizeType file_size, DumpInput& input) {
+  input.fFormat   = "lib";
+  input.fKind     = "library";
+  input.fVersion  = archive.Header()->fVersion;
+  input.fFileSize = file_size;
+
+  SizeType contents = 0UL;
+
+  for (UInt32 member_index = 0U; member_index < archive.Members().size(); ++member_index) {
+    CompilerKit::Utils::AEMappedObject object;
+
+    if (object.Open(archive.MemberBytes(member_index)) != NECTI_SUCCESS)
+      return NECTI_INVALID_DATA;
+
+    DumpInput member;
+    member.fName = input.fName + "(" + CompilerKit::STLString(archive.MemberName(member_index)) +
+                   ")";
+
+    dump_read_object(object, member);
+
+    for (SizeType index = 0UL; index < kDumpClassCount; ++index)
+      input.fSizes[index] += member.fSizes[index];
+
+    contents += member.fFileSize - member.fTableSize;
+
+    input.fMembers.push_back(std::move(member));
+  }
+
+  input.fTableSize = input.fFileSize - contents;
+
+  return NECTI_SUCCESS;
+}
+
+/// @brief Map an input, whatever its format, and read its tables.
+/// @note Objects and libraries only hand out views, so their maps are kept by the caller.
+static Int32 dump_read(const CompilerKit::STLString& path, DumpInput& input,
+                       std::vector<CompilerKit::Utils::AEMappedObject>&   objects,
+                       std::vector<CompilerKit::Utils::LibMappedArchive>& archives,
+                       std::vector<CompilerKit::Utils::PEFMappedImage>&   images) {
+  Char          magic[4]{};
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file) {
+    kConsoleOut << "no such file: " << path << "\n";
+    return NECTI_FILE_NOT_FOUND;
+  }
+
+  file.read(magic, sizeof(magic));
+
+  input.fName = path;
+
+  Int32 status = NECTI_INVALID_DATA;
+
+  if (magic[0] == kAEMag0 && magic[1] == kAEMag1) {
+    if (objects.emplace_back().Open(path.c_str()) == NECTI_SUCCESS)
+      status = dump_read_object(objects.back(), input);
+  } else if (std::memcmp(magic, kLibMagic, kLibMagicLen) == 0) {
+    if (archives.emplace_back().Open(path.c_str()) == NECTI_SUCCESS)
+      status = dump_read_archive(archives.back(), std::filesystem::file_size(path), input);
+  } else if (images.emplace_back().Open(path.c_str()) == NECTI_SUCCESS) {
+    status = dump_read_image(images.back(), input);
+  }
+
+  if (status != NECTI_SUCCESS) kConsoleOut << "not an object, library or image: " << path << "\n";
+
+  return status;
+}
+
+/// @brief Write what JSON is pending once there's enough of it, so large images stream out.
+static void dump_json_flush(CompilerKit::STLString& out, Bool force = false) {
+  if (!force && out.size() < kDumpFlushSize) return;
+
+  std::fwrite(out.data(), 1, out.size(), stdout);
+  out.clear();
+}
+
+/// @brief Append a JSON string, escaped.
+static void dump_json_string(CompilerKit::STLString& out, std::string_view text) {
+  out += '"';
+
+  for (auto ch : text) {
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+      out += ch;
+    } else if (UInt8(ch) < 0x20) {
+      Char escape[8];
+      std::snprintf(escape, sizeof(escape), "\\u%04x", UInt8(ch));
+      out += escape;
+    } else {
+      out += ch;
+    }
+  }
+
+  out += '"';
+}
+
+static void dump_json_field(CompilerKit::STLString& out, const Char* key, SizeType value) {
+  out += '"';
+  out += key;
+  out += "\":";
+  out += std::to_string(value);
+}
+
+static void dump_json_field(CompilerKit::STLString& out, const Char* key, std::string_view value) {
+  out += '"';
+  out += key;
+  out += "\":";
+  dump_json_string(out, value);
+}
+
+static void dump_json_sizes(CompilerKit::STLString& out, const DumpInput& input) {
+  out += "\"sizes\":{";
+
+  for (SizeType index = 0UL; index < kDumpClassCount; ++index) {
+    dump_json_field(out, kDumpClassNames[index], input.fSizes[index]);
+    out += ',';
+  }
+
+  dump_json_field(out, "tables", input.fTableSize);
+  out += ',';
+  dump_json_field(out, "file", input.fFileSize);
+
+  if (input.fCompressedRanges > 0) {
+    out += ',';
+    dump_json_field(out, "expanded", input.fExpandedSize);
+  }
+
+  out += '}';
+}
+
+/// @brief Write an input as JSON, its members nested in it.
+static void dump_json(CompilerKit::STLString& out, const DumpInput& input, Int32 parts) {
+  out += '{';
+  dump_json_field(out, "name", input.fName);
+  out += ',';
+  dump_json_field(out, "format", input.fFormat);
+  out += ',';
+  dump_json_field(out, "kind", input.fKind);
+  out += ',';
+  dump_json_field(out, "arch", input.fArch);
+  out += ',';
+  dump_json_field(out, "version", input.fVersion);
+
+  if (input.fFormat == std::string_view("pef")) {
+    out += ',';
+    dump_json_field(out, "checksum", input.fChecksum);
+    out += ',';
+    dump_json_field(out, "compressed_ranges", input.fCompressedRanges);
+  } else if (input.fFormat == std::string_view("ae")) {
+    out += ',';
+    dump_json_field(out, "relocations", input.fRelocations);
+  }
+
+  if (parts & kDumpSizes) {
+    out += ',';
+    dump_json_sizes(out, input);
+  }
+
+  if ((parts & kDumpHeaders) && !input.fSections.empty()) {
+    out += ",\"sections\":[";
+
+    for (SizeType index = 0UL; index < input.fSections.size(); ++index) {
+      auto& section = input.fSections[index];
+
+      if (index > 0) out += ',';
+
+      out += '{';
+      dump_json_field(out, "kind", dump_kind_name(section.fKind));
+      out += ',';
+      dump_json_field(out, "offset", section.fOffset);
+      out += ',';
+      dump_json_field(out, "size", section.fSize);
+      out += '}';
+    }
+
+    out += ']';
+  }
+
+  if (parts & kDumpHeaders) {
+    Bool image = input.fFormat == std::string_view("pef");
+
+    out += image ? ",\"headers\":[" : ",\"records\":[";
+
+    for (SizeType index = 0UL; index < input.fEntries.size(); ++index) {
+      auto& entry = input.fEntries[index];
+
+      if (index > 0) out += ',';
+
+      out += '{';
+      dump_json_field(out, "name", entry.fName);
+      out += ',';
+      dump_json_field(out, "kind", dump_kind_name(entry.fKind));
+      out += ',';
+      dump_json_field(out, "flags", entry.fFlags);
+      out += ',';
+      dump_json_field(out, "offset", entry.fOffset);
+      out += ',';
+      dump_json_field(out, "size", entry.fSize);
+
+      dump_json_flush(out);
+
+      if (image) {
+        out += ',';
+        dump_json_field(out, "vaddr", entry.fVirtualAddress);
+        out += ',';
+        dump_json_field(out, "vsize", entry.fVirtualSize);
+      } else if (entry.fSection != kAENoSection) {
+        out += ',';
+        dump_json_field(out, "section", entry.fSection);
+      }
+
+      out += '}';
+    }
+
+    out += ']';
+  }
+
+  if (parts & kDumpSymbols) {
+    out += ",\"defined\":[";
+
+    Bool first = true;
+
+    for (auto& entry : input.fEntries) {
+      if (!dump_is_defined(entry)) continue;
+
+      if (!first) out += ',';
+
+      first = false;
+
+      out += '{';
+      dump_json_field(out, "name", entry.fName);
+      out += ',';
+      dump_json_field(out, "size", entry.fSize);
+      out += '}';
+
+      dump_json_flush(out);
+    }
+
+    out += "],\"undefined\":[";
+
+    first = true;
+
+    for (auto& entry : input.fEntries) {
+      if (!dump_is_undefined(entry)) continue;
+
+      if (!first) out += ',';
+
+      first = false;
+
+      dump_json_string(out, entry.fName);
+    }
+
+    out += ']';
+  }
+
+  if (!input.fMembers.empty()) {
+    out += ",\"members\":[";
+
+    for (SizeType index = 0UL; index < input.fMembers.size(); ++index) {
+      if (index > 0) out += ',';
+
+      dump_json(out, input.fMembers[index], parts);
+    }
+
+    out += ']';
+  }
+
+  out += '}';
+}
+
+/// @brief Print an input, then its members.
+static void dump_text(const DumpInput& input, Int32 parts) {
+  std::printf("%s: %s %s, version %#x, %s", input.fName.c_str(), input.fFormat, input.fKind,
+              input.fVersion, input.fArch);
+
+  if (input.fFormat == std::string_view("ae"))
+    std::printf(", %zu record(s), %zu section(s), %zu relocation(s)\n", input.fEntries.size(),
+                input.fSections.size(), (size_t) input.fRelocations);
+  else if (input.fFormat == std::string_view("pef") && input.fMembers.empty())
+    std::printf(", %zu header(s), checksum 0x%08x\n", input.fEntries.size(), input.fChecksum);
+  else
+    std::printf(", %zu member(s)\n", input.fMembers.size());
+
+  if ((parts & kDumpHeaders) && !input.fSections.empty()) {
+    std::printf("  sections:\n");
+
+    for (SizeType index = 0UL; index < input.fSections.size(); ++index) {
+      auto& section = input.fSections[index];
+
+      std::printf("    %4zu %-6s offset %10llu size %10llu\n", (size_t) index,
+                  dump_kind_name(section.fKind), (unsigned long long) section.fOffset,
+                  (unsigned long long) section.fSize);
+    }
+  }
+
+  if ((parts & kDumpHeaders) && !input.fEntries.empty()) {
+    Bool image = input.fFormat == std::string_view("pef");
+
+    std::printf(image ? "  headers:\n" : "  records:\n");
+
+    for (auto& entry : input.fEntries) {
+      Char section[16] = "-";
+
+      if (entry.fSection != kAENoSection)
+        std::snprintf(section, sizeof(section), "%u", entry.fSection);
+
+      if (image)
+        std::printf("    %-6s 0x%04x %10llu %10llu %#14llx %10llu %.*s\n",
+                    dump_kind_name(entry.fKind), entry.fFlags, (unsigned long long) entry.fOffset,
+                    (unsigned long long) entry.fSize, (unsigned long long) entry.fVirtualAddress,
+                    (unsigned long long) entry.fVirtualSize, (int) entry.fName.size(),
+                    entry.fName.data());
+      else
+        std::printf("    %-6s 0x%04x %4s %10llu %10llu %.*s\n", dump_kind_name(entry.fKind),
+                    entry.fFlags, section, (unsigned long long) entry.fOffset,
+                    (unsigned long long) entry.fSize, (int) entry.fName.size(),
+                    entry.fName.data());
+    }
+  }
+
+  if (parts & kDumpSizes) {
+    std::printf("  sizes:\n");
+
+    for (SizeType index = 0UL; index < kDumpClassCount; ++index)
+      std::printf("    %-8s %12llu\n", kDumpClassNames[index],
+                  (unsigned long long) input.fSizes[index]);
+
+    std::printf("    %-8s %12llu\n", "tables", (unsigned long long) input.fTableSize);
+    std::printf("    %-8s %12llu\n", "file", (unsigned long long) input.fFileSize);
+
+    if (input.fCompressedRanges > 0)
+      std::printf("    %-8s %12llu, %zu compressed range(s)\n", "expanded",
+                  (unsigned long long) input.fExpandedSize, (size_t) input.fCompressedRanges);
+  }
+
+  if ((parts & kDumpSymbols) && !input.fEntries.empty()) {
+    std::printf("  symbols:\n");
+
+    for (auto& entry : input.fEntries) {
+      if (dump_is_defined(entry))
+        std::printf("    D %10llu %.*s\n", (unsigned long long) entry.fSize,
+                    (int) entry.fName.size(), entry.fName.data());
+      else if (dump_is_undefined(entry))
+        std::printf("    U %10s %.*s\n", "", (int) entry.fName.size(), entry.fName.data());
+    }
+  }
+
+  for (auto& member : input.fMembers) dump_text(member, parts);
+}
+
+/// @brief Defined symbols of an input and its members, by name.
+static void dump_symbols(const DumpInput& input, std::map<std::string_view, SizeType>& symbols) {
+  for (auto& entry : input.fEntries) {
+    if (dump_is_defined(entry)) symbols[entry.fName] += entry.fSize;
+  }
+
+  for (auto& member : input.fMembers) dump_symbols(member, symbols);
+}
+
+/// @brief Compare two inputs by size class, then by symbol.
+static Int32 dump_diff(const DumpInput& lhs, const DumpInput& rhs) {
+  struct DumpRow final {
+    const Char* fName;
+    SizeType    fLhs;
+    SizeType    fRhs;
+  };
+
+  std::vector<DumpRow> rows;
+
+  for (SizeType index = 0UL; index < kDumpClassCount; ++index)
+    rows.push_back({kDumpClassNames[index], lhs.fSizes[index], rhs.fSizes[index]});
+
+  rows.push_back({"tables", lhs.fTableSize, rhs.fTableSize});
+  rows.push_back({"file", lhs.fFileSize, rhs.fFileSize});
+
+  std::map<std::string_view, SizeType> lhs_symbols, rhs_symbols;
+
+  dump_symbols(lhs, lhs_symbols);
+  dump_symbols(rhs, rhs_symbols);
+
+  // symbols only one side has, and the ones whose size changed.
+  std::vector<std::pair<std::string_view, Int64>> changes;
+
+  for (auto& [name, size] : lhs_symbols) {
+    auto other = rhs_symbols.find(name);
+
+    if (other == rhs_symbols.end())
+      changes.emplace_back(name, -Int64(size));
+    else if (other->second != size)
+      changes.emplace_back(name, Int64(other->second) - Int64(size));
+  }
+
+  for (auto& [name, size] : rhs_symbols) {
+    if (!lhs_symbols.contains(name)) changes.emplace_back(name, Int64(size));
+  }
+
+  auto dump_change = [&](std::string_view name) {
+    if (!rhs_symbols.contains(name)) return "removed";
+    if (!lhs_symbols.contains(name)) return "added";
+
+    return "resized";
+  };
+
+  if (kDumpJson) {
+    CompilerKit::STLString out = "{";
+
+    dump_json_field(out, "old", lhs.fName);
+    out += ',';
+    dump_json_field(out, "new", rhs.fName);
+    out += ",\"sizes\":{";
+
+    for (SizeType index = 0UL; index < rows.size(); ++index) {
+      if (index > 0) out += ',';
+
+      out += '"';
+      out += rows[index].fName;
+      out += "\":{";
+      dump_json_field(out, "old", rows[index].fLhs);
+      out += ',';
+      dump_json_field(out, "new", rows[index].fRhs);
+      out += ",\"delta\":";
+      out += std::to_string(Int64(rows[index].fRhs) - Int64(rows[index].fLhs));
+      out += '}';
+    }
+
+    out += "},\"symbols\":[";
+
+    for (SizeType index = 0UL; index < changes.size(); ++index) {
+      if (index > 0) out += ',';
+
+      out += '{';
+      dump_json_field(out, "name", changes[index].first);
+      out += ',';
+      dump_json_field(out, "status", dump_change(changes[index].first));
+      out += ",\"delta\":";
+      out += std::to_string(changes[index].second);
+      out += '}';
+    }
+
+    out += "]}\n";
+
+    dump_json_flush(out, true);
+
+    return NECTI_SUCCESS;
+  }
+
+  std::printf("%-10s %12s %12s %12s\n", "", "old", "new", "delta");
+
+  for (auto& row : rows)
+    std::printf("%-10s %12llu %12llu %+12lld\n", row.fName, (unsigned long long) row.fLhs,
+                (unsigned long long) row.fRhs, (long long) (Int64(row.fRhs) - Int64(row.fLhs)));
+
+  for (auto& [name, delta] : changes)
+    std::printf("  %-8s %+10lld %.*s\n", dump_change(name), (long long) delta, (int) name.size(),
+                name.data());
+
+  return NECTI_SUCCESS;
+}
+
+///	@brief NE 64-bit object dumper.
+NECTI_MODULE(ObjectDumper64PEF) {
+  std::vector<CompilerKit::STLString> inputs;
+  Int32                               parts = 0;
+  Bool                                diff  = false;
+
+  for (Int32 arg = 1; arg < argc; ++arg) {
+    if (std::strcmp(argv[arg], "-help") == 0) {
+      kDumperSplash();
+
+      kConsoleOut << "-version: Show dumper version.\n";
+      kConsoleOut << "-help: Show dumper help.\n";
+      kConsoleOut << "-headers: List the records, sections or command headers.\n";
+      kConsoleOut << "-sizes: Print the size of code, data, zero-fill and tables.\n";
+      kConsoleOut << "-symbols: List the defined and undefined symbols.\n";
+      kConsoleOut << "-diff: Compare two inputs by size class and by symbol.\n";
+      kConsoleOut << "-json: Print JSON instead of text.\n";
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[arg], "-version") == 0) {
+      kDumperSplash();
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[arg], "-headers") == 0) {
+      parts |= kDumpHeaders;
+    } else if (std::strcmp(argv[arg], "-sizes") == 0) {
+      parts |= kDumpSizes;
+    } else if (std::strcmp(argv[arg], "-symbols") == 0) {
+      parts |= kDumpSymbols;
+    } else if (std::strcmp(argv[arg], "-diff") == 0) {
+      diff = true;
+    } else if (std::strcmp(argv[arg], "-json") == 0) {
+      kDumpJson = true;
+    } else if (argv[arg][0] == '-') {
+      kConsoleOut << "unknown flag: " << argv[arg] << "\n";
+      return NECTI_EXEC_ERROR;
+    } else {
+      inputs.emplace_back(argv[arg]);
+    }
+  }
+
+  if (inputs.empty() || (diff && inputs.size() != 2)) {
+    kConsoleOut << (diff ? "-diff expects two inputs.\n" : "no input set.\n");
+    return NECTI_EXEC_ERROR;
+  }
+
+  if (parts == 0) parts = kDumpAll;
+
+  // large images have many headers, print them in big writes.
+  static Char kDumpBuffer[1 << 16];
+  std::setvbuf(stdout, kDumpBuffer, _IOFBF, sizeof(kDumpBuffer));
+
+  std::vector<CompilerKit::Utils::AEMappedObject>   objects;
+  std::vector<CompilerKit::Utils::LibMappedArchive> archives;
+  std::vector<CompilerKit::Utils::PEFMappedImage>   images;
+  std::vector<DumpInput>                            dumps(inputs.size());
+
+  objects.reserve(inputs.size());
+  archives.reserve(inputs.size());
+  images.reserve(inputs.size());
+
+  for (SizeType index = 0UL; index < inputs.size(); ++index) {
+    if (Int32 status = dump_read(inputs[index], dumps[index], objects, archives, images);
+        status != NECTI_SUCCESS)
+      return status;
+  }
+
+  if (diff) return dump_diff(dumps[0], dumps[1]);
+
+  if (!kDumpJson) {
+    for (auto& dump : dumps) dump_text(dump, parts);
+
+    return NECTI_SUCCESS;
+  }
+
+  CompilerKit::STLString out = "[";
+
+  for (SizeType index = 0UL; index < dumps.size(); ++index) {
+    if (index > 0) out += ',';
+
+    dump_json(out, dumps[index], parts);
+  }
+
+  out += "]\n";
+
+  dump_json_flush(out, true);
+
+  return NECTI_SUCCESS;
+}
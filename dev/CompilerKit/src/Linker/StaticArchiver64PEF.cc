@@ -0,0 +1,280 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal El Mahrouss, all rights reserved
+
+  @file StaticArchiver64PEF.cc
+  @brief: Static library archiver, bundles AE objects for ld64.
+
+------------------------------------------- */
+
+/// @brief NeKernel.org static library archiver.
+/// @note Only the records an object defines go into the symbol directory, ld64 pulls a member in
+/// when one of them is still undefined.
+
+#include <CompilerKit/AE.h>
+#include <CompilerKit/Archive.h>
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/Version.h>
+#include <CompilerKit/utils/CompilerUtils.h>
+#include <CompilerKit/utils/SymbolTable.h>
+
+#define kArchiverVersionStr                                                                \
+  "NeKernel.org 64-Bit Archiver (Preferred Executable Format) %s, (c) Amlal El Mahrouss, " \
+  "2025 all rights reserved.\n"
+
+#define kArchiverSplash() std::printf(kArchiverVersionStr, kDistVersion)
+
+#define kConsoleOut        \
+  (std::cout << "\e[0;31m" \
+             << "ar64: "   \
+             << "\e[0;97m")
+
+/// @brief Object queued for the archive.
+struct ArchiverMember final {
+  CompilerKit::STLString             fName;
+  CompilerKit::Utils::AEMappedObject fMap;
+  UInt64                             fHash{0UL};
+};
+
+/// @brief Symbols an AE object defines, by demangled name.
+/// @note Records carrying a `:` marker, such as :UndefinedSymbol:, only reference a symbol.
+static std::vector<CompilerKit::STLString> ar_defined_symbols(
+    const CompilerKit::Utils::AEMappedObject& object) {
+  std::vector<CompilerKit::STLString> symbols;
+
+  for (auto record : object.Records()) {
+    auto name = record.fName;
+
+    if (name.empty() || name.find(':') != std::string_view::npos) continue;
+
+    symbols.push_back(CompilerKit::symbol_demangle(name));
+  }
+
+  return symbols;
+}
+
+/// @brief Write a static library, members are laid out in input order.
+static Int32 ar_write_archive(const CompilerKit::STLString&     path,
+                              const std::vector<ArchiverMember>& members) {
+  CompilerKit::SymbolTable            symbol_table;
+  std::vector<CompilerKit::LibMember> member_table(members.size());
+  CompilerKit::STLString              strings;
+
+  for (UInt32 member_index = 0U; member_index < members.size(); ++member_index) {
+    auto& member = members[member_index];
+
+    member_table[member_index].fHash    = member.fHash;
+    member_table[member_index].fSize    = member.fMap.Size();
+    member_table[member_index].fName    = strings.size();
+    member_table[member_index].fNameLen = member.fName.size();
+
+    strings += member.fName;
+
+    for (auto& symbol : ar_defined_symbols(member.fMap)) {
+      auto  id    = symbol_table.Intern(symbol);
+      auto& entry = symbol_table[id];
+
+      if (entry.fDefCount > 0 && entry.fDefinition != Int64(member_index)) {
+        kConsoleOut << "multiple symbols of: " << symbol << " in " << member.fName << " and "
+                    << members[entry.fDefinition].fName << ", cannot continue.\n";
+
+        return NECTI_EXEC_ERROR;
+      }
+
+      entry.fDefinition = member_index;
+      ++entry.fDefCount;
+    }
+  }
+
+  SizeType slot_count = kSymbolTableMinSlots;
+
+  while ((symbol_table.Count() + 1) * kSymbolTableLoadDen >= slot_count * kSymbolTableLoadNum)
+    slot_count *= 2;
+
+  CompilerKit::LibSymbol empty_slot{};
+  empty_slot.fMember = kLibNoMember;
+
+  std::vector<CompilerKit::LibSymbol> slots(slot_count, empty_slot);
+
+  for (auto& entry : symbol_table.Entries()) {
+    SizeType slot = entry.fHash & (slot_count - 1);
+
+    while (slots[slot].fMember != kLibNoMember) slot = (slot + 1) & (slot_count - 1);
+
+    slots[slot].fHash    = entry.fHash;
+    slots[slot].fName    = strings.size();
+    slots[slot].fNameLen = entry.fName.size();
+    slots[slot].fMember  = entry.fDefinition;
+
+    strings += entry.fName;
+  }
+
+  CompilerKit::LibHeader header{};
+
+  std::memcpy(header.fMagic, kLibMagic, kLibMagicLen);
+
+  header.fVersion     = kLibVersion;
+  header.fMemberCount = members.size();
+  header.fSlotCount   = slot_count;
+  header.fSlots       = sizeof(CompilerKit::LibHeader);
+  header.fMembers     = header.fSlots + slot_count * sizeof(CompilerKit::LibSymbol);
+  header.fStrings     = header.fMembers + members.size() * sizeof(CompilerKit::LibMember);
+  header.fStringSize  = strings.size();
+
+  auto ar_align = [](SizeType offset) {
+    return (offset + kLibAlign - 1) & ~SizeType(kLibAlign - 1);
+  };
+
+  SizeType offset = ar_align(header.fStrings + header.fStringSize);
+
+  for (auto& member : member_table) {
+    member.fOffset = offset;
+    offset         = ar_align(offset + member.fSize);
+  }
+
+  std::ofstream out(path, std::ofstream::binary | std::ofstream::trunc);
+
+  if (!out) {
+    kConsoleOut << "can't open: " << path << "\n";
+    return NECTI_FILE_NOT_FOUND;
+  }
+
+  out.write((Char*) &header, sizeof(CompilerKit::LibHeader));
+  out.write((Char*) slots.data(), slots.size() * sizeof(CompilerKit::LibSymbol));
+  out.write((Char*) member_table.data(), member_table.size() * sizeof(CompilerKit::LibMember));
+  out.write(strings.data(), strings.size());
+
+  for (SizeType member_index = 0UL; member_index < members.size(); ++member_index) {
+    static const Char kPadding[kLibAlign] = {0};
+
+    out.write(kPadding, member_table[member_index].fOffset - SizeType(out.tellp()));
+
+    auto bytes = members[member_index].fMap.Bytes();
+    out.write(bytes.data(), bytes.size());
+  }
+
+  if (kVerbose)
+    kConsoleOut << "wrote " << members.size() << " member(s), " << symbol_table.Count()
+                << " symbol(s) to: " << path << "\n";
+
+  return out.good() ? NECTI_SUCCESS : NECTI_EXEC_ERROR;
+}
+
+/// @brief List the members of a library, and the symbols they define.
+static Int32 ar_list_archive(const CompilerKit::STLString& path) {
+  CompilerKit::Utils::LibMappedArchive archive;
+
+  if (archive.Open(path.c_str()) != NECTI_SUCCESS) {
+    kConsoleOut << "not a static library: " << path << "\n";
+    return NECTI_INVALID_DATA;
+  }
+
+  auto members = archive.Members();
+
+  for (UInt32 member_index = 0U; member_index < members.size(); ++member_index) {
+    std::printf("%016llx %8llu %.*s\n", (unsigned long long) members[member_index].fHash,
+                (unsigned long long) members[member_index].fSize,
+                (int) archive.MemberName(member_index).size(),
+                archive.MemberName(member_index).data());
+  }
+
+  if (!kVerbose) return NECTI_SUCCESS;
+
+  for (auto& slot : archive.Symbols()) {
+    if (slot.fMember == kLibNoMember) continue;
+
+    auto symbol = archive.SymbolName(slot);
+    auto member = archive.MemberName(slot.fMember);
+
+    std::printf("  %.*s: %.*s\n", (int) symbol.size(), symbol.data(), (int) member.size(),
+                member.data());
+  }
+
+  return NECTI_SUCCESS;
+}
+
+///	@brief NE 64-bit static library archiver.
+NECTI_MODULE(StaticArchiver64PEF) {
+  CompilerKit::STLString              output;
+  CompilerKit::STLString              list;
+  std::vector<CompilerKit::STLString> inputs;
+
+  for (Int32 arg = 1; arg < argc; ++arg) {
+    if (std::strcmp(argv[arg], "-help") == 0) {
+      kArchiverSplash();
+
+      kConsoleOut << "-version: Show archiver version.\n";
+      kConsoleOut << "-help: Show archiver help.\n";
+      kConsoleOut << "-verbose: Enable archiver trace.\n";
+      kConsoleOut << "-output: Select the library to write, followed by its objects.\n";
+      kConsoleOut << "-list: List the members of a library.\n";
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[arg], "-version") == 0) {
+      kArchiverSplash();
+
+      return NECTI_SUCCESS;
+    } else if (std::strcmp(argv[arg], "-verbose") == 0) {
+      kVerbose = true;
+    } else if (std::strcmp(argv[arg], "-output") == 0 || std::strcmp(argv[arg], "-list") == 0) {
+      if (argv[arg + 1] == nullptr) {
+        kConsoleOut << argv[arg] << " expects a library.\n";
+        return NECTI_EXEC_ERROR;
+      }
+
+      (argv[arg][1] == 'o' ? output : list) = argv[arg + 1];
+      ++arg;
+    } else if (argv[arg][0] == '-') {
+      kConsoleOut << "unknown flag: " << argv[arg] << "\n";
+      return NECTI_EXEC_ERROR;
+    } else {
+      inputs.emplace_back(argv[arg]);
+    }
+  }
+
+  if (!list.empty()) return ar_list_archive(list);
+
+  if (output.empty()) {
+    kConsoleOut << "no output library set.\n";
+    return NECTI_EXEC_ERROR;
+  }
+
+  std::vector<ArchiverMember> members;
+
+  for (auto& input : inputs) {
+    ArchiverMember member;
+
+    if (member.fMap.Open(input.c_str()) != NECTI_SUCCESS) {
+      kConsoleOut << "not an object container: " << input << "\n";
+      return NECTI_EXEC_ERROR;
+    }
+
+    auto bytes = member.fMap.Bytes();
+
+    member.fName = std::filesystem::path(input).filename().string();
+    member.fHash = CompilerKit::symbol_hash({bytes.data(), bytes.size()});
+
+    // content addressed, the same object is only stored once.
+    Bool stored = false;
+
+    for (auto& other : members) {
+      auto other_bytes = other.fMap.Bytes();
+
+      if (other.fHash == member.fHash && other_bytes.size() == bytes.size() &&
+          std::memcmp(other_bytes.data(), bytes.data(), bytes.size()) == 0) {
+        stored = true;
+        break;
+      }
+    }
+
+    if (stored) {
+      if (kVerbose) kConsoleOut << "already stored: " << input << "\n";
+      continue;
+    }
+
+    members.push_back(std::move(member));
+  }
+
+  return ar_write_archive(output, members);
+}
@@ -0,0 +1,161 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/PEF.h>
+#include <span>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/// @file Checksum.h
+/// @brief CRC32C (Castagnoli), and the PEF whole-image checksum built on it.
+
+/// @brief Reflected CRC32C polynomial.
+#define kCRC32CPoly (0x82F63B78U)
+
+namespace CompilerKit::Utils {
+namespace Detail {
+/// @brief Slicing-by-8 tables, fTable[0] is the classic byte table.
+struct CRC32CTable final {
+  UInt32 fTable[8][256]{};
+
+  constexpr CRC32CTable() {
+    for (UInt32 byte = 0; byte < 256; ++byte) {
+      UInt32 crc = byte;
+
+      for (Int32 bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (kCRC32CPoly & (0U - (crc & 1)));
+
+      fTable[0][byte] = crc;
+    }
+
+    for (UInt32 byte = 0; byte < 256; ++byte) {
+      for (Int32 slice = 1; slice < 8; ++slice)
+        fTable[slice][byte] =
+            (fTable[slice - 1][byte] >> 8) ^ fTable[0][fTable[slice - 1][byte] & 0xFF];
+    }
+  }
+};
+
+inline constexpr CRC32CTable kCRC32CTable{};
+
+/// @brief Portable kernel, eight bytes per step.
+inline UInt32 crc32c_portable(UInt32 crc, const UInt8* data, SizeType size) noexcept {
+  auto& table = kCRC32CTable.fTable;
+
+  for (; size >= 8; data += 8, size -= 8) {
+    UInt32 low  = crc ^ (UInt32(data[0]) | UInt32(data[1]) << 8 | UInt32(data[2]) << 16 |
+                        UInt32(data[3]) << 24);
+    UInt32 high = UInt32(data[4]) | UInt32(data[5]) << 8 | UInt32(data[6]) << 16 |
+                  UInt32(data[7]) << 24;
+
+    crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^
+          table[4][low >> 24] ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+          table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+  }
+
+  for (; size > 0; ++data, --size) crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+
+  return crc;
+}
+
+#if defined(__x86_64__)
+/// @brief SSE4.2 kernel, the crc32 instruction eats eight bytes per step.
+__attribute__((target("sse4.2"))) inline UInt32 crc32c_hardware(UInt32 crc, const UInt8* data,
+                                                                SizeType size) noexcept {
+  UInt64 crc64 = crc;
+
+  for (; size >= 8; data += 8, size -= 8) {
+    UInt64 word;
+    std::memcpy(&word, data, sizeof(UInt64));
+
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+
+  crc = UInt32(crc64);
+
+  for (; size > 0; ++data, --size) crc = _mm_crc32_u8(crc, *data);
+
+  return crc;
+}
+
+inline Bool crc32c_has_hardware() noexcept {
+  static const Bool kHasSSE42 = __builtin_cpu_supports("sse4.2");
+  return kHasSSE42;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/// @brief ARMv8 CRC kernel.
+inline UInt32 crc32c_hardware(UInt32 crc, const UInt8* data, SizeType size) noexcept {
+  for (; size >= 8; data += 8, size -= 8) {
+    UInt64 word;
+    std::memcpy(&word, data, sizeof(UInt64));
+
+    crc = __crc32cd(crc, word);
+  }
+
+  for (; size > 0; ++data, --size) crc = __crc32cb(crc, *data);
+
+  return crc;
+}
+
+inline Bool crc32c_has_hardware() noexcept {
+  return true;
+}
+#else
+inline UInt32 crc32c_hardware(UInt32 crc, const UInt8* data, SizeType size) noexcept {
+  return crc32c_portable(crc, data, size);
+}
+
+inline Bool crc32c_has_hardware() noexcept {
+  return false;
+}
+#endif
+}  // namespace Detail
+
+/// @brief Update a CRC32C with more bytes, start from 0.
+/// @note crc32c(crc32c(0, a), b) is the CRC32C of a followed by b.
+inline UInt32 crc32c(UInt32 crc, const void* data, SizeType size) noexcept {
+  auto bytes = static_cast<const UInt8*>(data);
+
+  crc = ~crc;
+
+  if (Detail::crc32c_has_hardware())
+    crc = Detail::crc32c_hardware(crc, bytes, size);
+  else
+    crc = Detail::crc32c_portable(crc, bytes, size);
+
+  return ~crc;
+}
+
+/// @brief PEF whole-image checksum, the container's Checksum field counts as zero.
+inline UInt32 pef_image_checksum(std::span<const Char> image) noexcept {
+  if (image.size() < sizeof(PEFContainer)) return crc32c(0U, image.data(), image.size());
+
+  PEFContainer container;
+  std::memcpy(&container, image.data(), sizeof(PEFContainer));
+
+  container.Checksum = 0U;
+
+  UInt32 crc = crc32c(0U, &container, sizeof(PEFContainer));
+
+  return crc32c(crc, image.data() + sizeof(PEFContainer), image.size() - sizeof(PEFContainer));
+}
+
+/// @brief Check a PEF image against its container's checksum.
+inline Bool pef_verify_checksum(std::span<const Char> image) noexcept {
+  if (image.size() < sizeof(PEFContainer)) return false;
+
+  PEFContainer container;
+  std::memcpy(&container, image.data(), sizeof(PEFContainer));
+
+  return container.Checksum == pef_image_checksum(image);
+}
+}  // namespace CompilerKit::Utils
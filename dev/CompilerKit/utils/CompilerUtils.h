@@ -12,6 +12,7 @@
 #include <CompilerKit/Version.h>
 #include <ThirdParty/Dialogs.h>
 #include <iostream>
+#include <span>
 
 #define kZero64Section ".zero64"
 #define kCode64Section ".code64"
@@ -31,14 +32,18 @@
 
 inline static UInt32 kErrorLimit       = 10;
 inline static UInt32 kAcceptableErrors = 0;
-inline static bool   kVerbose          = false;
 inline static bool   kOutputAsBinary   = false;
 
+/// @brief Trace of the assemblers and ar64, the linker keeps its own in LinkerOptions::fVerbose.
+[[maybe_unused]] inline static bool kVerbose = false;
+
 namespace Detail {
 /// @brief Linker specific blob metadata structure
 struct DynamicLinkerBlob final {
-  std::vector<Char> mBlob{};       // PEF code/bss/data blob.
-  UIntPtr           mOffset{0UL};  // the offset of the PEF container header...
+  std::span<const Char> mBlob{};           // PEF code/bss/data blob, borrowed from the object map.
+  UIntPtr               mOffset{0UL};      // the offset of the PEF container header...
+  const Char*           mFile{nullptr};    // file the blob is mapped from, null if it's in memory.
+  UIntPtr               mFileOffset{0UL};  // where the blob starts in that file.
 };
 
 inline void print_error(std::string reason, std::string file) noexcept {
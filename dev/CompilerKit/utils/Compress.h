@@ -0,0 +1,368 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/PEF.h>
+#include <algorithm>
+#include <span>
+
+/// @file Compress.h
+/// @brief LZ codec of compressed PEF images, in the LZ4 block format, and the PEF expansion built
+/// on it. No dependency, the decompressor is made to run at memory speed.
+
+/// @brief Shortest match, and the hash table size of the compressor.
+#define kLZMinMatch (4U)
+#define kLZHashLog (14U)
+
+/// @brief Matches end kLZLastLiterals bytes before the end of a block, and start kLZMatchLimit
+/// bytes before it, so the decompressor can copy past its cursor.
+#define kLZLastLiterals (5U)
+#define kLZMatchLimit (12U)
+
+#define kLZMaxOffset (65535U)
+
+namespace CompilerKit::Utils {
+namespace Detail {
+inline UInt32 lz_read32(const UInt8* bytes) noexcept {
+  UInt32 value;
+  std::memcpy(&value, bytes, sizeof(UInt32));
+
+  return value;
+}
+
+inline UInt32 lz_hash(UInt32 sequence) noexcept {
+  return (sequence * 2654435761U) >> (32 - kLZHashLog);
+}
+
+/// @brief Length of a token's nibble past 15, in 255 steps.
+inline UInt8* lz_write_length(UInt8* out, SizeType length) noexcept {
+  for (; length >= 255; length -= 255) *out++ = 255;
+
+  *out++ = UInt8(length);
+
+  return out;
+}
+
+/// @brief Read the rest of a length that didn't fit its nibble.
+inline Bool lz_read_length(const UInt8*& in, const UInt8* end, SizeType& length) noexcept {
+  UInt8 byte = 255;
+
+  while (byte == 255) {
+    if (in >= end) return false;
+
+    byte = *in++;
+    length += byte;
+  }
+
+  return true;
+}
+
+/// @brief Copy size bytes, 16 at a time, the last copy may write up to 15 bytes past out + size.
+inline void lz_wild_copy(UInt8* out, const UInt8* in, SizeType size) noexcept {
+  UInt8* end = out + size;
+
+  do {
+    std::memcpy(out, in, 16);
+
+    out += 16;
+    in += 16;
+  } while (out < end);
+}
+}  // namespace Detail
+
+/// @brief Worst case size of size bytes once compressed, incompressible data grows a little.
+inline constexpr SizeType lz_compress_bound(SizeType size) noexcept {
+  return size + size / 255 + 16;
+}
+
+/**
+ * @brief Compress a block, greedily, against a hash table of the last place of every sequence.
+ *
+ * @param source the bytes, up to 4 GiB.
+ * @param dest capacity bytes, lz_compress_bound(size) always fits.
+ * @return the compressed size, or 0 when it doesn't fit in capacity.
+ */
+inline SizeType lz_compress(const Char* source, SizeType size, Char* dest,
+                            SizeType capacity) noexcept {
+  if (size > UINT32_MAX) return 0UL;
+
+  auto in  = reinterpret_cast<const UInt8*>(source);
+  auto out = reinterpret_cast<UInt8*>(dest);
+  auto end = out + capacity;
+
+  SizeType anchor = 0UL;
+
+  // a sequence is at most 1 token, 2 offset bytes and the length bytes besides its literals.
+  auto lz_fits = [&](SizeType literals, SizeType match) {
+    return SizeType(end - out) >= 3 + literals + literals / 255 + 1 + match / 255 + 1;
+  };
+
+  if (size > kLZMatchLimit) {
+    std::vector<UInt32> table(1U << kLZHashLog, 0U);
+
+    SizeType limit = size - kLZMatchLimit;
+    SizeType pos   = 1UL;
+
+    while (pos < limit) {
+      UInt32   sequence  = Detail::lz_read32(in + pos);
+      UInt32   hash      = Detail::lz_hash(sequence);
+      SizeType candidate = table[hash];
+
+      table[hash] = UInt32(pos);
+
+      if (candidate >= pos || pos - candidate > kLZMaxOffset ||
+          Detail::lz_read32(in + candidate) != sequence) {
+        // skip faster through bytes that don't compress.
+        pos += 1 + ((pos - anchor) >> 6);
+        continue;
+      }
+
+      while (pos > anchor && candidate > 0 && in[pos - 1] == in[candidate - 1]) {
+        --pos;
+        --candidate;
+      }
+
+      SizeType length = kLZMinMatch;
+      SizeType last   = size - kLZLastLiterals;
+
+      while (pos + length + 8 <= last) {
+        UInt64 lhs, rhs;
+
+        std::memcpy(&lhs, in + pos + length, sizeof(UInt64));
+        std::memcpy(&rhs, in + candidate + length, sizeof(UInt64));
+
+        if (lhs != rhs) {
+          length += __builtin_ctzll(lhs ^ rhs) / 8;
+          goto lz_emit;
+        }
+
+        length += 8;
+      }
+
+      while (pos + length < last && in[pos + length] == in[candidate + length]) ++length;
+
+    lz_emit:
+      SizeType literals = pos - anchor;
+      SizeType match    = length - kLZMinMatch;
+
+      if (!lz_fits(literals, match)) return 0UL;
+
+      *out++ = UInt8(std::min<SizeType>(literals, 15) << 4 | std::min<SizeType>(match, 15));
+
+      if (literals >= 15) out = Detail::lz_write_length(out, literals - 15);
+
+      std::memcpy(out, in + anchor, literals);
+      out += literals;
+
+      *out++ = UInt8(pos - candidate);
+      *out++ = UInt8((pos - candidate) >> 8);
+
+      if (match >= 15) out = Detail::lz_write_length(out, match - 15);
+
+      pos += length;
+      anchor = pos;
+
+      if (pos < limit) table[Detail::lz_hash(Detail::lz_read32(in + pos - 2))] = UInt32(pos - 2);
+    }
+  }
+
+  // the last literals end the block.
+  SizeType literals = size - anchor;
+
+  if (!lz_fits(literals, 0UL)) return 0UL;
+
+  *out++ = UInt8(std::min<SizeType>(literals, 15) << 4);
+
+  if (literals >= 15) out = Detail::lz_write_length(out, literals - 15);
+
+  std::memcpy(out, in + anchor, literals);
+  out += literals;
+
+  return out - reinterpret_cast<UInt8*>(dest);
+}
+
+/**
+ * @brief Decompress a block, every read and write is checked against the bounds.
+ *
+ * @param dest expanded bytes, the exact expanded size of the block.
+ * @return false when the block is corrupt or doesn't expand to expanded bytes.
+ */
+inline Bool lz_decompress(const Char* source, SizeType size, Char* dest,
+                          SizeType expanded) noexcept {
+  auto in     = reinterpret_cast<const UInt8*>(source);
+  auto in_end = in + size;
+  auto out    = reinterpret_cast<UInt8*>(dest);
+  auto start  = out;
+  auto end    = out + expanded;
+
+  while (in < in_end) {
+    UInt8    token    = *in++;
+    SizeType literals = token >> 4;
+    SizeType length   = token & 15;
+    SizeType offset   = 0UL;
+
+    // the common case, short literals then a short match, is done with fixed-size moves.
+    if (literals < 15 && length < 15 && SizeType(in_end - in) >= 16 + 2 &&
+        SizeType(end - out) >= 16 + 24) {
+      std::memcpy(out, in, 16);
+
+      in += literals;
+      out += literals;
+
+      offset = SizeType(in[0]) | SizeType(in[1]) << 8;
+      in += 2;
+
+      if (offset >= 8 && offset <= SizeType(out - start)) {
+        const UInt8* match = out - offset;
+
+        std::memcpy(out, match, 8);
+        std::memcpy(out + 8, match + 8, 8);
+        std::memcpy(out + 16, match + 16, 8);
+
+        out += length + kLZMinMatch;
+        continue;
+      }
+    } else {
+      if (literals == 15 && !Detail::lz_read_length(in, in_end, literals)) return false;
+
+      if (literals > SizeType(in_end - in) || literals > SizeType(end - out)) return false;
+
+      // copied 16 bytes at a time while there's room past them.
+      if (SizeType(in_end - in) >= literals + 16 && SizeType(end - out) >= literals + 16)
+        Detail::lz_wild_copy(out, in, literals);
+      else
+        std::memcpy(out, in, literals);
+
+      in += literals;
+      out += literals;
+
+      // the last sequence has no match.
+      if (in == in_end) return out == end;
+
+      if (in_end - in < 2) return false;
+
+      offset = SizeType(in[0]) | SizeType(in[1]) << 8;
+      in += 2;
+    }
+
+    if (offset == 0 || offset > SizeType(out - start)) return false;
+
+    if (length == 15 && !Detail::lz_read_length(in, in_end, length)) return false;
+
+    length += kLZMinMatch;
+
+    if (length > SizeType(end - out)) return false;
+
+    const UInt8* match = out - offset;
+
+    if (offset >= 16 && SizeType(end - out) >= length + 16) {
+      Detail::lz_wild_copy(out, match, length);
+    } else if (SizeType(end - out) >= length + 16) {
+      // short periods, e.g runs of zeros: the bytes repeat every multiple of offset, so once
+      // 16 or more of them are out the rest is copied 16 at a time. The distance doubles as the
+      // run grows, copies then read bytes that left the store buffer.
+      SizeType period = offset;
+
+      while (period < 16) period += offset;
+
+      SizeType head = std::min(length, period);
+
+      for (SizeType index = 0UL; index < head; ++index) out[index] = match[index];
+
+      for (SizeType index = head; index < length; index += 16) {
+        std::memcpy(out + index, out + index - period, 16);
+
+        if (period < 64 && index + 16 >= 2 * period) period *= 2;
+      }
+    } else {
+      for (SizeType index = 0UL; index < length; ++index) out[index] = match[index];
+    }
+
+    out += length;
+  }
+
+  return false;
+}
+
+/// @brief Compressed ranges of a PEF image, empty when it has none or when they are corrupt.
+inline std::vector<PEFCompressedRange> pef_compressed_ranges(std::span<const Char> file) {
+  if (file.size() < sizeof(PEFContainer)) return {};
+
+  PEFContainer container;
+  std::memcpy(&container, file.data(), sizeof(PEFContainer));
+
+  if (container.Count > (file.size() - sizeof(PEFContainer)) / sizeof(PEFCommandHeader))
+    return {};
+
+  for (SizeType index = 0UL; index < container.Count; ++index) {
+    PEFCommandHeader command_hdr;
+    std::memcpy(&command_hdr,
+                file.data() + sizeof(PEFContainer) + index * sizeof(PEFCommandHeader),
+                sizeof(PEFCommandHeader));
+
+    if (strncmp(command_hdr.Name, kPefCompressedName, kPefNameLen) != 0) continue;
+
+    if (command_hdr.Offset > file.size() ||
+        command_hdr.OffsetSize > file.size() - command_hdr.Offset)
+      return {};
+
+    std::vector<PEFCompressedRange> ranges(command_hdr.OffsetSize / sizeof(PEFCompressedRange));
+    std::memcpy(ranges.data(), file.data() + command_hdr.Offset,
+                ranges.size() * sizeof(PEFCompressedRange));
+
+    return ranges;
+  }
+
+  return {};
+}
+
+/**
+ * @brief Expand a PEF image as stored, the offsets of the image are offsets in the expansion.
+ *
+ * @param file the image as read from disk.
+ * @param image the expanded image, a copy of file when nothing is compressed.
+ * @return false when a range is corrupt.
+ */
+inline Bool pef_expand(std::span<const Char> file, std::vector<Char>& image) {
+  auto ranges = pef_compressed_ranges(file);
+
+  SizeType expanded = file.size();
+
+  for (auto& range : ranges) {
+    if (range.FileOffset > file.size() || range.FileSize > file.size() - range.FileOffset ||
+        range.FileSize > range.Size)
+      return false;
+
+    expanded += range.Size - range.FileSize;
+  }
+
+  image.resize(expanded);
+
+  SizeType from = 0UL, to = 0UL;
+
+  for (auto& range : ranges) {
+    // what lies between two ranges is stored as is.
+    if (range.FileOffset < from || range.Offset != to + (range.FileOffset - from) ||
+        range.Codec != kPefCodecLZ)
+      return false;
+
+    std::memcpy(image.data() + to, file.data() + from, range.FileOffset - from);
+
+    if (!lz_decompress(file.data() + range.FileOffset, range.FileSize,
+                       image.data() + range.Offset, range.Size))
+      return false;
+
+    from = range.FileOffset + range.FileSize;
+    to   = range.Offset + range.Size;
+  }
+
+  std::memcpy(image.data() + to, file.data() + from, file.size() - from);
+
+  return true;
+}
+}  // namespace CompilerKit::Utils
@@ -0,0 +1,424 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/utils/Checksum.h>
+#include <CompilerKit/utils/Compress.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <span>
+
+/// @file ImageWriter.h
+/// @brief Layout-then-emit writer, an image is described as a list of iovecs once every offset is
+/// known, then written in one pass.
+
+#ifndef IOV_MAX
+#define IOV_MAX (1024)
+#endif
+
+/// @brief Zero bytes shared by every padding iovec.
+#define kImageWriterZeroLen (4096U)
+
+/// @brief Bytes a file range goes through at once when the kernel can't copy it for us.
+#define kImageWriterChunkLen (65536U)
+
+namespace CompilerKit::Utils {
+/// @brief Range of a file the image copies, instead of bytes held in memory.
+struct ImageFileRange final {
+  SizeType    fVec;    /* iovec standing for the range, its base is null. */
+  const Char* fPath;   /* must stay alive until Emit. */
+  off_t       fOffset; /* where the range starts in the file. */
+};
+
+/// @brief Range of the image written compressed, see BeginCompressed.
+struct ImageCompressedRange final {
+  SizeType          fFirstVec{0UL}; /* iovecs [fFirstVec, fLastVec) hold its bytes. */
+  SizeType          fLastVec{0UL};
+  SizeType          fOffset{0UL}; /* in the image as laid out, the one Size() counts. */
+  SizeType          fSize{0UL};
+  SizeType          fFileOffset{0UL}; /* in the image as written, set by Compress. */
+  std::vector<Char> fBytes{};         /* compressed, empty when they didn't shrink. */
+};
+
+class ImageWriter final {
+ public:
+  explicit ImageWriter() = default;
+
+  ~ImageWriter() {
+    if (fFileFd >= 0) ::close(fFileFd);
+  }
+
+  NECTI_COPY_DELETE(ImageWriter);
+
+ public:
+  /// @brief Append bytes, they must stay alive until Emit.
+  void Append(const void* data, SizeType size) {
+    if (size == 0) return;
+
+    fVecs.push_back({const_cast<VoidPtr>(data), size});
+    fSize += size;
+  }
+
+  /// @brief Append a range of a file, read at Emit time, so the image never holds it in memory.
+  void AppendFile(const Char* path, off_t offset, SizeType size) {
+    if (size == 0) return;
+
+    fFiles.push_back({fVecs.size(), path, offset});
+    fVecs.push_back({nullptr, size});
+    fSize += size;
+  }
+
+  /// @brief Append zero padding.
+  void AppendZeros(SizeType size) {
+    static const Char kZeros[kImageWriterZeroLen] = {0};
+
+    while (size > 0) {
+      SizeType chunk = std::min<SizeType>(size, kImageWriterZeroLen);
+
+      this->Append(kZeros, chunk);
+      size -= chunk;
+    }
+  }
+
+  /// @brief Start a range written compressed, it ends at EndCompressed. Size() keeps counting
+  /// its bytes as they are, so the offsets laid out are offsets in the expanded image.
+  void BeginCompressed() { fPacked.push_back({.fFirstVec = fVecs.size(), .fOffset = fSize}); }
+
+  void EndCompressed() {
+    auto& range = fPacked.back();
+
+    range.fLastVec = fVecs.size();
+    range.fSize    = fSize - range.fOffset;
+
+    if (range.fSize == 0) fPacked.pop_back();
+  }
+
+  /// @brief Compress the ranges, where the image's bytes land in the file is final past this.
+  /// @return the ranges, the ones that didn't shrink are written as they are.
+  std::span<const ImageCompressedRange> Compress() {
+    std::vector<Char> expanded;
+    SizeType          file = 0UL;
+
+    fSaved = 0UL;
+
+    for (auto& range : fPacked) {
+      expanded.resize(range.fSize);
+
+      SizeType at   = 0UL;
+      Bool     read = true;
+
+      while (file < fFiles.size() && fFiles[file].fVec < range.fFirstVec) ++file;
+
+      for (auto index = range.fFirstVec; index < range.fLastVec; ++index) {
+        if (file < fFiles.size() && fFiles[file].fVec == index) {
+          read &= this->ReadFile(fFiles[file++], fVecs[index].iov_len,
+                                 [&](const Char* data, SizeType size) {
+                                   std::memcpy(expanded.data() + at, data, size);
+                                   at += size;
+                                 });
+          continue;
+        }
+
+        std::memcpy(expanded.data() + at, fVecs[index].iov_base, fVecs[index].iov_len);
+        at += fVecs[index].iov_len;
+      }
+
+      range.fFileOffset = range.fOffset - fSaved;
+      range.fBytes.resize(lz_compress_bound(range.fSize));
+
+      SizeType size =
+          read ? lz_compress(expanded.data(), range.fSize, range.fBytes.data(), range.fBytes.size())
+               : 0UL;
+
+      if (size == 0 || size >= range.fSize) {
+        range.fBytes = {};
+        continue;
+      }
+
+      range.fBytes.resize(size);
+      range.fBytes.shrink_to_fit();
+
+      fSaved += range.fSize - size;
+    }
+
+    return fPacked;
+  }
+
+  /// @brief Image size, as laid out so far.
+  SizeType Size() const { return fSize; }
+
+  /// @brief Image size, as written: Size() less what compression saved.
+  SizeType FileSize() const { return fSize - fSaved; }
+
+  /// @note the iovecs of file ranges have a null base.
+  std::span<const struct iovec> Vecs() const { return fVecs; }
+
+  /// @brief Copy of the image as written so far, for images kept in memory.
+  std::vector<Char> Bytes() const {
+    std::vector<Char> bytes(this->FileSize());
+    SizeType          offset = 0UL;
+
+    this->Walk(
+        [&](std::span<const struct iovec> vecs) {
+          for (auto& vec : vecs) {
+            std::memcpy(bytes.data() + offset, vec.iov_base, vec.iov_len);
+            offset += vec.iov_len;
+          }
+
+          return true;
+        },
+        [&](const ImageFileRange& range, SizeType size) {
+          return this->ReadFile(range, size, [&](const Char* data, SizeType chunk) {
+            std::memcpy(bytes.data() + offset, data, chunk);
+            offset += chunk;
+          });
+        });
+
+    return bytes;
+  }
+
+  /// @brief CRC32C of the image as written so far, file ranges are read a chunk at a time.
+  UInt32 Checksum() const {
+    UInt32 crc = 0U;
+
+    this->Walk(
+        [&](std::span<const struct iovec> vecs) {
+          for (auto& vec : vecs) crc = crc32c(crc, vec.iov_base, vec.iov_len);
+
+          return true;
+        },
+        [&](const ImageFileRange& range, SizeType size) {
+          return this->ReadFile(range, size, [&](const Char* data, SizeType chunk) {
+            crc = crc32c(crc, data, chunk);
+          });
+        });
+
+    return crc;
+  }
+
+  /**
+   * @brief Write the image at the start of fd.
+   *
+   * @param fd the output, opened for writing.
+   * @param preallocate reserve the whole image first, so the file system can allocate it in one
+   * extent.
+   * @return NECTI_SUCCESS or NECTI_EXEC_ERROR.
+   */
+  Int32 Emit(Int32 fd, Bool preallocate) {
+#ifdef __linux__
+    // only a hint, file systems without fallocate support still get the image.
+    if (preallocate && this->FileSize() > 0) ::fallocate(fd, 0, 0, this->FileSize());
+#else
+    (void) preallocate;
+#endif
+
+    SizeType offset = 0UL;
+
+    Bool written = this->Walk(
+        [&](std::span<const struct iovec> vecs) {
+          if (this->WriteVecs(fd, vecs, offset) != NECTI_SUCCESS) return false;
+
+          for (auto& vec : vecs) offset += vec.iov_len;
+
+          return true;
+        },
+        [&](const ImageFileRange& range, SizeType size) {
+          if (this->CopyFile(range, size, fd, offset) != NECTI_SUCCESS) return false;
+
+          offset += size;
+
+          return true;
+        });
+
+    return written ? NECTI_SUCCESS : NECTI_EXEC_ERROR;
+  }
+
+ private:
+  /// @brief Hand the image to the callbacks in file order, as runs of in-memory iovecs, or file
+  /// ranges. A compressed range is a run of one iovec, its compressed bytes.
+  /// @return false as soon as a callback does.
+  template <typename VecsFn, typename FileFn>
+  Bool Walk(VecsFn vecs_fn, FileFn file_fn) const {
+    SizeType file   = 0UL;
+    SizeType packed = 0UL;
+
+    for (SizeType index = 0UL; index < fVecs.size();) {
+      if (packed < fPacked.size() && fPacked[packed].fFirstVec == index) {
+        auto& range = fPacked[packed++];
+
+        // the ranges that didn't shrink are written as they are.
+        if (!range.fBytes.empty()) {
+          struct iovec vec{const_cast<Char*>(range.fBytes.data()), range.fBytes.size()};
+
+          if (!vecs_fn(std::span<const struct iovec>(&vec, 1))) return false;
+
+          index = range.fLastVec;
+
+          while (file < fFiles.size() && fFiles[file].fVec < index) ++file;
+
+          continue;
+        }
+      }
+
+      if (file < fFiles.size() && fFiles[file].fVec == index) {
+        if (!file_fn(fFiles[file++], fVecs[index].iov_len)) return false;
+
+        ++index;
+        continue;
+      }
+
+      SizeType last = fVecs.size();
+
+      if (file < fFiles.size()) last = std::min(last, fFiles[file].fVec);
+      if (packed < fPacked.size()) last = std::min(last, fPacked[packed].fFirstVec);
+
+      if (!vecs_fn(std::span<const struct iovec>(fVecs.data() + index, last - index)))
+        return false;
+
+      index = last;
+    }
+
+    return true;
+  }
+
+  /// @brief Write in-memory iovecs at offset.
+  Int32 WriteVecs(Int32 fd, std::span<const struct iovec> run, SizeType offset) const {
+    std::vector<struct iovec> vecs(run.begin(), run.end());
+
+    SizeType index = 0UL;
+
+    while (index < vecs.size()) {
+      Int32   count   = std::min<SizeType>(vecs.size() - index, IOV_MAX);
+      ssize_t written = ::pwritev(fd, vecs.data() + index, count, offset);
+
+      if (written < 0) {
+        if (errno == EINTR) continue;
+
+        return NECTI_EXEC_ERROR;
+      }
+
+      offset += written;
+
+      // skip what went through, a short write leaves us in the middle of an iovec.
+      while (index < vecs.size() && SizeType(written) >= vecs[index].iov_len) {
+        written -= vecs[index].iov_len;
+        ++index;
+      }
+
+      if (index < vecs.size()) {
+        vecs[index].iov_base = static_cast<Char*>(vecs[index].iov_base) + written;
+        vecs[index].iov_len -= written;
+      }
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  /// @brief Input file of a range, the last one stays open since ranges of a file come in a row.
+  Int32 OpenFile(const Char* path) const {
+    if (fFileFd >= 0 && fFilePath == path) return fFileFd;
+
+    if (fFileFd >= 0) ::close(fFileFd);
+
+    fFilePath = path;
+    fFileFd   = ::open(path, O_RDONLY);
+
+    return fFileFd;
+  }
+
+  /// @brief Hand a file range to fn, a chunk at a time.
+  /// @return false when the file is gone or shorter than the range.
+  template <typename Fn>
+  Bool ReadFile(const ImageFileRange& range, SizeType size, Fn fn) const {
+    Int32 in = this->OpenFile(range.fPath);
+
+    if (in < 0) return false;
+
+    fChunk.resize(kImageWriterChunkLen);
+
+    off_t from = range.fOffset;
+
+    while (size > 0) {
+      ssize_t got = ::pread(in, fChunk.data(), std::min<SizeType>(size, fChunk.size()), from);
+
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) return false;
+
+      fn(fChunk.data(), SizeType(got));
+
+      from += got;
+      size -= got;
+    }
+
+    return true;
+  }
+
+  /// @brief Copy a file range to offset, in the kernel when it can, through a chunk otherwise.
+  Int32 CopyFile(const ImageFileRange& range, SizeType size, Int32 fd, SizeType offset) const {
+    Int32 in = this->OpenFile(range.fPath);
+
+    if (in < 0) return NECTI_EXEC_ERROR;
+
+    ImageFileRange rest = range;
+
+#ifdef __linux__
+    off_t to = offset;
+
+    while (size > 0) {
+      ssize_t copied = ::copy_file_range(in, &rest.fOffset, fd, &to, size, 0);
+
+      if (copied < 0 && errno == EINTR) continue;
+
+      // not across these file systems, the rest goes through the chunk.
+      if (copied <= 0) break;
+
+      size -= copied;
+    }
+
+    offset = to;
+#endif
+
+    Bool failed = false;
+
+    Bool read = this->ReadFile(rest, size, [&](const Char* data, SizeType chunk) {
+      while (chunk > 0 && !failed) {
+        ssize_t put = ::pwrite(fd, data, chunk, offset);
+
+        if (put < 0 && errno == EINTR) continue;
+
+        failed = put <= 0;
+
+        if (put > 0) {
+          data += put;
+          chunk -= put;
+          offset += put;
+        }
+      }
+    });
+
+    return read && !failed ? NECTI_SUCCESS : NECTI_EXEC_ERROR;
+  }
+
+ private:
+  std::vector<struct iovec>         fVecs{};
+  std::vector<ImageFileRange>       fFiles{};
+  std::vector<ImageCompressedRange> fPacked{};
+  SizeType                          fSize{0UL};
+  SizeType                          fSaved{0UL}; /* bytes compression saved. */
+
+  /* file ranges are read through these. */
+  mutable std::vector<Char> fChunk{};
+  mutable const Char*       fFilePath{nullptr};
+  mutable Int32             fFileFd{-1};
+};
+}  // namespace CompilerKit::Utils
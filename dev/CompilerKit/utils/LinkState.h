@@ -0,0 +1,190 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/PEF.h>
+#include <CompilerKit/utils/SymbolTable.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+/// @file LinkState.h
+/// @brief Sidecar link state, written next to the image by ld64 -incremental.
+
+#define kLinkStateMagic "LdSt"
+#define kLinkStateMagicLen (4)
+#define kLinkStateVersion (0x0200)
+#define kLinkStateExt ".ldstate"
+
+/// @brief Default slack reserved after every object slot, in percent of its size.
+#define kLinkStateDefaultSlack (25U)
+#define kLinkStateMinSlack (64U)
+
+namespace CompilerKit::Utils {
+enum {
+  kLinkStateObjectDropped    = 0x1,  /* removed by -gc-sections, it has no slot in the image. */
+  kLinkStateObjectFolded     = 0x2,  /* folded by -icf, its headers alias another object. */
+  kLinkStateObjectFoldTarget = 0x4,  /* other objects were folded into this one. */
+  kLinkStateObjectRelocated  = 0x8,  /* has fixups, or is the target of another object's. */
+  kLinkStateObjectExported   = 0x10, /* defines symbols of a dylib's export table. */
+};
+
+/// @brief Link state header, objects, command headers then symbols follow it.
+struct LinkStateHeader final {
+  Char     fMagic[kLinkStateMagicLen];
+  UInt32   fVersion;
+  UInt64   fOptions;      /* hash of the options the image was linked with. */
+  UInt64   fObjectCount;  /* LinkStateObject entries. */
+  UInt64   fHeaderCount;  /* PEFCommandHeader entries, as written to the image. */
+  UInt64   fSymbolCount;  /* symbol entries. */
+  UIntPtr  fStart;        /* PEFContainer::Start */
+  SizeType fDataStart;    /* file offset of the first object slot. */
+} PACKED;
+
+/// @brief Object slot, the object's written headers and its reserved bytes inside the image.
+struct LinkStateObject final {
+  UInt64   fHash;            /* content hash of the object. */
+  UInt64   fSignature;       /* hash of the object's record names and kinds. */
+  Int64    fMTime;           /* modification time in nanoseconds when it was linked. */
+  SizeType fFileSize;        /* st_size when it was linked. */
+  SizeType fFirstHeader;     /* index of the first written header. */
+  SizeType fHeaderCount;     /* written headers of this object. */
+  UIntPtr  fHeaderBase;      /* offset its records start from, the blob offset. */
+  SizeType fVirtualSize;     /* bytes its records span, the code size. */
+  SizeType fVirtualReserve;  /* reserved VirtualSize, including slack. */
+  SizeType fBlobOffset;      /* file offset of the blob. */
+  SizeType fBlobSize;        /* blob size. */
+  SizeType fBlobReserve;     /* reserved blob bytes, including slack. */
+  UInt32   fFlags;           /* kLinkStateObject* flags. */
+  UInt32   fPathLen;         /* path bytes following this entry. */
+} PACKED;
+
+/// @brief In-memory link state.
+struct LinkState final {
+  LinkStateHeader                 fHeader{};
+  std::vector<LinkStateObject>    fObjects{};
+  std::vector<STLString>          fPaths{};
+  std::vector<PEFCommandHeader>   fHeaders{};
+  std::vector<SymbolTable::Entry> fSymbols{};
+};
+
+/// @brief Sidecar path of an image.
+inline STLString link_state_path(const STLString& image) {
+  return image + kLinkStateExt;
+}
+
+/// @brief Size of an object slot once slack is added.
+inline SizeType link_state_reserve(SizeType size, SizeType slack_percent) noexcept {
+  SizeType slack = std::max<SizeType>(size * slack_percent / 100, kLinkStateMinSlack);
+  return (size + slack + 15) & ~SizeType(15);
+}
+
+inline Bool link_state_save(const STLString& path, LinkState& state) {
+  std::ofstream out(path, std::ofstream::binary | std::ofstream::trunc);
+
+  if (!out) return false;
+
+  std::memcpy(state.fHeader.fMagic, kLinkStateMagic, kLinkStateMagicLen);
+
+  state.fHeader.fVersion     = kLinkStateVersion;
+  state.fHeader.fObjectCount = state.fObjects.size();
+  state.fHeader.fHeaderCount = state.fHeaders.size();
+  state.fHeader.fSymbolCount = state.fSymbols.size();
+
+  out.write((Char*) &state.fHeader, sizeof(LinkStateHeader));
+
+  for (SizeType index = 0UL; index < state.fObjects.size(); ++index) {
+    state.fObjects[index].fPathLen = state.fPaths[index].size();
+
+    out.write((Char*) &state.fObjects[index], sizeof(LinkStateObject));
+    out.write(state.fPaths[index].data(), state.fPaths[index].size());
+  }
+
+  out.write((Char*) state.fHeaders.data(), state.fHeaders.size() * sizeof(PEFCommandHeader));
+
+  for (auto& symbol : state.fSymbols) {
+    UInt32 len = symbol.fName.size();
+
+    out.write((Char*) &len, sizeof(UInt32));
+    out.write(symbol.fName.data(), len);
+    out.write((Char*) &symbol.fDefinition, sizeof(Int64));
+    out.write((Char*) &symbol.fReferenced, sizeof(Bool));
+  }
+
+  return out.good();
+}
+
+inline Bool link_state_load(const STLString& path, LinkState& state) {
+  std::ifstream in(path, std::ifstream::binary);
+
+  if (!in) return false;
+
+  in.read((Char*) &state.fHeader, sizeof(LinkStateHeader));
+
+  if (!in || std::memcmp(state.fHeader.fMagic, kLinkStateMagic, kLinkStateMagicLen) != 0 ||
+      state.fHeader.fVersion != kLinkStateVersion)
+    return false;
+
+  for (SizeType index = 0UL; index < state.fHeader.fObjectCount && in; ++index) {
+    LinkStateObject object{};
+    in.read((Char*) &object, sizeof(LinkStateObject));
+
+    STLString object_path(object.fPathLen, 0);
+    in.read(object_path.data(), object.fPathLen);
+
+    state.fObjects.push_back(object);
+    state.fPaths.push_back(std::move(object_path));
+  }
+
+  state.fHeaders.resize(state.fHeader.fHeaderCount);
+  in.read((Char*) state.fHeaders.data(), state.fHeaders.size() * sizeof(PEFCommandHeader));
+
+  for (SizeType index = 0UL; index < state.fHeader.fSymbolCount && in; ++index) {
+    SymbolTable::Entry symbol{};
+    UInt32             len = 0;
+
+    in.read((Char*) &len, sizeof(UInt32));
+
+    symbol.fName.resize(len);
+
+    in.read(symbol.fName.data(), len);
+    in.read((Char*) &symbol.fDefinition, sizeof(Int64));
+    in.read((Char*) &symbol.fReferenced, sizeof(Bool));
+
+    state.fSymbols.push_back(std::move(symbol));
+  }
+
+  return bool(in);
+}
+
+/// @brief Modification time of a stat result, in nanoseconds.
+inline Int64 link_state_mtime(const struct stat& st) noexcept {
+#ifdef __APPLE__
+  return Int64(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+  return Int64(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+}
+
+/// @brief Whether a file still matches the stat data it was linked with.
+inline Bool link_state_same_stat(const STLString& path, const LinkStateObject& object) {
+  struct stat st{};
+
+  if (::stat(path.c_str(), &st) != 0) return false;
+
+  return link_state_mtime(st) == object.fMTime && SizeType(st.st_size) == object.fFileSize;
+}
+
+/// @brief Record the stat data of a file into its object slot.
+inline void link_state_stat(const STLString& path, LinkStateObject& object) {
+  struct stat st{};
+
+  if (::stat(path.c_str(), &st) != 0) return;
+
+  object.fMTime    = link_state_mtime(st);
+  object.fFileSize = st.st_size;
+}
+}  // namespace CompilerKit::Utils
@@ -0,0 +1,172 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <CompilerKit/ErrorID.h>
+#include <CompilerKit/PEF.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <span>
+
+/// @file MappedImage.h
+/// @brief Read-only view of a PEF image, or of a FAT container of them.
+/// @note Only the container and its command headers are read, the code and data pages are never
+/// touched, so looking at an image costs its header count, not its size.
+
+namespace CompilerKit::Utils {
+class PEFMappedImage final {
+ public:
+  explicit PEFMappedImage() = default;
+  ~PEFMappedImage() { this->Close(); }
+
+  NECTI_COPY_DELETE(PEFMappedImage);
+
+  PEFMappedImage(PEFMappedImage&& other) noexcept
+      : fMap(std::exchange(other.fMap, nullptr)),
+        fSize(std::exchange(other.fSize, 0UL)),
+        fOwned(std::exchange(other.fOwned, false)) {}
+
+  PEFMappedImage& operator=(PEFMappedImage&& other) noexcept {
+    if (this != &other) {
+      this->Close();
+
+      fMap   = std::exchange(other.fMap, nullptr);
+      fSize  = std::exchange(other.fSize, 0UL);
+      fOwned = std::exchange(other.fOwned, false);
+    }
+
+    return *this;
+  }
+
+  /**
+   * @brief Map an image and validate its container and header table.
+   *
+   * @param path the image path.
+   * @return NECTI_SUCCESS, NECTI_FILE_NOT_FOUND or NECTI_INVALID_DATA.
+   */
+  Int32 Open(const Char* path) {
+    this->Close();
+
+    Int32 fd = ::open(path, O_RDONLY);
+
+    if (fd < 0) return NECTI_FILE_NOT_FOUND;
+
+    struct stat st{};
+
+    if (::fstat(fd, &st) != 0 || st.st_size < Int64(sizeof(PEFContainer))) {
+      ::close(fd);
+      return NECTI_INVALID_DATA;
+    }
+
+    VoidPtr map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) return NECTI_FILE_NOT_FOUND;
+
+    fMap   = static_cast<const Char*>(map);
+    fSize  = st.st_size;
+    fOwned = true;
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    // the header table is all we read, don't let the kernel read ahead into the code.
+    ::madvise(map, fSize, MADV_RANDOM);
+
+    return NECTI_SUCCESS;
+  }
+
+  /**
+   * @brief View an image held by someone else, e.g a FAT slice, and validate it.
+   *
+   * @param bytes the image bytes, they must outlive this view.
+   * @return NECTI_SUCCESS or NECTI_INVALID_DATA.
+   */
+  Int32 Open(std::span<const Char> bytes) {
+    this->Close();
+
+    if (bytes.size() < sizeof(PEFContainer)) return NECTI_INVALID_DATA;
+
+    fMap  = bytes.data();
+    fSize = bytes.size();
+
+    if (!this->Validate()) {
+      this->Close();
+      return NECTI_INVALID_DATA;
+    }
+
+    return NECTI_SUCCESS;
+  }
+
+  void Close() {
+    if (fMap && fOwned) ::munmap(const_cast<Char*>(fMap), fSize);
+
+    fMap   = nullptr;
+    fSize  = 0UL;
+    fOwned = false;
+  }
+
+  const PEFContainer* Container() const { return reinterpret_cast<const PEFContainer*>(fMap); }
+
+  /// @brief Whether this is a FAT container, whose slices are images of their own.
+  Bool IsFat() const {
+    return fMap && std::memcmp(fMap, kPefMagicFat, kPefMagicLen - 1) == 0;
+  }
+
+  /// @brief Command headers of an image, a FAT container has none.
+  std::span<const PEFCommandHeader> Headers() const {
+    if (!fMap || this->IsFat()) return {};
+
+    return {reinterpret_cast<const PEFCommandHeader*>(fMap + sizeof(PEFContainer)),
+            this->Container()->Count};
+  }
+
+  std::span<const PEFFatSlice> Slices() const {
+    if (!fMap || !this->IsFat()) return {};
+
+    return {reinterpret_cast<const PEFFatSlice*>(fMap + sizeof(PEFContainer)),
+            this->Container()->Count};
+  }
+
+  std::span<const Char> SliceBytes(const PEFFatSlice& slice) const {
+    return {fMap + slice.Offset, slice.Size};
+  }
+
+  /// @brief Whole image, as mapped.
+  std::span<const Char> Bytes() const { return {fMap, fSize}; }
+
+  SizeType Size() const { return fSize; }
+
+  operator bool() const { return fMap; }
+
+ private:
+  Bool Validate() const {
+    Bool fat = this->IsFat();
+
+    if (!fat && std::memcmp(fMap, kPefMagic, kPefMagicLen - 1) != 0) return false;
+
+    SizeType entry = fat ? sizeof(PEFFatSlice) : sizeof(PEFCommandHeader);
+
+    if (this->Container()->Count > (fSize - sizeof(PEFContainer)) / entry) return false;
+
+    for (auto& slice : this->Slices()) {
+      if (slice.Offset > fSize || slice.Size > fSize - slice.Offset) return false;
+    }
+
+    return true;
+  }
+
+ private:
+  const Char* fMap{nullptr};
+  SizeType    fSize{0UL};
+  Bool        fOwned{false};
+};
+}  // namespace CompilerKit::Utils
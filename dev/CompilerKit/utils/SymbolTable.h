@@ -0,0 +1,144 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <string_view>
+
+/// @file SymbolTable.h
+/// @brief Linker symbol table, interned names behind an open-addressing hash index.
+
+#define kSymbolTableMinSlots (64U)
+#define kSymbolTableLoadNum (7U)
+#define kSymbolTableLoadDen (10U)
+
+namespace CompilerKit {
+/// @brief Interned symbol handle, index inside the SymbolTable.
+using SymbolId = UInt32;
+
+inline constexpr SymbolId kSymbolInvalid = ~0U;
+
+/// @brief FNV-1a hash of a symbol name.
+inline UInt64 symbol_hash(std::string_view name) noexcept {
+  UInt64 hash = 0xcbf29ce484222325ULL;
+
+  for (auto ch : name) {
+    hash ^= static_cast<UInt8>(ch);
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+/// @brief Demangle a symbol name, e.g `.code64$foo` becomes `.code64foo`.
+/// @param name the symbol name, with any :UndefinedSymbol: prefix already stripped.
+inline STLString symbol_demangle(std::string_view name) {
+  STLString out;
+  out.reserve(name.size());
+
+  for (auto ch : name) {
+    if (ch != '$') out.push_back(ch);
+  }
+
+  return out;
+}
+
+/// @brief Linker symbol table.
+/// @note Every name is stored once, lookups hash the exact demangled name.
+class SymbolTable final {
+ public:
+  /// @brief Symbol entry, one per distinct name.
+  struct Entry final {
+    STLString fName{};
+    UInt64    fHash{0UL};
+    Int64     fDefinition{-1};  // index of the defining command header, -1 if none.
+    SizeType  fDefCount{0UL};
+    Bool      fReferenced{false};
+  };
+
+ public:
+  explicit SymbolTable() = default;
+  ~SymbolTable()         = default;
+
+  NECTI_COPY_DEFAULT(SymbolTable);
+
+ public:
+  /// @brief Find or insert a name.
+  /// @return the symbol handle.
+  SymbolId Intern(std::string_view name) {
+    if ((fEntries.size() + 1) * kSymbolTableLoadDen >= fSlots.size() * kSymbolTableLoadNum)
+      this->Grow();
+
+    auto     hash = symbol_hash(name);
+    SizeType mask = fSlots.size() - 1;
+
+    for (SizeType slot = hash & mask;; slot = (slot + 1) & mask) {
+      if (fSlots[slot] == kSymbolInvalid) {
+        fSlots[slot] = static_cast<SymbolId>(fEntries.size());
+        fEntries.push_back({.fName = STLString(name), .fHash = hash});
+
+        return fSlots[slot];
+      }
+
+      auto& entry = fEntries[fSlots[slot]];
+
+      if (entry.fHash == hash && entry.fName == name) return fSlots[slot];
+    }
+  }
+
+  /// @brief Find a name without inserting it.
+  /// @return the symbol handle, or kSymbolInvalid.
+  SymbolId Find(std::string_view name) const {
+    if (fSlots.empty()) return kSymbolInvalid;
+
+    auto     hash = symbol_hash(name);
+    SizeType mask = fSlots.size() - 1;
+
+    for (SizeType slot = hash & mask; fSlots[slot] != kSymbolInvalid; slot = (slot + 1) & mask) {
+      auto& entry = fEntries[fSlots[slot]];
+
+      if (entry.fHash == hash && entry.fName == name) return fSlots[slot];
+    }
+
+    return kSymbolInvalid;
+  }
+
+  Entry& operator[](SymbolId id) { return fEntries[id]; }
+
+  const Entry& operator[](SymbolId id) const { return fEntries[id]; }
+
+  SizeType Count() const { return fEntries.size(); }
+
+  std::vector<Entry>& Entries() { return fEntries; }
+
+  void Reserve(SizeType count) {
+    fEntries.reserve(count);
+
+    while (count * kSymbolTableLoadDen >= fSlots.size() * kSymbolTableLoadNum) this->Grow();
+  }
+
+ private:
+  void Grow() {
+    SizeType new_size = fSlots.empty() ? kSymbolTableMinSlots : fSlots.size() * 2;
+    SizeType mask     = new_size - 1;
+
+    fSlots.assign(new_size, kSymbolInvalid);
+
+    for (SymbolId id = 0; id < fEntries.size(); ++id) {
+      SizeType slot = fEntries[id].fHash & mask;
+
+      while (fSlots[slot] != kSymbolInvalid) slot = (slot + 1) & mask;
+
+      fSlots[slot] = id;
+    }
+  }
+
+ private:
+  std::vector<Entry>    fEntries{};
+  std::vector<SymbolId> fSlots{};
+};
+}  // namespace CompilerKit
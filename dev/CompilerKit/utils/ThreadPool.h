@@ -0,0 +1,69 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#pragma once
+
+#include <CompilerKit/Defines.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+/// @file ThreadPool.h
+/// @brief Work-stealing pool for independent, indexed jobs.
+
+namespace CompilerKit::Utils {
+/// @brief Number of workers to use for a requested job count, 0 meaning one per core.
+inline SizeType pool_worker_count(SizeType jobs, SizeType work) noexcept {
+  if (jobs == 0) jobs = std::max(1U, std::thread::hardware_concurrency());
+
+  return std::max<SizeType>(1UL, std::min(jobs, work));
+}
+
+/// @brief Run fn(index) for every index in [0, count).
+/// @note Every worker owns a slice of the range, drains it, then steals from the other slices.
+/// The caller's thread is worker 0, so jobs = 1 runs serially without spawning anything.
+template <typename Fn>
+inline void pool_for_each(SizeType count, SizeType jobs, Fn&& fn) {
+  struct Slice final {
+    std::atomic<SizeType> fNext{0UL};
+    SizeType              fEnd{0UL};
+  };
+
+  SizeType workers = pool_worker_count(jobs, count);
+
+  if (workers == 1) {
+    for (SizeType index = 0UL; index < count; ++index) fn(index);
+
+    return;
+  }
+
+  std::vector<Slice> slices(workers);
+
+  for (SizeType worker = 0UL; worker < workers; ++worker) {
+    slices[worker].fNext = count * worker / workers;
+    slices[worker].fEnd  = count * (worker + 1) / workers;
+  }
+
+  auto run = [&](SizeType self) {
+    for (SizeType victim = 0UL; victim < workers; ++victim) {
+      auto& slice = slices[(self + victim) % workers];
+
+      SizeType index = 0UL;
+
+      while ((index = slice.fNext.fetch_add(1)) < slice.fEnd) fn(index);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+
+  for (SizeType worker = 1UL; worker < workers; ++worker) threads.emplace_back(run, worker);
+
+  run(0UL);
+
+  for (auto& thread : threads) thread.join();
+}
+}  // namespace CompilerKit::Utils
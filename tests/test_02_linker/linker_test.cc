@@ -8,6 +8,150 @@
 /// @author Amlal El Mahrouss
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// after gtest, CompilerKit defines Bool and friends as macros.
+#include <CompilerKit/AE.h>
+#include <CompilerKit/Exports.h>
+#include <CompilerKit/Linker.h>
+#include <CompilerKit/utils/Checksum.h>
+#include <CompilerKit/impl/PowerPC.h>
+#include <CompilerKit/impl/X64.h>
+#include <CompilerKit/utils/Compress.h>
+
+/// @brief Read a whole file, empty when it cannot be opened.
+static std::vector<unsigned char> ld_test_read(const char* path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+/// @brief Offset of the first occurrence of needle in image, or -1.
+static long ld_test_find(const std::vector<unsigned char>& image,
+                         const std::vector<unsigned char>& needle, long from = 0) {
+  auto it = std::search(image.begin() + from, image.end(), needle.begin(), needle.end());
+  return it == image.end() ? -1 : it - image.begin();
+}
+
+/// @brief The Container:GUID header name of an image, empty when it has none.
+static std::string ld_test_guid(const std::vector<unsigned char>& image) {
+  std::string prefix = "Container:GUID:";
+  auto        at     = ld_test_find(image, {prefix.begin(), prefix.end()});
+
+  if (at == -1) return {};
+
+  return {reinterpret_cast<const char*>(image.data() + at)};
+}
+
+/// @brief Target of the rel32 branch at offset at, as an image offset.
+static long ld_test_branch_target(const std::vector<unsigned char>& image, long at) {
+  std::int32_t rel32 = 0;
+  std::memcpy(&rel32, image.data() + at + 1, sizeof(rel32));
+  return at + 5 + rel32;
+}
+
+/// @brief The command headers of an image, by name.
+static std::vector<CompilerKit::PEFCommandHeader> ld_test_headers(
+    const std::vector<unsigned char>& image) {
+  CompilerKit::PEFContainer container{};
+
+  if (image.size() < sizeof(container)) return {};
+
+  std::memcpy(&container, image.data(), sizeof(container));
+
+  std::vector<CompilerKit::PEFCommandHeader> headers(container.Count);
+
+  if (image.size() < sizeof(container) + headers.size() * sizeof(headers[0])) return {};
+
+  std::memcpy(headers.data(), image.data() + sizeof(container),
+              headers.size() * sizeof(headers[0]));
+
+  return headers;
+}
+
+/// @brief Standard output of a command, empty when it failed.
+static std::string ld_test_output(const std::string& command) {
+  if (std::system((command + " > output.txt").c_str()) != 0) return {};
+
+  auto output = ld_test_read("output.txt");
+  return {output.begin(), output.end()};
+}
+
+/// @brief Whether an image has a header of that name.
+static bool ld_test_has(const std::vector<CompilerKit::PEFCommandHeader>& headers,
+                        const char*                                       name) {
+  return std::any_of(headers.begin(), headers.end(),
+                     [&](auto& header) { return std::strcmp(header.Name, name) == 0; });
+}
+
+/// @brief Write an AMD64 object the way the assembler writes its own, for what it has no syntax
+/// for. Records are laid out as ae_write_records takes them, their bytes inside code.
+static bool ld_test_write_object(const char*                                     path,
+                                 const std::vector<CompilerKit::AERecordHeader>& records,
+                                 const std::vector<unsigned char>&               code,
+                                 const std::vector<CompilerKit::AERelocation>&   relocs = {}) {
+  std::ofstream out(path, std::ios::binary);
+
+  if (!out) return false;
+
+  CompilerKit::AEHeader hdr{};
+
+  hdr.fMagic[0] = kAEMag0;
+  hdr.fMagic[1] = kAEMag1;
+  hdr.fArch     = CompilerKit::kPefArchAMD64;
+  hdr.fCount    = records.size();
+
+  out << hdr;
+
+  CompilerKit::Utils::ae_write_records(out, hdr, records, kAESectionSplit);
+
+  hdr.fStartCode  = out.tellp();
+  hdr.fCodeSize   = code.size();
+  hdr.fRelocCount = relocs.size();
+  hdr.fRelocStart = relocs.empty() ? 0UL : hdr.fStartCode + hdr.fCodeSize;
+
+  out.write(reinterpret_cast<const char*>(code.data()), code.size());
+  out.write(reinterpret_cast<const char*>(relocs.data()),
+            relocs.size() * sizeof(CompilerKit::AERelocation));
+
+  out.seekp(0);
+  out << hdr;
+
+  return bool(out);
+}
+
+/// @brief A record of an object written by ld_test_write_object.
+static CompilerKit::AERecordHeader ld_test_record(const std::string& name, std::size_t kind,
+                                                  std::size_t offset = 0, std::size_t size = 0) {
+  CompilerKit::AERecordHeader record{};
+
+  std::snprintf(record.fName, sizeof(record.fName), "%s", name.c_str());
+  record.fKind   = kind;
+  record.fOffset = offset;
+  record.fSize   = size;
+
+  return record;
+}
+
+/// @brief Write an AMD64 object whose function calls a :RuntimeSymbol:, the assembler has no
+/// syntax for those.
+static bool ld_test_write_import(const char* path, const char* function = "__NECTI_main") {
+  // call puts then ret, the call's rel32 is the only fixup.
+  std::vector<unsigned char> code = {0xE8, 0x00, 0x00, 0x00, 0x00, 0xC3};
+
+  return ld_test_write_object(
+      path,
+      {ld_test_record(std::string(".code64$") + function, CompilerKit::kPefCode, 0, code.size()),
+       ld_test_record(":RuntimeSymbol:puts", kAENullType)},
+      code,
+      {{.fOffset = 1, .fRecord = 1, .fKind = CompilerKit::kAERelocRel32, .fFlags = 0,
+        .fAddend = -4}});
+}
 
 TEST(LinkerTest, BasicLinkTest) {
   /// @note this is the driver, it will look for a .cc.pp (.pp stands for pre-processed)
@@ -20,3 +164,1046 @@ TEST(LinkerTest, BasicLinkTest) {
   expr = std::system("ld64 -amd64 sample/sample.cc.pp.obj -start __NECTI_main -output main.exec");
   EXPECT_TRUE(expr == 0) << "Linker did not link the easy object.";
 }
+
+TEST(LinkerTest, ReproducibleLinkTest) {
+  auto expr = std::system(
+      "ld64 -amd64 -reproducible sample/sample.cc.pp.obj -start __NECTI_main -output r1.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the easy object.";
+
+  expr = std::system(
+      "ld64 -amd64 -reproducible sample/sample.cc.pp.obj -start __NECTI_main -output r2.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the easy object.";
+
+  expr = std::system("cmp -s r1.exec r2.exec");
+  EXPECT_TRUE(expr == 0) << "Reproducible links of the same object differ.";
+}
+
+TEST(LinkerTest, ParallelLinkTest) {
+  auto expr = std::system("asm -asm:x64 sample/caller.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the caller unit.";
+
+  expr = std::system("asm -asm:x64 sample/callee.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the callee unit.";
+
+  expr = std::system("ld64 -amd64 -reproducible -j 1 sample/caller.obj sample/callee.obj "
+                     "-start __NECTI_main -output j1.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the objects serially.";
+
+  expr = std::system("ld64 -amd64 -reproducible -j 8 sample/caller.obj sample/callee.obj "
+                     "-start __NECTI_main -output j8.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the objects with 8 jobs.";
+
+  expr = std::system("cmp -s j1.exec j8.exec");
+  EXPECT_TRUE(expr == 0) << "Serial and parallel links of the same objects differ.";
+}
+
+TEST(LinkerTest, ReproducibleOptionsTest) {
+  auto expr = std::system(
+      "ld64 -amd64 -reproducible sample/sample.cc.pp.obj -start __NECTI_main -output r1.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the easy object.";
+
+  expr = std::system("ld64 -amd64 -reproducible -compress sample/sample.cc.pp.obj -start "
+                     "__NECTI_main -output r3.exec");
+  EXPECT_TRUE(expr == 0) << "Linker did not link the easy object compressed.";
+
+  auto plain      = ld_test_guid(ld_test_read("r1.exec"));
+  auto compressed = ld_test_guid(ld_test_read("r3.exec"));
+
+  ASSERT_FALSE(plain.empty()) << "The image has no GUID.";
+  EXPECT_NE(plain, compressed) << "-compress doesn't change the reproducible GUID.";
+
+  // how the image is read and written doesn't change its bytes.
+  for (const char* option : {"-stream", "-preallocate"}) {
+    expr = std::system((std::string("ld64 -amd64 -reproducible ") + option +
+                        " sample/sample.cc.pp.obj -start __NECTI_main -output r4.exec")
+                           .c_str());
+    EXPECT_TRUE(expr == 0) << "Linker did not link the easy object with " << option;
+
+    expr = std::system("cmp -s r1.exec r4.exec");
+    EXPECT_TRUE(expr == 0) << option << " changes the reproducible image.";
+  }
+}
+
+TEST(LinkerTest, CallAcrossObjectsTest) {
+  auto expr = std::system("asm -asm:x64 sample/caller.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the caller unit.";
+
+  expr = std::system("asm -asm:x64 sample/callee.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the callee unit.";
+
+  expr = std::system(
+      "ld64 -amd64 sample/caller.obj sample/callee.obj -start __NECTI_main -output call.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the caller and callee objects.";
+
+  auto image = ld_test_read("call.exec");
+
+  // mov rax, 42; ret
+  auto callee = ld_test_find(image, {0x48, 0xC7, 0xC0, 0x2A, 0x00, 0x00, 0x00, 0xC3});
+  ASSERT_NE(callee, -1) << "The callee code is missing from the image.";
+
+  // call callee; jmp callee; call __NECTI_main; ret, the headers may hold any byte.
+  long caller = -1;
+
+  for (long at = 0; at + 16 <= static_cast<long>(image.size()) && caller == -1; ++at) {
+    if (image[at] == 0xE8 && image[at + 5] == 0xE9 && image[at + 10] == 0xE8 &&
+        image[at + 15] == 0xC3)
+      caller = at;
+  }
+
+  ASSERT_NE(caller, -1) << "call/jmp rel32 are not encoded as E8/E9.";
+
+  EXPECT_EQ(ld_test_branch_target(image, caller), callee) << "call callee lands elsewhere.";
+  EXPECT_EQ(ld_test_branch_target(image, caller + 5), callee) << "jmp callee lands elsewhere.";
+  EXPECT_EQ(ld_test_branch_target(image, caller + 10), caller)
+      << "call __NECTI_main does not land on its own record.";
+}
+
+TEST(LinkerTest, OpcodeLookupTest) {
+  // the table used to be scanned from the start, the first entry of a mnemonic won.
+  auto linear_scan = [](std::string_view mnemonic) -> const CpuOpcodeAMD64* {
+    for (auto& opcode : kOpcodesAMD64)
+      if (opcode.fName == mnemonic) return &opcode;
+
+    return nullptr;
+  };
+
+  for (auto& opcode : kOpcodesAMD64) {
+    auto found = asm_amd64_find_opcode(opcode.fName);
+
+    ASSERT_EQ(found.size(), 1UL) << "Mnemonic " << opcode.fName << " is not indexed.";
+    EXPECT_EQ(&found.front(), linear_scan(opcode.fName)) << "Mnemonic " << opcode.fName;
+  }
+
+  for (std::string_view mnemonic : {"", "frob", "movq", "mo", "jmpp", "CALL", "r"}) {
+    EXPECT_EQ(linear_scan(mnemonic), nullptr);
+    EXPECT_TRUE(asm_amd64_find_opcode(mnemonic).empty()) << "Mnemonic " << mnemonic;
+  }
+}
+
+TEST(LinkerTest, DylibExportsTest) {
+  auto expr = std::system("asm -asm:x64 sample/callee.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the callee unit.";
+
+  expr = std::system("ld64 -amd64 -dylib sample/callee.obj -output callee.dylib");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the callee dylib.";
+
+  auto image = ld_test_read("callee.dylib");
+
+  CompilerKit::Utils::ExportTable exports;
+
+  ASSERT_EQ(exports.OpenImage({reinterpret_cast<const char*>(image.data()), image.size()}),
+            NECTI_SUCCESS)
+      << "The dylib has no export table.";
+
+  auto callee = exports.Find("callee");
+
+  ASSERT_NE(callee, nullptr) << "callee isn't exported under its plain name.";
+  EXPECT_EQ(exports.Name(*callee), "callee");
+  EXPECT_LT(callee->fOffset, image.size());
+  EXPECT_EQ(image[callee->fOffset], 0x48) << "callee's export doesn't point at its code.";
+
+  EXPECT_EQ(exports.Find(".code64callee"), nullptr) << "Exports use the symbol table key.";
+  EXPECT_EQ(exports.Find("caller"), nullptr);
+}
+
+TEST(LinkerTest, RecordRangesTest) {
+  auto expr = std::system("asm -asm:x64 sample/multi.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the multi unit.";
+
+  for (const char* layout : {"", "-page-align"}) {
+    std::string command = "ld64 -amd64 sample/multi.obj -start __NECTI_main -output multi.exec ";
+    expr                = std::system((command + layout).c_str());
+    ASSERT_TRUE(expr == 0) << "Linker did not link the multi unit " << layout;
+
+    auto image   = ld_test_read("multi.exec");
+    auto headers = ld_test_headers(image);
+
+    auto record = [&](const char* name) -> const CompilerKit::PEFCommandHeader* {
+      for (auto& header : headers)
+        if (std::strcmp(header.Name, name) == 0) return &header;
+
+      return nullptr;
+    };
+
+    auto foo  = record(".code64$foo");
+    auto bar  = record(".code64$bar");
+    auto main = record(".code64$__NECTI_main");
+
+    ASSERT_TRUE(foo && bar && main) << "A record has no header " << layout;
+
+    // mov rax, imm32 and ret, twice, then two calls and a ret.
+    EXPECT_EQ(foo->VirtualSize, 8UL);
+    EXPECT_EQ(bar->VirtualSize, 8UL);
+    EXPECT_EQ(main->VirtualSize, 11UL);
+
+    EXPECT_EQ(bar->Offset, foo->Offset + foo->VirtualSize) << layout;
+    EXPECT_EQ(main->Offset, bar->Offset + bar->VirtualSize) << layout;
+
+    for (auto header : {foo, bar, main}) {
+      EXPECT_EQ(header->OffsetSize, header->VirtualSize) << header->Name;
+      EXPECT_EQ(header->VirtualAddress, kPefBaseOrigin + header->Offset) << header->Name;
+    }
+
+    CompilerKit::PEFContainer container{};
+    std::memcpy(&container, image.data(), sizeof(container));
+
+    EXPECT_EQ(container.Start, main->Offset) << "The entrypoint isn't its record " << layout;
+
+    ASSERT_LE(main->Offset + main->VirtualSize, image.size());
+    EXPECT_EQ(image[foo->Offset], 0x48) << "foo's header doesn't point at its code.";
+    EXPECT_EQ(image[main->Offset], 0xE8);
+    EXPECT_EQ(ld_test_branch_target(image, main->Offset), long(foo->Offset));
+    EXPECT_EQ(ld_test_branch_target(image, main->Offset + 5), long(bar->Offset));
+  }
+}
+
+TEST(LinkerTest, GCSectionsTest) {
+  auto expr = std::system("asm -asm:x64 sample/gc.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the gc unit.";
+
+  // mov rax, 5, the body of the function nothing calls.
+  const std::vector<unsigned char> kUnused = {0x48, 0xC7, 0xC0, 0x05, 0x00, 0x00, 0x00, 0xC3};
+
+  expr = std::system("ld64 -amd64 sample/gc.obj -start __NECTI_main -output gc.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the gc unit.";
+
+  auto image = ld_test_read("gc.exec");
+
+  EXPECT_TRUE(ld_test_has(ld_test_headers(image), ".code64$unused"));
+  EXPECT_NE(ld_test_find(image, kUnused), -1);
+
+  expr = std::system("ld64 -amd64 sample/gc.obj -start __NECTI_main -gc-sections -output gc.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the gc unit with -gc-sections.";
+
+  image        = ld_test_read("gc.exec");
+  auto headers = ld_test_headers(image);
+
+  EXPECT_FALSE(ld_test_has(headers, ".code64$unused")) << "The unreachable record was kept.";
+  EXPECT_EQ(ld_test_find(image, kUnused), -1) << "The unreachable record's bytes were kept.";
+
+  ASSERT_TRUE(ld_test_has(headers, ".code64$used"));
+  ASSERT_TRUE(ld_test_has(headers, ".code64$__NECTI_main"));
+
+  for (auto& header : headers) {
+    if (std::strcmp(header.Name, ".code64$__NECTI_main") != 0) continue;
+
+    // call used, the record the collector kept and moved down.
+    EXPECT_EQ(image[header.Offset], 0xE8);
+    EXPECT_EQ(image[ld_test_branch_target(image, header.Offset) + 3], 0x06);
+  }
+}
+
+TEST(LinkerTest, FoldIdenticalCodeTest) {
+  auto expr = std::system("asm -asm:x64 sample/icf.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the icf unit.";
+
+  const std::vector<unsigned char> kTwin = {0x48, 0xC7, 0xC0, 0x03, 0x00, 0x00, 0x00, 0xC3};
+
+  for (const char* mode : {"-icf", "-icf-safe"}) {
+    std::string command = "ld64 -amd64 sample/icf.obj -start __NECTI_main -output icf.exec ";
+    expr                = std::system((command + mode).c_str());
+    ASSERT_TRUE(expr == 0) << "Linker did not link the icf unit " << mode;
+
+    auto image   = ld_test_read("icf.exec");
+    auto headers = ld_test_headers(image);
+
+    const CompilerKit::PEFCommandHeader *twin = nullptr, *other = nullptr, *main = nullptr;
+
+    for (auto& header : headers) {
+      if (std::strcmp(header.Name, ".code64$twin") == 0) twin = &header;
+      if (std::strcmp(header.Name, ".code64$other_twin") == 0) other = &header;
+      if (std::strcmp(header.Name, ".code64$__NECTI_main") == 0) main = &header;
+    }
+
+    ASSERT_TRUE(twin && other && main) << "A folded symbol lost its header " << mode;
+
+    // one copy of the code, both symbols and both calls lead to it.
+    auto first = ld_test_find(image, kTwin);
+
+    ASSERT_NE(first, -1);
+    EXPECT_EQ(ld_test_find(image, kTwin, first + 1), -1) << "The twins weren't folded " << mode;
+
+    EXPECT_EQ(twin->Offset, other->Offset) << mode;
+    EXPECT_EQ(twin->VirtualAddress, other->VirtualAddress) << mode;
+    EXPECT_EQ(ld_test_branch_target(image, main->Offset), long(twin->Offset)) << mode;
+    EXPECT_EQ(ld_test_branch_target(image, main->Offset + 5), long(twin->Offset)) << mode;
+  }
+}
+
+TEST(LinkerTest, OrderFileTest) {
+  auto expr = std::system("asm -asm:x64 sample/multi.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the multi unit.";
+
+  {
+    std::ofstream order("multi.order");
+    order << "# hottest first\n__NECTI_main\nbar\n";
+  }
+
+  expr = std::system(
+      "ld64 -amd64 sample/multi.obj -start __NECTI_main -order-file multi.order -output "
+      "multi.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the multi unit with an order file.";
+
+  auto image   = ld_test_read("multi.exec");
+  auto headers = ld_test_headers(image);
+
+  const CompilerKit::PEFCommandHeader *foo = nullptr, *bar = nullptr, *main = nullptr;
+
+  for (auto& header : headers) {
+    if (std::strcmp(header.Name, ".code64$foo") == 0) foo = &header;
+    if (std::strcmp(header.Name, ".code64$bar") == 0) bar = &header;
+    if (std::strcmp(header.Name, ".code64$__NECTI_main") == 0) main = &header;
+  }
+
+  ASSERT_TRUE(foo && bar && main);
+
+  // the listed functions of the object first, in order, then the rest of it.
+  EXPECT_EQ(bar->Offset, main->Offset + main->VirtualSize);
+  EXPECT_EQ(foo->Offset, bar->Offset + bar->VirtualSize);
+
+  EXPECT_EQ(ld_test_branch_target(image, main->Offset), long(foo->Offset));
+  EXPECT_EQ(ld_test_branch_target(image, main->Offset + 5), long(bar->Offset));
+}
+
+TEST(LinkerTest, SplitDebugRunsTest) {
+  auto expr = std::system("asm -asm:x64 sample/multi.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the multi unit.";
+
+  expr = std::system("asm -asm:x64 sample/callee.masm");
+  EXPECT_TRUE(expr == 0) << "Assembler did not assemble the callee unit.";
+
+  // bar moves ahead of callee, the rest of multi follows it: multi makes two runs.
+  {
+    std::ofstream order("multi.order");
+    order << "bar\ncallee\n";
+  }
+
+  expr = std::system(
+      "ld64 -amd64 sample/multi.obj sample/callee.obj -start __NECTI_main -order-file multi.order "
+      "-split-debug -output multi.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the multi unit with -split-debug.";
+
+  auto image = ld_test_read("multi.exec");
+
+  std::vector<CompilerKit::PEFCommandHeader> runs;
+
+  for (auto& header : ld_test_headers(image)) {
+    if (std::strcmp(header.Name, ".code64") == 0) runs.push_back(header);
+  }
+
+  ASSERT_EQ(runs.size(), 3UL) << "Expected bar, callee, then foo and __NECTI_main.";
+
+  // an object's runs are listed together, put them in image order.
+  std::sort(runs.begin(), runs.end(), [](auto& lhs, auto& rhs) { return lhs.Offset < rhs.Offset; });
+
+  const std::vector<unsigned long> kSizes = {8UL, 8UL, 19UL};
+
+  for (std::size_t run = 0; run < runs.size(); ++run) {
+    EXPECT_EQ(runs[run].VirtualSize, kSizes[run]) << "run " << run;
+    EXPECT_EQ(runs[run].OffsetSize, kSizes[run]) << "run " << run;
+    EXPECT_EQ(runs[run].VirtualAddress, kPefBaseOrigin + runs[run].Offset) << "run " << run;
+
+    if (run > 0) {
+      EXPECT_EQ(runs[run].Offset, runs[run - 1].Offset + runs[run - 1].VirtualSize);
+    }
+  }
+
+  // mov rax, 2 opens bar's run, mov rax, 42 callee's, mov rax, 1 the rest of multi.
+  EXPECT_EQ(image[runs[0].Offset + 3], 2);
+  EXPECT_EQ(image[runs[1].Offset + 3], 42);
+  EXPECT_EQ(image[runs[2].Offset + 3], 1);
+
+  // the .dbg lists the same runs in image order, each named after its object.
+  auto debug = ld_test_read("multi.dbg");
+  long at    = -1;
+
+  for (auto& header : ld_test_headers(debug)) {
+    if (std::strcmp(header.Name, kPefDebugObjectsName) == 0) at = long(header.Offset);
+  }
+
+  ASSERT_NE(at, -1) << "The .dbg has no Container:Objects header.";
+
+  for (std::size_t run = 0; run < runs.size(); ++run) {
+    CompilerKit::PEFDebugObject object{};
+    std::memcpy(&object, debug.data() + at + run * sizeof(object), sizeof(object));
+
+    std::string name(reinterpret_cast<const char*>(debug.data()) + at +
+                         runs.size() * sizeof(object) + object.Name,
+                     object.NameLen);
+
+    EXPECT_EQ(object.Offset, runs[run].Offset) << "run " << run;
+    EXPECT_EQ(object.Size, runs[run].VirtualSize) << "run " << run;
+    EXPECT_EQ(name, run == 1 ? "sample/callee.obj" : "sample/multi.obj") << "run " << run;
+  }
+}
+
+TEST(LinkerTest, LibraryMemberTest) {
+  for (const char* unit : {"caller", "callee", "spare", "multi"}) {
+    auto expr = std::system((std::string("asm -asm:x64 sample/") + unit + ".masm").c_str());
+    EXPECT_TRUE(expr == 0) << "Assembler did not assemble the " << unit << " unit.";
+  }
+
+  auto expr = std::system("ar64 -output members.lib sample/callee.obj sample/spare.obj");
+  ASSERT_TRUE(expr == 0) << "Archiver did not write the library.";
+
+  // caller leaves callee undefined, only the member defining it comes in.
+  expr = std::system(
+      "ld64 -amd64 sample/caller.obj members.lib -start __NECTI_main -output members.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link against the library.";
+
+  auto image   = ld_test_read("members.exec");
+  auto headers = ld_test_headers(image);
+
+  EXPECT_TRUE(ld_test_has(headers, ".code64$callee")) << "The member defining callee is missing.";
+  EXPECT_FALSE(ld_test_has(headers, ".code64$spare")) << "A member nothing needs was linked.";
+
+  // mov rax, 42 is callee's, mov rax, 7 spare's.
+  EXPECT_NE(ld_test_find(image, {0x48, 0xC7, 0xC0, 0x2A, 0x00, 0x00, 0x00, 0xC3}), -1);
+  EXPECT_EQ(ld_test_find(image, {0x48, 0xC7, 0xC0, 0x07, 0x00, 0x00, 0x00, 0xC3}), -1);
+
+  // nothing undefined, nothing pulled.
+  expr = std::system(
+      "ld64 -amd64 sample/multi.obj members.lib -start __NECTI_main -output members.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the multi unit against the library.";
+
+  headers = ld_test_headers(ld_test_read("members.exec"));
+
+  EXPECT_TRUE(ld_test_has(headers, ".code64$foo"));
+  EXPECT_FALSE(ld_test_has(headers, ".code64$callee"));
+  EXPECT_FALSE(ld_test_has(headers, ".code64$spare"));
+}
+
+TEST(LinkerTest, ImportStubsTest) {
+  ASSERT_TRUE(ld_test_write_import("import.obj")) << "Could not write the import object.";
+
+  for (bool bind_now : {false, true}) {
+    std::string command = "ld64 -amd64 import.obj -start __NECTI_main -output import.exec";
+
+    if (bind_now) command += " -bind-now";
+
+    ASSERT_TRUE(std::system(command.c_str()) == 0) << "Linker did not link the import object.";
+
+    auto image = ld_test_read("import.exec");
+    long main = -1, table = -1;
+
+    for (auto& header : ld_test_headers(image)) {
+      if (std::strcmp(header.Name, ".code64$__NECTI_main") == 0) main = long(header.Offset);
+      if (std::strcmp(header.Name, kPefImportsName) == 0) table = long(header.Offset);
+    }
+
+    ASSERT_NE(main, -1) << "The image has no entrypoint header.";
+    ASSERT_NE(table, -1) << "The image has no Container:Imports header.";
+
+    CompilerKit::PEFImportTable imports{};
+    std::memcpy(&imports, image.data() + table, sizeof(imports));
+
+    ASSERT_EQ(imports.Count, 1U);
+    EXPECT_EQ(imports.Flags, bind_now ? UInt32(CompilerKit::kPefImportEager) : 0U);
+
+    CompilerKit::PEFImport import{};
+    std::memcpy(&import, image.data() + table + sizeof(imports), sizeof(import));
+
+    ASSERT_LE(import.Stub + 16, image.size());
+    ASSERT_LE(import.Pointer + sizeof(std::uint64_t), image.size());
+
+    // the call goes through the stub, whatever the binding.
+    EXPECT_EQ(ld_test_branch_target(image, main), long(import.Stub));
+
+    // jmp [rip + pointer], push index, jmp binder.
+    long stub = long(import.Stub);
+
+    EXPECT_EQ(image[stub], 0xFF);
+    EXPECT_EQ(image[stub + 1], 0x25);
+    EXPECT_EQ(image[stub + 6], 0x68);
+    EXPECT_EQ(image[stub + 11], 0xE9);
+
+    std::int32_t rel32 = 0;
+    std::memcpy(&rel32, image.data() + stub + 2, sizeof(rel32));
+    EXPECT_EQ(stub + 6 + rel32, long(import.Pointer));
+
+    std::int32_t index = -1;
+    std::memcpy(&index, image.data() + stub + 7, sizeof(index));
+    EXPECT_EQ(index, 0);
+
+    // a lazy pointer starts at the push, an eager one is left to the loader.
+    std::uint64_t pointer = ~0ULL;
+    std::memcpy(&pointer, image.data() + import.Pointer, sizeof(pointer));
+
+    EXPECT_EQ(pointer, bind_now ? 0ULL : std::uint64_t(kPefBaseOrigin + import.Stub + 6));
+  }
+}
+
+TEST(LinkerTest, SharedImportTest) {
+  ASSERT_TRUE(ld_test_write_import("import.obj"));
+  ASSERT_TRUE(ld_test_write_import("import2.obj", "other"));
+
+  // both objects import puts, they share its import, stub and pointer.
+  auto expr = std::system(
+      "ld64 -amd64 import.obj import2.obj -start __NECTI_main -output import.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link two objects importing the same symbol.";
+
+  auto image = ld_test_read("import.exec");
+  long main = -1, other = -1, table = -1;
+
+  for (auto& header : ld_test_headers(image)) {
+    if (std::strcmp(header.Name, ".code64$__NECTI_main") == 0) main = long(header.Offset);
+    if (std::strcmp(header.Name, ".code64$other") == 0) other = long(header.Offset);
+    if (std::strcmp(header.Name, kPefImportsName) == 0) table = long(header.Offset);
+  }
+
+  ASSERT_NE(main, -1);
+  ASSERT_NE(other, -1);
+  ASSERT_NE(table, -1) << "The image has no Container:Imports header.";
+
+  CompilerKit::PEFImportTable imports{};
+  std::memcpy(&imports, image.data() + table, sizeof(imports));
+
+  ASSERT_EQ(imports.Count, 1U);
+
+  CompilerKit::PEFImport import{};
+  std::memcpy(&import, image.data() + table + sizeof(imports), sizeof(import));
+
+  EXPECT_EQ(ld_test_branch_target(image, main), long(import.Stub));
+  EXPECT_EQ(ld_test_branch_target(image, other), long(import.Stub));
+
+  // the import outlives the first object's code when that one is collected.
+  expr = std::system("ld64 -amd64 -gc-sections import2.obj import.obj -start __NECTI_main "
+                     "-output import.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not collect the object nothing calls.";
+
+  image = ld_test_read("import.exec");
+  main = table = -1;
+
+  for (auto& header : ld_test_headers(image)) {
+    EXPECT_STRNE(header.Name, ".code64$other");
+
+    if (std::strcmp(header.Name, ".code64$__NECTI_main") == 0) main = long(header.Offset);
+    if (std::strcmp(header.Name, kPefImportsName) == 0) table = long(header.Offset);
+  }
+
+  ASSERT_NE(main, -1);
+  ASSERT_NE(table, -1) << "The import was dropped with the first object importing it.";
+
+  std::memcpy(&imports, image.data() + table, sizeof(imports));
+  std::memcpy(&import, image.data() + table + sizeof(imports), sizeof(import));
+
+  ASSERT_EQ(imports.Count, 1U);
+  EXPECT_EQ(ld_test_branch_target(image, main), long(import.Stub));
+}
+
+TEST(LinkerTest, LZRoundTripTest) {
+  std::vector<std::vector<char>> blocks;
+
+  // shorter than a match, then at the edge of the last literals.
+  for (std::size_t size : {1, 4, 12, 13, 17}) blocks.emplace_back(size, 'a');
+
+  // a short period, noise, noise repeated close by, then from farther than kLZMaxOffset.
+  std::vector<char> period(65536);
+  for (std::size_t index = 0; index < period.size(); ++index) period[index] = char(index % 7);
+
+  std::vector<char> noise(100000);
+  std::uint32_t     seed = 0x12345678;
+
+  for (auto& byte : noise) {
+    seed = seed * 1664525U + 1013904223U;
+    byte = char(seed >> 24);
+  }
+
+  std::vector<char> near(noise.begin(), noise.begin() + 30000);
+  near.insert(near.end(), near.begin(), near.end());
+
+  std::vector<char> far(noise);
+  far.insert(far.end(), noise.begin(), noise.end());
+
+  blocks.insert(blocks.end(), {period, noise, near, far});
+
+  std::vector<std::size_t> sizes;
+
+  for (auto& block : blocks) {
+    std::vector<char> packed(CompilerKit::Utils::lz_compress_bound(block.size()));
+
+    auto size = CompilerKit::Utils::lz_compress(block.data(), block.size(), packed.data(),
+                                                packed.size());
+    ASSERT_NE(size, 0UL) << "block of " << block.size() << " bytes";
+
+    sizes.push_back(size);
+
+    std::vector<char> expanded(block.size());
+    ASSERT_TRUE(CompilerKit::Utils::lz_decompress(packed.data(), size, expanded.data(),
+                                                  expanded.size()))
+        << "block of " << block.size() << " bytes";
+    EXPECT_TRUE(expanded == block) << "block of " << block.size() << " bytes";
+
+    // a block expands to its exact size only, and a truncated one is refused.
+    EXPECT_FALSE(CompilerKit::Utils::lz_decompress(packed.data(), size, expanded.data(),
+                                                   expanded.size() - 1));
+    EXPECT_FALSE(CompilerKit::Utils::lz_decompress(packed.data(), size - 1, expanded.data(),
+                                                   expanded.size()));
+  }
+
+  // the period and the noise seen twice shrink, the noise doesn't.
+  EXPECT_LT(sizes[5], period.size() / 100);
+  EXPECT_GE(sizes[6], noise.size());
+  EXPECT_LT(sizes[7], near.size() / 2 + 1024);
+}
+
+TEST(LinkerTest, CompressedImageTest) {
+  // the unit is generated next to the images, not in the samples.
+  {
+    std::ofstream unit("repeat.masm");
+
+    unit << "#bits 64\n\npublic_segment .code64 __NECTI_main\n";
+
+    // the same instruction over and over, so the code shrinks.
+    for (int index = 0; index < 512; ++index) unit << "  mov rax, 1\n";
+
+    unit << "  ret\n";
+  }
+
+  auto expr = std::system("asm -asm:x64 repeat.masm");
+  ASSERT_TRUE(expr == 0) << "Assembler did not assemble the repeat unit.";
+
+  expr = std::system("ld64 -amd64 repeat.obj -start __NECTI_main -output plain.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the repeat unit.";
+
+  expr = std::system("ld64 -amd64 -compress repeat.obj -start __NECTI_main -output packed.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the repeat unit compressed.";
+
+  auto plain  = ld_test_read("plain.exec");
+  auto packed = ld_test_read("packed.exec");
+
+  std::span<const char> file(reinterpret_cast<const char*>(packed.data()), packed.size());
+
+  ASSERT_FALSE(CompilerKit::Utils::pef_compressed_ranges(file).empty())
+      << "The code was stored as it is.";
+  EXPECT_LT(packed.size(), plain.size());
+
+  std::vector<char> expanded;
+  ASSERT_TRUE(CompilerKit::Utils::pef_expand(file, expanded));
+
+  // the headers point into the expansion, where the code is what the plain image holds.
+  auto main_of = [](const std::vector<CompilerKit::PEFCommandHeader>& headers) {
+    auto it = std::find_if(headers.begin(), headers.end(), [](auto& header) {
+      return std::strcmp(header.Name, ".code64$__NECTI_main") == 0;
+    });
+
+    return it == headers.end() ? CompilerKit::PEFCommandHeader{} : *it;
+  };
+
+  auto plain_main  = main_of(ld_test_headers(plain));
+  auto packed_main = main_of(ld_test_headers(packed));
+
+  ASSERT_EQ(packed_main.VirtualSize, 512U * 7U + 1U);
+  ASSERT_EQ(plain_main.VirtualSize, packed_main.VirtualSize);
+  EXPECT_TRUE(packed_main.Flags & CompilerKit::kPefFlagCompressed);
+  ASSERT_LE(packed_main.Offset + packed_main.VirtualSize, expanded.size());
+
+  EXPECT_EQ(std::memcmp(plain.data() + plain_main.Offset, expanded.data() + packed_main.Offset,
+                        plain_main.VirtualSize),
+            0);
+
+  // an image without ranges expands to itself.
+  std::span<const char> plain_file(reinterpret_cast<const char*>(plain.data()), plain.size());
+  ASSERT_TRUE(CompilerKit::Utils::pef_expand(plain_file, expanded));
+  ASSERT_EQ(expanded.size(), plain.size());
+  EXPECT_EQ(std::memcmp(plain.data(), expanded.data(), plain.size()), 0);
+}
+
+TEST(LinkerTest, InMemoryLinkTest) {
+  for (const char* unit : {"caller", "callee"}) {
+    auto expr = std::system((std::string("asm -asm:x64 sample/") + unit + ".masm").c_str());
+    EXPECT_TRUE(expr == 0) << "Assembler did not assemble the " << unit << " unit.";
+  }
+
+  auto expr = std::system("ld64 -amd64 -reproducible -split-debug sample/caller.obj "
+                          "sample/callee.obj -start __NECTI_main -output memory.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the objects on disk.";
+
+  // the same objects, handed to the library as bytes, linked without touching the disk.
+  std::vector<std::vector<char>> objects;
+
+  CompilerKit::LinkerOptions options;
+
+  options.fOutput       = "";
+  options.fStart        = "__NECTI_main";
+  options.fArch         = CompilerKit::kPefArchAMD64;
+  options.fReproducible = true;
+  options.fSplitDebug   = true;
+
+  const char* paths[] = {"sample/caller.obj", "sample/callee.obj"};
+
+  for (const char* path : paths) {
+    auto bytes = ld_test_read(path);
+    objects.emplace_back(bytes.begin(), bytes.end());
+  }
+
+  // the inputs keep their paths, the .dbg names its objects after them.
+  for (std::size_t index = 0; index < objects.size(); ++index)
+    options.fInputs.push_back({.fPath = paths[index], .fBytes = objects[index], .fLibrary = false});
+
+  CompilerKit::Linker linker(options);
+  ASSERT_EQ(linker.Link(), NECTI_SUCCESS) << "Linker did not link the objects in memory.";
+
+  auto image = ld_test_read("memory.exec");
+  auto debug = ld_test_read("memory.dbg");
+
+  ASSERT_EQ(linker.Image().size(), image.size());
+  EXPECT_EQ(std::memcmp(linker.Image().data(), image.data(), image.size()), 0);
+
+  ASSERT_EQ(linker.DebugImage().size(), debug.size());
+  EXPECT_EQ(std::memcmp(linker.DebugImage().data(), debug.data(), debug.size()), 0);
+}
+
+TEST(LinkerTest, FatImageTest) {
+  for (const char* unit : {"caller", "callee"}) {
+    auto expr = std::system((std::string("asm -asm:x64 sample/") + unit + ".masm").c_str());
+    EXPECT_TRUE(expr == 0) << "Assembler did not assemble the " << unit << " unit.";
+  }
+
+  auto expr = std::system("asm -asm:power64 sample/power.masm");
+  ASSERT_TRUE(expr == 0) << "Assembler did not assemble the power unit.";
+
+  expr = std::system("ld64 -fat -reproducible sample/caller.obj sample/callee.obj "
+                     "sample/power.obj -start __NECTI_main -output fat.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the FAT image.";
+
+  expr = std::system("ld64 -amd64 -reproducible sample/caller.obj sample/callee.obj "
+                     "-start __NECTI_main -output fat-amd64.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the AMD64 image.";
+
+  expr = std::system(
+      "ld64 -power64 -reproducible sample/power.obj -start __NECTI_main -output fat-power.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the POWER image.";
+
+  auto image = ld_test_read("fat.exec");
+
+  CompilerKit::PEFContainer container{};
+  ASSERT_GE(image.size(), sizeof(container));
+  std::memcpy(&container, image.data(), sizeof(container));
+
+  EXPECT_EQ(std::memcmp(container.Magic, kPefMagicFat, kPefMagicLen), 0);
+  ASSERT_EQ(container.Count, 2U);
+
+  std::vector<CompilerKit::PEFFatSlice> directory(container.Count);
+  std::memcpy(directory.data(), image.data() + sizeof(container),
+              directory.size() * sizeof(directory[0]));
+
+  // a slice per architecture, in the order of the objects, each a whole image on its own page.
+  const std::pair<std::uint32_t, const char*> slices[] = {
+      {CompilerKit::kPefArchAMD64, "fat-amd64.exec"},
+      {CompilerKit::kPefArchPowerPC, "fat-power.exec"},
+  };
+
+  std::size_t end = sizeof(container) + directory.size() * sizeof(directory[0]);
+
+  for (std::size_t slice = 0; slice < directory.size(); ++slice) {
+    auto& entry = directory[slice];
+    auto  plain = ld_test_read(slices[slice].second);
+
+    EXPECT_EQ(entry.Cpu, slices[slice].first) << "slice " << slice;
+    EXPECT_EQ(entry.Offset % kPefPageSize, 0U) << "slice " << slice;
+    EXPECT_GE(entry.Offset, end) << "slice " << slice;
+
+    ASSERT_LE(entry.Offset + entry.Size, image.size()) << "slice " << slice;
+    ASSERT_EQ(entry.Size, plain.size()) << "slice " << slice;
+
+    EXPECT_TRUE(std::equal(plain.begin(), plain.end(), image.begin() + entry.Offset))
+        << "slice " << slice << " differs from the plain link of its architecture.";
+
+    end = entry.Offset + entry.Size;
+  }
+
+  EXPECT_EQ(end, image.size());
+}
+
+TEST(LinkerTest, RecordOutOfRangeTest) {
+  // a v1 object, whose records only say where they end, with its only record ending past the
+  // code. v2 records are checked against their section when the object is opened.
+  {
+    CompilerKit::AEHeader       hdr{};
+    CompilerKit::AERecordHeader record{};
+    const char                  code[] = {char(0xC3)};
+
+    hdr.fMagic[0]  = kAEMag0;
+    hdr.fMagic[1]  = kAEMag1;
+    hdr.fVersion   = kAEVer1;
+    hdr.fSize      = CompilerKit::kAEHeaderV1Size;
+    hdr.fArch      = CompilerKit::kPefArchAMD64;
+    hdr.fCount     = 1;
+    hdr.fStartCode = CompilerKit::kAEHeaderV1Size + sizeof(record);
+    hdr.fCodeSize  = sizeof(code);
+
+    std::strcpy(record.fName, ".code64$callee");
+    record.fKind = CompilerKit::kPefCode;
+    record.fSize = sizeof(code) + 1;
+
+    std::ofstream out("bad.obj", std::ios::binary);
+
+    out.write(reinterpret_cast<const char*>(&hdr), CompilerKit::kAEHeaderV1Size);
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    out.write(code, sizeof(code));
+  }
+
+  auto expr = std::system("ld64 -amd64 bad.obj -start callee -output bad.exec > bad.log");
+  EXPECT_FALSE(expr == 0) << "Linker linked a record lying outside the code.";
+
+  auto        log = ld_test_read("bad.log");
+  std::string message(log.begin(), log.end());
+
+  EXPECT_NE(message.find("record .code64$callee lies outside the code of: bad.obj"),
+            std::string::npos)
+      << message;
+  EXPECT_EQ(message.find("bad relocation"), std::string::npos) << message;
+}
+
+TEST(LinkerTest, ChecksumTest) {
+  // the CRC32C check value, then a block cut at every length and alignment around a word.
+  const char kCheck[] = "123456789";
+  EXPECT_EQ(CompilerKit::Utils::crc32c(0U, kCheck, 9), 0xE3069283U);
+
+  std::vector<unsigned char> block(4096 + 15);
+  std::uint32_t              seed = 0x9E3779B9;
+
+  for (auto& byte : block) {
+    seed = seed * 1664525U + 1013904223U;
+    byte = static_cast<unsigned char>(seed >> 24);
+  }
+
+  for (std::size_t from = 0; from < 8; ++from) {
+    for (std::size_t size : {0, 1, 7, 8, 9, 63, 4096}) {
+      auto portable = CompilerKit::Utils::Detail::crc32c_portable(~0U, block.data() + from, size);
+
+      if (CompilerKit::Utils::Detail::crc32c_has_hardware()) {
+        EXPECT_EQ(CompilerKit::Utils::Detail::crc32c_hardware(~0U, block.data() + from, size),
+                  portable)
+            << size << " byte(s) at " << from;
+      }
+
+      // a CRC carried over two halves is the CRC of the whole.
+      auto half = CompilerKit::Utils::crc32c(0U, block.data() + from, size / 2);
+
+      EXPECT_EQ(CompilerKit::Utils::crc32c(half, block.data() + from + size / 2, size - size / 2),
+                ~portable)
+          << size << " byte(s) at " << from;
+    }
+  }
+
+  // ld64 stores the image's checksum, and any flipped byte breaks it.
+  auto expr = std::system(
+      "ld64 -amd64 sample/sample.cc.pp.obj -start __NECTI_main -output checksum.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the easy object.";
+
+  auto              image = ld_test_read("checksum.exec");
+  std::vector<char> bytes(image.begin(), image.end());
+
+  CompilerKit::PEFContainer container{};
+  ASSERT_GE(bytes.size(), sizeof(container));
+  std::memcpy(&container, bytes.data(), sizeof(container));
+
+  EXPECT_NE(container.Checksum, 0U);
+  EXPECT_TRUE(CompilerKit::Utils::pef_verify_checksum(bytes));
+
+  bytes.back() ^= 1;
+  EXPECT_FALSE(CompilerKit::Utils::pef_verify_checksum(bytes));
+}
+
+TEST(LinkerTest, PageAlignTest) {
+  // code, data then zero-fill, the assembler has no syntax for data.
+  std::vector<unsigned char> code = {0x48, 0xC7, 0xC0, 0x01, 0x00, 0x00, 0x00, 0xC3};
+
+  code.insert(code.end(), {42, 0, 0, 0, 0, 0, 0, 0});
+  code.insert(code.end(), 16, 0);
+
+  ASSERT_TRUE(ld_test_write_object(
+      "segments.obj",
+      {ld_test_record(".code64$__NECTI_main", CompilerKit::kPefCode, 0, 8),
+       ld_test_record(".data64$answer", CompilerKit::kPefData, 8, 8),
+       ld_test_record(".zero64$scratch", CompilerKit::kPefZero, 16, 16)},
+      code));
+
+  for (std::uint64_t page : {4096, 16384}) {
+    auto command = "ld64 -amd64 -page-size " + std::to_string(page) +
+                   " segments.obj -start __NECTI_main -output segments.exec";
+
+    ASSERT_TRUE(std::system(command.c_str()) == 0) << "Linker did not link with pages of " << page;
+
+    auto image   = ld_test_read("segments.exec");
+    auto headers = ld_test_headers(image);
+
+    const std::pair<const char*, std::uint32_t> kSegments[] = {
+        {".code64$__NECTI_main", CompilerKit::kPefFlagRead | CompilerKit::kPefFlagExec},
+        {".data64$answer", CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite},
+        {".zero64$scratch", CompilerKit::kPefFlagRead | CompilerKit::kPefFlagWrite |
+                                CompilerKit::kPefFlagZeroFill},
+    };
+
+    std::vector<CompilerKit::PEFCommandHeader> segments;
+
+    for (auto [name, flags] : kSegments) {
+      auto it = std::find_if(headers.begin(), headers.end(),
+                             [&](auto& header) { return std::strcmp(header.Name, name) == 0; });
+
+      ASSERT_NE(it, headers.end()) << name;
+
+      // every segment starts on its own page, mapped where its file offset says.
+      EXPECT_EQ(it->Offset % page, 0U) << name << ", pages of " << page;
+      EXPECT_EQ(it->VirtualAddress, kPefBaseOrigin + it->Offset) << name;
+      EXPECT_EQ(it->Flags & flags, flags) << name;
+
+      segments.push_back(*it);
+    }
+
+    EXPECT_LT(segments[0].Offset, segments[1].Offset);
+    EXPECT_LT(segments[1].Offset, segments[2].Offset);
+
+    // code and data are in the file, zero-fill isn't.
+    ASSERT_LE(segments[1].Offset + 8, image.size());
+    EXPECT_EQ(std::memcmp(image.data() + segments[0].Offset, code.data(), 8), 0);
+    EXPECT_EQ(image[segments[1].Offset], 42);
+
+    EXPECT_EQ(segments[2].OffsetSize, 0U);
+    EXPECT_EQ(segments[2].VirtualSize, 16U);
+    EXPECT_LE(image.size(), segments[2].Offset);
+  }
+}
+
+TEST(LinkerTest, StreamLinkTest) {
+  for (const char* unit : {"caller", "callee", "multi"}) {
+    auto expr = std::system((std::string("asm -asm:x64 sample/") + unit + ".masm").c_str());
+    EXPECT_TRUE(expr == 0) << "Assembler did not assemble the " << unit << " unit.";
+  }
+
+  // objects with fixups give the same image, copied from their files or read into memory.
+  for (std::string extra : {"", "-page-align", "-split-debug", "-compress", "-gc-sections"}) {
+    std::string link = "ld64 -amd64 -reproducible " + extra +
+                       " sample/caller.obj sample/callee.obj -start __NECTI_main -output ";
+
+    auto expr = std::system((link + "copied.exec").c_str());
+    ASSERT_TRUE(expr == 0) << "Linker did not link with " << extra;
+
+    expr = std::system((link + "streamed.exec -stream").c_str());
+    ASSERT_TRUE(expr == 0) << "Linker did not stream the link with " << extra;
+
+    expr = std::system("cmp -s copied.exec streamed.exec");
+    EXPECT_TRUE(expr == 0) << "-stream changes the image linked with " << extra;
+
+    if (extra == "-split-debug") {
+      expr = std::system("cmp -s copied.dbg streamed.dbg");
+      EXPECT_TRUE(expr == 0) << "-stream changes the .dbg.";
+    }
+  }
+
+  // split objects are streamed a range at a time, out of order here.
+  std::ofstream("stream.order") << "bar\n__NECTI_main\n";
+
+  auto expr = std::system("ld64 -amd64 -reproducible -order-file stream.order sample/multi.obj "
+                          "-start __NECTI_main -output copied.exec");
+  ASSERT_TRUE(expr == 0);
+
+  expr = std::system("ld64 -amd64 -reproducible -order-file stream.order -stream "
+                     "sample/multi.obj -start __NECTI_main -output streamed.exec");
+  ASSERT_TRUE(expr == 0);
+
+  expr = std::system("cmp -s copied.exec streamed.exec");
+  EXPECT_TRUE(expr == 0) << "-stream changes the image of a split object.";
+}
+
+TEST(LinkerTest, DumpTest) {
+  for (const char* unit : {"caller", "callee", "spare", "multi"}) {
+    auto expr = std::system((std::string("asm -asm:x64 sample/") + unit + ".masm").c_str());
+    EXPECT_TRUE(expr == 0) << "Assembler did not assemble the " << unit << " unit.";
+  }
+
+  auto expr = std::system("ar64 -output dump.lib sample/callee.obj sample/spare.obj");
+  ASSERT_TRUE(expr == 0) << "Archiver did not write the library.";
+
+  expr = std::system("ld64 -amd64 -reproducible sample/caller.obj sample/callee.obj "
+                     "-start __NECTI_main -output dump.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the caller and callee.";
+
+  expr = std::system(
+      "ld64 -amd64 -reproducible sample/multi.obj -start __NECTI_main -output dump-multi.exec");
+  ASSERT_TRUE(expr == 0) << "Linker did not link the multi unit.";
+
+  // an object lists its records, what it defines and what it leaves undefined.
+  auto object = ld_test_output("dump64 sample/caller.obj");
+
+  EXPECT_NE(object.find("sample/caller.obj: ae object"), std::string::npos) << object;
+  EXPECT_NE(object.find("3 relocation(s)"), std::string::npos) << object;
+  EXPECT_NE(object.find("D         16 .code64$__NECTI_main"), std::string::npos) << object;
+  EXPECT_NE(object.find("U            14:UndefinedSymbol:.code64$callee"), std::string::npos)
+      << object;
+
+  // a library lists its members after itself.
+  auto library = ld_test_output("dump64 -symbols dump.lib");
+
+  EXPECT_NE(library.find("dump.lib: lib library"), std::string::npos) << library;
+  EXPECT_NE(library.find("2 member(s)"), std::string::npos) << library;
+  EXPECT_NE(library.find("D          8 .code64$callee"), std::string::npos) << library;
+  EXPECT_NE(library.find("D          8 .code64$spare"), std::string::npos) << library;
+
+  // an image, as JSON: 16 bytes of caller and 8 of callee.
+  auto image = ld_test_output("dump64 -json dump.exec");
+
+  EXPECT_EQ(image.rfind("[{\"name\":\"dump.exec\",\"format\":\"pef\"", 0), 0U) << image;
+  EXPECT_NE(image.find("\"code\":24,"), std::string::npos) << image;
+  EXPECT_NE(image.find("{\"name\":\".code64$callee\",\"size\":8}"), std::string::npos) << image;
+
+  // and two images, by size class then by symbol.
+  auto diff = ld_test_output("dump64 -diff dump.exec dump-multi.exec");
+
+  EXPECT_NE(diff.find("removed          -8 .code64$callee"), std::string::npos) << diff;
+  EXPECT_NE(diff.find("added            +8 .code64$foo"), std::string::npos) << diff;
+  EXPECT_NE(diff.find("resized          -5 .code64$__NECTI_main"), std::string::npos) << diff;
+
+  EXPECT_TRUE(ld_test_output("dump64 no-such.exec").empty());
+}
+
+TEST(LinkerTest, PowerOpcodeLookupTest) {
+  // the table used to be scanned from the start, the first entry of a mnemonic won.
+  auto linear_scan = [](std::string_view mnemonic) -> const CpuOpcodePPC* {
+    for (std::size_t at = 0; at < kOpcodePPCCount; ++at)
+      if (kOpcodesPowerPC[at].name == mnemonic) return &kOpcodesPowerPC[at];
+
+    return nullptr;
+  };
+
+  for (std::size_t at = 0; at < kOpcodePPCCount; ++at) {
+    std::string_view name = kOpcodesPowerPC[at].name;
+    auto             found = asm_power64_find_opcode(name);
+
+    ASSERT_EQ(found.size(), 1UL) << "Mnemonic " << name << " is not indexed.";
+    EXPECT_EQ(&found.front(), linear_scan(name)) << "Mnemonic " << name;
+  }
+
+  // mnemonics match exactly, addic. is its own, and the end of table marker is no mnemonic.
+  ASSERT_EQ(asm_power64_find_opcode("addic.").size(), 1UL);
+  ASSERT_EQ(asm_power64_find_opcode("addic").size(), 1UL);
+  EXPECT_NE(asm_power64_find_opcode("addic.").front().opcode,
+            asm_power64_find_opcode("addic").front().opcode);
+
+  for (std::string_view mnemonic : {"", "frob", "ad", "addic..", "LI", "blr."})
+    EXPECT_TRUE(asm_power64_find_opcode(mnemonic).empty()) << "Mnemonic " << mnemonic;
+
+  // lines without a mnemonic, like #bits, emit nothing, so the unit is two words of code.
+  std::ofstream("power-lookup.masm") << "#bits 64\n\npublic_segment .code64 __NECTI_main\n"
+                                        "  li r3, 0\n  blr\n";
+
+  auto expr = std::system("asm -asm:power64 power-lookup.masm");
+  ASSERT_TRUE(expr == 0) << "Assembler did not assemble the power unit.";
+
+  auto object = ld_test_read("power-lookup.obj");
+
+  CompilerKit::AEHeader hdr{};
+  ASSERT_GE(object.size(), sizeof(hdr));
+  std::memcpy(&hdr, object.data(), sizeof(hdr));
+
+  ASSERT_EQ(hdr.fCodeSize, 8U);
+  ASSERT_LE(hdr.fStartCode + hdr.fCodeSize, object.size());
+
+  std::uint32_t words[2]{};
+  std::memcpy(words, object.data() + hdr.fStartCode, sizeof(words));
+
+  EXPECT_EQ(words[0], asm_power64_find_opcode("li").front().opcode | 3U << 21);
+  EXPECT_EQ(words[1], asm_power64_find_opcode("blr").front().opcode);
+}
@@ -0,0 +1,16 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#include <CompilerKit/Defines.h>
+
+/// @file ar64.cc
+/// @brief NE static library archiver for AE objects.
+
+CK_IMPORT_C int StaticArchiver64PEF(int argc, char const* argv[]);
+
+int main(int argc, char const* argv[]) {
+  return StaticArchiver64PEF(argc, argv);
+}
@@ -0,0 +1,16 @@
+/* -------------------------------------------
+
+  Copyright (C) 2025 Amlal EL Mahrouss, all rights reserved
+
+------------------------------------------- */
+
+#include <CompilerKit/Defines.h>
+
+/// @file dump64.cc
+/// @brief NE object dumper for AE objects, static libraries and PEF images.
+
+CK_IMPORT_C int ObjectDumper64PEF(int argc, char const* argv[]);
+
+int main(int argc, char const* argv[]) {
+  return ObjectDumper64PEF(argc, argv);
+}